@@ -1,6 +1,18 @@
+#ifndef _CONTROLLER_INFO_BLOCK
+#define _CONTROLLER_INFO_BLOCK
+
 // Serial info.
 const long BAUD_RATE         = 9600;
 const int  CONFIRMATION_BYTE = 0x0A; // Newline.
 
 // Button info.
 const int  NUM_BUTTONS = 5;
+
+// Button i is pressed when bit i of a state byte is set.
+inline void decodeButtons(unsigned char byte, bool states[NUM_BUTTONS])
+{
+    for (int i = 0; i < NUM_BUTTONS; i++)
+        states[i] = (byte >> i) & 0x01;
+}
+
+#endif
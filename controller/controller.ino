@@ -4,6 +4,34 @@
 const int pins[NUM_BUTTONS] = {2,4,6,8,12};
 byte      states;
 
+#if defined(__AVR_ATmega328P__)
+/* On the Uno and Nano, pins 2, 4 and 6 are bits 2, 4 and 6
+of port D, and pins 8 and 12 are bits 0 and 4 of port B, so
+both ports are read once and the bits moved into place.
+The pull-ups make a pressed button read 0. */
+inline byte scanButtons()
+{
+    byte d = ~PIND;
+    byte b = ~PINB;
+    return ((d >> 2) & 0x01)
+         | ((d >> 3) & 0x02)
+         | ((d >> 4) & 0x04)
+         | ((b << 3) & 0x08)
+         |  (b       & 0x10);
+}
+#else
+// Other boards map the pins to other ports.
+inline byte scanButtons()
+{
+    byte s = 0;
+    for (int i = 0; i < NUM_BUTTONS; i++)
+    {
+        s |= (digitalRead(pins[i]) ? 0 : 1) << i;
+    }
+    return s;
+}
+#endif
+
 void setup()
 {
     // Button setup.
@@ -21,29 +49,39 @@ void setup()
     while (!Serial);
 }
 
+// Time, in us, of the last scan.
+unsigned long scannedAt;
+// Buttons seen pressed since the last state was written.
+byte          held;
+
+void scan()
+{
+    states    = scanButtons();
+    held     |= states;
+    scannedAt = micros();
+}
+
 // Time of the last input.
-long lastInput;
-// Time, in ms, that the LED stays on after an input.
-long keepAlive = 1000;
+unsigned long lastInput;
+// Time, in us, that the LED stays on after an input.
+unsigned long keepAlive = 1000000;
 
 void loop()
 {
-    // Read button states.
-    states = 0;
-    for (int i = 0; i < NUM_BUTTONS; i++)
-    {
-        states += (digitalRead(pins[i]) ? 0 : 1) << i;
-    }
-
-    // Writes state.
-    Serial.write(states);
+    /* Writes the buttons as they are now, along with any
+    pressed and let go while waiting for the last confirmation,
+    so short presses aren't missed. */
+    scan();
+    Serial.write(held);
+    held = 0;
 
-    // Waits for confirmation.
-    lastInput = millis();
+    // Waits for confirmation, scanning the buttons all the while.
+    lastInput = scannedAt;
     while (Serial.read() != CONFIRMATION_BYTE)
     {
+        scan();
         // Disables LED after some time without inputs.
-        if (millis() - lastInput > keepAlive)
+        if (scannedAt - lastInput > keepAlive)
         {
             digitalWrite(LED_BUILTIN, LOW);
         }
@@ -0,0 +1,79 @@
+#include <algorithm>
+#include <cmath>
+
+#include "AI.hpp"
+
+using namespace AI;
+using Board::Ball;
+
+Controller::Controller(const Board::Config& config, Ball::Players _side, const Difficulty& difficulty, uint32_t seed)
+    : side(_side), size(config.size)
+{
+    up   = 1 << (side == Ball::P_LEFT ? Board::LEFT_UP   : Board::RIGHT_UP);
+    down = 1 << (side == Ball::P_LEFT ? Board::LEFT_DOWN : Board::RIGHT_DOWN);
+
+    float ticks = std::max(difficulty.reaction, 0.0f) * static_cast<float>(config.tickRate);
+    delay = std::min(MAX_DELAY - 1, static_cast<uint32_t>(std::lround(ticks)));
+    error = std::max(difficulty.error, 0.0f);
+    rng   = seed % 2147483647 ? seed % 2147483647 : 1;
+}
+
+unsigned char Controller::Decide(const Board::State& s)
+{
+    // The board as it was the reaction time ago, or as it first was.
+    seen[ticks % MAX_DELAY] = Seen{s.ball.pos, s.velocity, s.state, s.nextServe};
+    const Seen& b = seen[(ticks - std::min<uint64_t>(ticks, delay)) % MAX_DELAY];
+    ticks++;
+
+    // Waits in the middle unless the ball is coming.
+    const Board::State::Rect& paddle = s.paddles[side];
+    float offset = static_cast<float>(s.ball.size.y - paddle.size.y) / 2.0f;
+    float target = static_cast<float>(size.y - paddle.size.y) / 2.0f;
+    bool  towards = b.state == Ball::PLAY && (side == Ball::P_LEFT ? b.velocity.x < 0.0f : b.velocity.x > 0.0f);
+    if (towards)
+    {
+        if (!approaching)
+            miss = error * (2.0f * static_cast<float>(Random() - 1) / 2147483645.0f - 1.0f);
+        target = Predict(b.pos, b.velocity, s) + offset + miss;
+    }
+    approaching = towards;
+
+    // Within a quarter of the ball is close enough, so it doesn't jitter
+    // around the target.
+    unsigned char buttons = 0;
+    float         close   = static_cast<float>(s.ball.size.y) / 4.0f;
+    if (paddle.pos.y < target - close)
+        buttons |= down;
+    else if (paddle.pos.y > target + close)
+        buttons |= up;
+
+    // Serve is let go every other tick, as it only counts once released.
+    if (b.state == Ball::SERVE && b.nextServe == side && ticks % 2)
+        buttons |= 1 << Board::SERVE;
+    return buttons;
+}
+
+float Controller::Predict(olc::vf2d pos, olc::vf2d velocity, const Board::State& s) const
+{
+    const Board::State::Rect& paddle = s.paddles[side];
+    float edge = side == Ball::P_LEFT ? paddle.pos.x + static_cast<float>(paddle.size.x)
+                                      : paddle.pos.x - static_cast<float>(s.ball.size.x);
+    float time = velocity.x != 0.0f ? std::max(0.0f, (edge - pos.x) / velocity.x) : 0.0f;
+    float y    = pos.y + velocity.y * time;
+
+    // Unfolds the bounces: the ball's path between the top and bottom is a
+    // straight line through copies of the board, mirrored every other one.
+    float span = static_cast<float>(size.y - s.ball.size.y);
+    if (span <= 0.0f)
+        return 0.0f;
+    y = std::fmod(y, 2.0f * span);
+    if (y < 0.0f)
+        y += 2.0f * span;
+    return y > span ? 2.0f * span - y : y;
+}
+
+uint32_t Controller::Random()
+{
+    rng = static_cast<uint32_t>(static_cast<uint64_t>(rng) * 48271 % 2147483647);
+    return rng;
+}
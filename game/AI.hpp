@@ -0,0 +1,86 @@
+/*
+
+    Computer opponents. A Controller plays one paddle of a match, deciding
+    the buttons for each tick from the board alone.
+
+    While the ball heads its way, it works out where the ball will cross
+    the paddle's edge: the ball's height after flying straight there,
+    folded back into the board for every bounce off the top or bottom, as
+    light between two mirrors. That's a few multiplies however far away
+    the ball is or however often it will bounce, so each decision takes
+    the same time. The paddle is then moved to meet it, and back to the
+    middle while the ball heads away. It serves when it's its turn.
+
+    Two knobs make it beatable. It sees the board as it was the reaction
+    time ago, so it answers a hit or a serve late. Each time the ball
+    turns towards it, it also picks a random error, up to the given number
+    of pixels either way, in where it expects the ball, so it sometimes
+    misses. The errors come from a seed, so AI matches play out the same
+    every time.
+
+*/
+
+#ifndef _AI_BLOCK
+#define _AI_BLOCK
+
+#include <cstdint>
+
+#include "Board.hpp"
+
+namespace AI
+{
+
+struct Difficulty
+{
+    float reaction = 0.15f;   // Seconds the board is seen late.
+    float error    = 30.0f;   // Pixels the ball is misjudged by, at most.
+};
+
+class Controller
+{
+public:
+    // Ticks the reaction time is capped at.
+    static const uint32_t MAX_DELAY = 64;
+
+    Controller(const Board::Config&, Board::Ball::Players side,
+               const Difficulty& = Difficulty(), uint32_t seed = 1);
+
+    // The buttons for the next tick, given the board before it. Called
+    // once a tick.
+    unsigned char Decide(const Board::State&);
+
+    // The paddle's buttons, to replace anyone else's with the decided ones.
+    // Serve is pressed as well as anyone else's.
+    unsigned char GetMask() const { return up | down; }
+
+    // Where the ball will cross the paddle's edge, by its top.
+    float Predict(olc::vf2d pos, olc::vf2d velocity, const Board::State&) const;
+
+private:
+    // What's seen of the board each tick.
+    struct Seen
+    {
+        olc::vf2d            pos;
+        olc::vf2d            velocity;
+        Board::Ball::States  state     = Board::Ball::SERVE;
+        Board::Ball::Players nextServe = Board::Ball::P_LEFT;
+    };
+
+    uint32_t Random();
+
+    Board::Ball::Players side;
+    unsigned char        up, down;
+    olc::vi2d            size;
+    uint32_t             delay;
+    float                error;
+    uint32_t             rng;
+
+    Seen     seen[MAX_DELAY];
+    uint64_t ticks       = 0;
+    bool     approaching = false;
+    float    miss        = 0.0f;
+};
+
+}
+
+#endif
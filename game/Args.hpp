@@ -0,0 +1,82 @@
+/*
+
+    Numbers from the command line, for the game and its tools. An option's
+    value must be the whole of its argument and within the option's range,
+    rather than whatever std::stoul makes of it, which throws on "abc" and
+    wraps "-1" and "70000" into other numbers. When it isn't, the option is
+    named on std::cerr along with what it takes, and the caller prints its
+    usage.
+
+*/
+
+#ifndef _ARGS_BLOCK
+#define _ARGS_BLOCK
+
+#include <cctype>
+#include <cerrno>
+#include <cstdlib>
+#include <iostream>
+#include <limits>
+#include <type_traits>
+
+namespace Args
+{
+
+// Reads text into value, false if it isn't a number from min to max.
+template <typename T>
+bool Number(const char* option, const char* text, T& value,
+            T min = std::numeric_limits<T>::lowest(), T max = std::numeric_limits<T>::max())
+{
+    static_assert(std::is_arithmetic<T>::value, "Args::Number reads numbers");
+
+    bool  read   = false;
+    T     parsed = T();
+    char* end    = nullptr;
+    errno = 0;
+    if constexpr (std::is_floating_point<T>::value)
+    {
+        double d = std::strtod(text, &end);
+        // NaN fails both comparisons.
+        read = d >= static_cast<double>(min) && d <= static_cast<double>(max);
+        parsed = static_cast<T>(d);
+    }
+    else if constexpr (std::is_signed<T>::value)
+    {
+        long long n = std::strtoll(text, &end, 10);
+        read = n >= static_cast<long long>(min) && n <= static_cast<long long>(max);
+        parsed = static_cast<T>(n);
+    }
+    // strtoull would take "-1" as the largest number.
+    else if (text[0] != '-')
+    {
+        unsigned long long n = std::strtoull(text, &end, 10);
+        read = n >= static_cast<unsigned long long>(min) && n <= static_cast<unsigned long long>(max);
+        parsed = static_cast<T>(n);
+    }
+    read = read && errno != ERANGE && end != text && *end == '\0'
+        && !std::isspace(static_cast<unsigned char>(text[0]));
+    if (read)
+    {
+        value = parsed;
+        return true;
+    }
+
+    std::cerr << option << " takes a number";
+    // Whole numbers always have both ends worth naming.
+    bool whole = std::is_integral<T>::value;
+    bool from  = whole || min != std::numeric_limits<T>::lowest();
+    bool to    = whole || max != std::numeric_limits<T>::max();
+    // Promoted, so 8-bit types print as numbers.
+    if (from && to)
+        std::cerr << " from " << +min << " to " << +max;
+    else if (from)
+        std::cerr << " of " << +min << " or more";
+    else if (to)
+        std::cerr << " of " << +max << " or less";
+    std::cerr << ", not " << text << "." << std::endl;
+    return false;
+}
+
+}
+
+#endif
@@ -1,6 +1,7 @@
 #include <string>
 
 #include "Board.hpp"
+#include "Telemetry.hpp"
 
 using namespace Board;
 
@@ -40,9 +41,9 @@ Rectangle::Edges Rectangle::KeepInbound()
         pos.y    = 0;
         oobValue = TOP;
     }
-    else if (pos.y > game->ScreenHeight() - static_cast<float>(size.y))
+    else if (pos.y > bounds.y - static_cast<float>(size.y))
     {
-        pos.y    = game->ScreenHeight() - static_cast<float>(size.y);
+        pos.y    = bounds.y - static_cast<float>(size.y);
         oobValue = BOTTOM;
     }
     // Checks for OoB on the sides.
@@ -51,9 +52,9 @@ Rectangle::Edges Rectangle::KeepInbound()
         pos.x    = 0;
         oobValue = LEFT;
     }
-    else if (pos.x > game->ScreenWidth() - static_cast<float>(size.x))
+    else if (pos.x > bounds.x - static_cast<float>(size.x))
     {
-        pos.x    = game->ScreenWidth() - static_cast<float>(size.x);
+        pos.x    = bounds.x - static_cast<float>(size.x);
         oobValue = RIGHT;
     }
     return oobValue;
@@ -63,17 +64,17 @@ Rectangle::Edges Rectangle::KeepInbound()
 ------------------- Paddle functions. -------------------
 ------------------------------------------------------ */
 
-Paddle::Paddle(olc::PixelGameEngine* _game, float _pos_x, bool* _downButton, bool* _upButton)
+Paddle::Paddle(const Config& config, float _pos_x, bool* _downButton, bool* _upButton)
 {
-    game = _game;
+    bounds = config.size;
 
     // Initial conditions.
-    speed = 400;
-    size  = olc::vi2d{20,120};
+    speed = config.paddleSpeed;
+    size  = config.paddleSize;
     score = 0;
 
     // Sets and shifts position to account for width and height.
-    pos  = olc::vf2d{_pos_x, static_cast<float>(game->ScreenHeight()) / 2.0f};
+    pos  = olc::vf2d{_pos_x, static_cast<float>(bounds.y) / 2.0f};
     pos -= size / 2.0f;
 
     downButton = _downButton;
@@ -93,31 +94,32 @@ void Paddle::Update(float fElapsedTime)
     }
 
     KeepInbound();
-    Draw();
 }
 
 /* ------------------------------------------------------
 -------------------- Ball functions. --------------------
 ------------------------------------------------------ */
 
-Ball::Ball(olc::PixelGameEngine* _game, bool* _serveButton)
+Ball::Ball(const Config& config, bool* _serveButton)
 {
-    game = _game;
+    bounds = config.size;
+    rng = config.seed % 2147483647 ? config.seed % 2147483647 : 1;
 
     // Initial conditions.
-    startingSpeed = speed = 400;
-    speedDelta    = 15;
+    startingSpeed = speed = config.ballSpeed;
+    speedDelta    = config.speedDelta;
+    maxPushAngle  = config.maxPushAngle * (3.14f/180.0f);
 
     size = olc::vi2d{20,20};
 
-    maxScore  = 5;
+    maxScore  = config.maxScore;
     nextServe = P_LEFT;
     state     = SERVE;
 
     // Puts the ball on the center of the screen.
     pos = startingPos = olc::vf2d{
-        static_cast<float>(game->ScreenWidth()  - this->size.x)/2,
-        static_cast<float>(game->ScreenHeight() - this->size.y)/2
+        static_cast<float>(bounds.x - this->size.x)/2,
+        static_cast<float>(bounds.y - this->size.y)/2
         };
 
     serveButton = _serveButton;
@@ -134,21 +136,23 @@ void Ball::Update(float fElapsedTime)
     // Serve state.
     if (state == SERVE)
     {
-        DrawServeMessage();
         reset();
         if (!*serveButton)
             pressing = false;
         else if (*serveButton && !pressing)
         {            
             state = PLAY;
+            rallyTime = 0.0f;
+            rallyHits = 0;
+            Telemetry::Add(Telemetry::SERVES);
 
             // Generates random starting velocity, between -45° and 45°.
-            int randX = 1 + rand() % 100;
+            int randX = 1 + Random() % 100;
             velocity    = olc::vf2d{
                 static_cast<float>(randX),
-                static_cast<float>(1 + rand() % randX)
+                static_cast<float>(1 + Random() % randX)
             };
-            velocity.y *= rand() % 2 == 1 ? 1.0f : -1.0f;
+            velocity.y *= Random() % 2 == 1 ? 1.0f : -1.0f;
             velocity    = speed * velocity.norm();
             if (nextServe == P_RIGHT)
                 velocity.x *= -1;
@@ -159,6 +163,7 @@ void Ball::Update(float fElapsedTime)
     else if (state == PLAY)
     {
         pos += velocity * fElapsedTime;
+        rallyTime += fElapsedTime;
         Edges oobEdge = KeepInbound();
         switch (oobEdge)
         {
@@ -174,6 +179,8 @@ void Ball::Update(float fElapsedTime)
                 {
                     this->BounceOn(i);
                     speed += speedDelta;
+                    rallyHits++;
+                    Telemetry::Add(Telemetry::HITS);
                     break;
                 }
             }
@@ -192,6 +199,7 @@ void Ball::Update(float fElapsedTime)
                 state = WIN;
             else
                 state = SERVE;
+            recordGoal();
             break;
         case RIGHT:
             nextServe = P_RIGHT;
@@ -201,6 +209,7 @@ void Ball::Update(float fElapsedTime)
                 state = WIN;
             else
                 state = SERVE;
+            recordGoal();
             break;
         }
     }
@@ -208,7 +217,6 @@ void Ball::Update(float fElapsedTime)
     // Win state.
     else if (state == WIN)
     {
-        DrawWinMessage();
         reset();
         if (*serveButton)
         {
@@ -220,9 +228,86 @@ void Ball::Update(float fElapsedTime)
             state = SERVE;
         }
     }
+}
+
+void Ball::Snapshot(State& s) const
+{
+    for (int i = 0; i < 2; i++)
+    {
+        s.paddles[i] = State::Rect{paddles[i].pos, paddles[i].size};
+        s.scores[i]  = paddles[i].score;
+    }
+    s.ball      = State::Rect{pos, size};
+    s.velocity  = velocity;
+    s.state     = state;
+    s.nextServe = nextServe;
+    s.winner    = winner;
+}
+
+void Ball::recordGoal()
+{
+    if (!Telemetry::enabled.load(std::memory_order_relaxed))
+        return;
+    Telemetry::Add(Telemetry::POINTS);
+    if (state == WIN)
+        Telemetry::Add(Telemetry::MATCHES);
+    Telemetry::Observe(Telemetry::RALLY_HITS, rallyHits);
+    Telemetry::Observe(Telemetry::GOAL_SPEED, velocity.mag());
+    Telemetry::Observe(Telemetry::SERVE_TO_GOAL, rallyTime);
+}
+
+uint32_t Ball::Random()
+{
+    rng = static_cast<uint32_t>(static_cast<uint64_t>(rng) * 48271 % 2147483647);
+    return rng;
+}
+
+uint32_t Board::MixSeed(uint64_t x)
+{
+    x ^= x >> 30;
+    x *= 0xBF58476D1CE4E5B9ull;
+    x ^= x >> 27;
+    x *= 0x94D049BB133111EBull;
+    x ^= x >> 31;
+    return static_cast<uint32_t>(x % 2147483646) + 1;
+}
 
-    DrawScore();
-    Draw();
+void Ball::Save(Keyframe& k) const
+{
+    for (int i = 0; i < 2; i++)
+    {
+        k.paddles[i] = paddles[i].pos;
+        k.scores[i]  = paddles[i].score;
+    }
+    k.ball      = pos;
+    k.velocity  = velocity;
+    k.speed     = speed;
+    k.state     = state;
+    k.nextServe = nextServe;
+    k.winner    = winner;
+    k.pressing  = pressing;
+    k.rng       = rng;
+    k.rallyTime = rallyTime;
+    k.rallyHits = rallyHits;
+}
+
+void Ball::Restore(const Keyframe& k)
+{
+    for (int i = 0; i < 2; i++)
+    {
+        paddles[i].pos   = k.paddles[i];
+        paddles[i].score = k.scores[i];
+    }
+    pos       = k.ball;
+    velocity  = k.velocity;
+    speed     = k.speed;
+    state     = k.state;
+    nextServe = k.nextServe;
+    winner    = k.winner;
+    pressing  = k.pressing;
+    rng       = k.rng;
+    rallyTime = k.rallyTime;
+    rallyHits = k.rallyHits;
 }
 
 void Ball::BounceOn(Paddle& p)
@@ -250,10 +335,6 @@ void Ball::BounceOn(Paddle& p)
     // If the ball collides on the sides of the paddle:
     else
     {
-        /* How much the paddle can push the ball and how angled
-        the ball can leave after bouncing on the paddle */
-        float maxPushAngle  = 60 * (3.14f/180.0f); // Radians.
-
         /* Angle the paddle will push the ball
         based on where it hit it, in radians. */
         float pushAngle =
@@ -263,6 +344,9 @@ void Ball::BounceOn(Paddle& p)
             // Max distance between centers (x2).
             / static_cast<float>(this->size.y + p.size.y);
 
+        // Where it hit, from -1 at the paddle's top to 1 at its bottom.
+        Telemetry::Observe(Telemetry::HIT_OFFSET, pushAngle / maxPushAngle);
+
         // New velocity.
         this->velocity = olc::vf2d{
             this->speed * static_cast<float>(cos(pushAngle)),
@@ -283,6 +367,51 @@ void Ball::BounceOn(Paddle& p)
     }
 }
 
+/* ------------------------------------------------------
+-------------------- Match functions. -------------------
+------------------------------------------------------ */
+
+Match::Match(const Config& _config)
+    : config(_config)
+{
+    float horizontalOffset = 24.0f;
+    Paddle left{
+        config,
+        horizontalOffset,
+        &states[LEFT_DOWN],
+        &states[LEFT_UP]
+    };
+    Paddle right{
+        config,
+        static_cast<float>(config.size.x) - horizontalOffset,
+        &states[RIGHT_DOWN],
+        &states[RIGHT_UP]
+    };
+
+    ball = Ball{config, &states[SERVE]};
+    ball.AddPaddle(left);
+    ball.AddPaddle(right);
+}
+
+void Match::Save(Keyframe& k) const
+{
+    ball.Save(k);
+    k.ticks = ticks;
+}
+
+void Match::Restore(const Keyframe& k)
+{
+    ball.Restore(k);
+    ticks = k.ticks;
+}
+
+void Match::Tick(unsigned char buttons)
+{
+    decodeButtons(buttons, states);
+    ball.Update(1.0f / static_cast<float>(config.tickRate));
+    ticks++;
+}
+
 /* ------------------------------------------------------
 --------------- String drawing functions. ---------------
 ------------------------------------------------------ */
@@ -297,6 +426,8 @@ void DrawCenteredString
     uint32_t scale
 )
 {
+    OLC_PROFILE_ZONE("DrawCenteredString");
+
     /* Constants to decide how text should be shifted
     per character in order to center it. */
     float STR_Y_MULTIPLIER = 3.5;
@@ -315,39 +446,36 @@ void DrawCenteredString
     game->DrawString(x, y, s, color, scale);
 }
 
-void Ball::DrawScore()
-{
-    std::ostringstream stream;
-    stream << paddles[P_LEFT].score << "\t" << paddles[P_RIGHT].score;
-    std::string mes = stream.str();
-
-    DrawCenteredString(game, 0, 0, mes, Board::BORDER_COLOR, 20);
-}
+/* ------------------------------------------------------
+------------------- Drawing functions. ------------------
+------------------------------------------------------ */
 
-void Ball::DrawServeMessage()
+void Board::Draw(olc::PixelGameEngine* game, const State& s)
 {
-    std::ostringstream stream;
-    stream << "Player ";
-    if (nextServe == P_LEFT)
-        stream << "1";
-    if (nextServe == P_RIGHT)
-        stream << "2";
-    stream << ", it's your turn to serve!";
-    std::string mes = stream.str();
+    OLC_PROFILE_ZONE("Board::Draw");
 
-    DrawCenteredString(game, 0, -200, mes, Board::BORDER_COLOR, 3);
-}
+    for (const State::Rect& r : s.paddles)
+        game->FillRect(r.pos, r.size, Board::PLAY_OBJECT_COLOR);
 
-void Ball::DrawWinMessage()
-{
     std::ostringstream stream;
-    stream << "Congratulations Player ";
-    if (winner == P_LEFT)
-        stream << "1";
-    if (winner == P_RIGHT)
-        stream << "2";
-    stream << ", you've won!";
+    if (s.state == Ball::SERVE)
+    {
+        stream << "Player " << (s.nextServe == Ball::P_LEFT ? "1" : "2")
+               << ", it's your turn to serve!";
+    }
+    else if (s.state == Ball::WIN)
+    {
+        stream << "Congratulations Player " << (s.winner == Ball::P_LEFT ? "1" : "2")
+               << ", you've won!";
+    }
     std::string mes = stream.str();
+    if (!mes.empty())
+        DrawCenteredString(game, 0, -200, mes, Board::BORDER_COLOR, 3);
+
+    stream.str("");
+    stream << s.scores[Ball::P_LEFT] << "\t" << s.scores[Ball::P_RIGHT];
+    mes = stream.str();
+    DrawCenteredString(game, 0, 0, mes, Board::BORDER_COLOR, 20);
 
-    DrawCenteredString(game, 0, -200, mes, Board::BORDER_COLOR, 3);
+    game->FillRect(s.ball.pos, s.ball.size, Board::PLAY_OBJECT_COLOR);
 }
@@ -2,15 +2,24 @@
 
     Paddle and Ball Classes for the game Pong.
     Ball also contains game control logic.
+    Match steps both with the controller's buttons a fixed tick at a time,
+    so a match plays out the same given its Config and the buttons.
+    Keyframe is everything a Match changes as it ticks, so a match can be
+    restored partway through.
+    State is a copy of the board that Draw renders and the AI plays from,
+    so the game can be simulated on one thread and drawn on another.
 
 */
 
 #ifndef _BOARD_BLOCK
 #define _BOARD_BLOCK
 
+#include <cstdint>
+#include <type_traits>
 #include <vector>
 
 #include "olcPixelGameEngine.hpp"
+#include "../controller/controller-info.hpp"
 
 namespace Board
 {
@@ -19,11 +28,45 @@ const olc::Pixel BORDER_COLOR      = olc::DARK_GREY;
 const olc::Pixel BACKGROUND_COLOR  = olc::VERY_DARK_BLUE;
 const olc::Pixel PLAY_OBJECT_COLOR = olc::GREY;
 
+// Bits of the controller's state byte.
+enum Buttons
+{
+    LEFT_DOWN,
+    LEFT_UP,
+    SERVE,
+    RIGHT_DOWN,
+    RIGHT_UP
+};
+
+// Everything a match depends on besides the buttons pressed. Replays and
+// spectators keep the first four only, so the game plays with the rules
+// below them as they are; pong_sweep tries others.
+struct Config
+{
+    olc::vi2d size     = {1080, 720};
+    uint32_t  seed     = 1;
+    uint32_t  tickRate = 120;   // Simulation steps per second.
+    int       maxScore = 5;
+
+    float     ballSpeed    = 400.0f;     // Pixels per second at each serve.
+    float     speedDelta   = 15.0f;      // Added to the ball's speed by each hit.
+    float     paddleSpeed  = 400.0f;     // Pixels per second.
+    olc::vi2d paddleSize   = {20, 120};
+    float     maxPushAngle = 60.0f;      // Degrees a paddle's edge angles the ball by.
+};
+
+// Scatters a key over the serve RNG's seeds, 1 to 2147483646, so that
+// neighbouring keys, like a run's matches, serve unrelated rallies. It's
+// splitmix64's finalizer, folded into std::minstd_rand's range.
+uint32_t MixSeed(uint64_t key);
+
 class Rectangle
 {
 public:
     Rectangle() = default;
-    olc::PixelGameEngine* game;
+
+    // Size of the board the rectangle is kept within.
+    olc::vi2d  bounds;
 
     olc::vf2d  pos;
     float      speed;
@@ -33,21 +76,20 @@ public:
     // Used to determine collisions.
     enum  Corners {TOP_LEFT, TOP_RIGHT, BOTTOM_LEFT, BOTTOM_RIGHT};
     enum  Edges   {LEFT, TOP, RIGHT, BOTTOM, NO_EDGE};
-    float edges[4];
+    float edges[4] = {};
 
     void UpdateEdges();
     bool CollidingWith(Rectangle&);
     bool Contains(olc::vf2d);
 
     Edges KeepInbound();
-    void  Draw() { game->FillRect(pos, size, color); }
 };
 
 class Paddle : public Rectangle
 {
 public:
     Paddle() = default;
-    Paddle(olc::PixelGameEngine*, float, bool*, bool*);
+    Paddle(const Config&, float, bool*, bool*);
 
     int  score = 0;
 
@@ -58,44 +100,128 @@ public:
     void Update(float);
 };
 
+struct State;
+struct Keyframe;
+
 class Ball : public Rectangle
 {
 public:
     Ball() = default;
-    Ball(olc::PixelGameEngine*, bool*);
+    Ball(const Config&, bool*);
+
+    // A byte each, so keyframes stay small.
+    enum Players : uint8_t {P_LEFT, P_RIGHT};
+    enum States  : uint8_t {SERVE, WIN, PLAY};
 
 private:
     olc::vf2d startingPos;
     float     startingSpeed, speedDelta;
+    float     maxPushAngle;   // Radians.
     olc::vf2d velocity;
     bool*     serveButton;
     int       maxScore;
 
+    // Serve angles, seeded by the config so matches can be replayed. It's
+    // std::minstd_rand with its state in the open, so keyframes are cheap.
+    uint32_t rng = 1;
+    uint32_t Random();
+
     std::vector<Paddle> paddles;
-    enum    Players {P_LEFT, P_RIGHT};
-    Players nextServe, winner;
+    Players nextServe = P_LEFT, winner = P_LEFT;
 
-    enum   States {SERVE, WIN, PLAY};
     States state = SERVE;
 
     /* Used to prevent the same button press
     from being registered twice. */
-    bool pressing;
+    bool pressing = false;
+
+    // Time and paddle hits since the serve, for telemetry.
+    float rallyTime = 0.0f;
+    int   rallyHits = 0;
 
 public:
     void Update(float);
     void AddPaddle(Paddle& p) { paddles.push_back(p); }
+    void Snapshot(State&) const;
+    void Save(Keyframe&) const;
+    void Restore(const Keyframe&);
+    void BounceOn(Paddle&);
 
 private:
     void reset() { pos = startingPos; speed = startingSpeed; }
+    void recordGoal();
+};
 
-    void BounceOn(Paddle&);
+struct State
+{
+    struct Rect
+    {
+        olc::vf2d pos;
+        olc::vi2d size;
+    };
+
+    Rect          paddles[2];
+    Rect          ball;
+    olc::vf2d     velocity;
+    int           scores[2] = {0, 0};
+    Ball::States  state     = Ball::SERVE;
+    Ball::Players nextServe = Ball::P_LEFT;
+    Ball::Players winner    = Ball::P_LEFT;
+};
 
-    void DrawScore();
-    void DrawServeMessage();
-    void DrawWinMessage();
+// Plain bytes with nothing pointing into the match or the engine, widest
+// fields first so there's no padding between them, so it can be copied
+// with memcpy or kept in arrays of thousands.
+struct Keyframe
+{
+    uint64_t      ticks = 0;
+    olc::vf2d     paddles[2];
+    olc::vf2d     ball;
+    olc::vf2d     velocity;
+    int           scores[2] = {0, 0};
+    float         speed     = 0.0f;
+    uint32_t      rng       = 1;
+    float         rallyTime = 0.0f;
+    int           rallyHits = 0;
+    Ball::States  state     = Ball::SERVE;
+    Ball::Players nextServe = Ball::P_LEFT;
+    Ball::Players winner    = Ball::P_LEFT;
+    bool          pressing  = false;
 };
 
+static_assert(std::is_trivially_copyable<Keyframe>::value, "Keyframe must copy as bytes");
+static_assert(sizeof(Keyframe) == 72, "Keyframe has grown");
+
+class Match
+{
+public:
+    Match(const Config& = Config());
+
+    // The paddles and ball point at the buttons.
+    Match(const Match&) = delete;
+    Match& operator=(const Match&) = delete;
+
+    // Steps the board by 1/tickRate seconds with the controller's state byte.
+    void Tick(unsigned char buttons);
+    void Snapshot(State& s) const { ball.Snapshot(s); }
+
+    // Restore takes a keyframe saved from a match with the same config.
+    void Save(Keyframe&) const;
+    void Restore(const Keyframe&);
+
+    const Config& GetConfig() const { return config; }
+    uint64_t      GetTicks()  const { return ticks; }
+
+private:
+    Config   config;
+    bool     states[NUM_BUTTONS] = {};
+    Ball     ball;
+    uint64_t ticks = 0;
+};
+
+// Draws the paddles, ball, score and any message over the background.
+void Draw(olc::PixelGameEngine*, const State&);
+
 }
 
 #endif
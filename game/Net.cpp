@@ -0,0 +1,322 @@
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <unistd.h>
+
+#include "Net.hpp"
+#include "Telemetry.hpp"
+
+using namespace Net;
+using Clock = std::chrono::steady_clock;
+
+namespace
+{
+
+const size_t PACKET_HEADER = 13;
+
+void put(std::vector<unsigned char>& out, uint32_t value)
+{
+    for (int i = 0; i < 4; i++)
+        out.push_back(static_cast<unsigned char>(value >> (8 * i)));
+}
+
+uint32_t get(const unsigned char* in)
+{
+    return in[0] | in[1] << 8 | in[2] << 16 | static_cast<uint32_t>(in[3]) << 24;
+}
+
+// FNV-1a of everything the two hosts' matches must agree on.
+uint32_t hashConfig(const Board::Config& config)
+{
+    uint32_t hash = 2166136261u;
+    for (uint32_t value : {static_cast<uint32_t>(config.size.x), static_cast<uint32_t>(config.size.y),
+                           config.seed, config.tickRate, static_cast<uint32_t>(config.maxScore)})
+    {
+        for (int i = 0; i < 4; i++)
+        {
+            hash ^= (value >> (8 * i)) & 0xFF;
+            hash *= 16777619u;
+        }
+    }
+    return hash;
+}
+
+}
+
+bool Net::SplitAddress(const std::string& text, std::string& host, uint16_t& port)
+{
+    size_t colon = text.rfind(':');
+    if (colon == std::string::npos || colon == 0)
+        return false;
+    unsigned long number;
+    char          end;
+    if (std::sscanf(text.c_str() + colon + 1, "%lu%c", &number, &end) != 1
+        || !std::isdigit(static_cast<unsigned char>(text[colon + 1])) || number < 1 || number > 65535)
+        return false;
+
+    host = text.substr(0, colon);
+    if (host.size() > 2 && host.front() == '[' && host.back() == ']')
+        host = host.substr(1, host.size() - 2);
+    port = static_cast<uint16_t>(number);
+    return true;
+}
+
+Session::Session(Board::Match& _match, Board::Ball::Players side, uint32_t _maxRollback)
+    : match(_match), history(HISTORY)
+{
+    unsigned char left  = 1 << Board::LEFT_DOWN  | 1 << Board::LEFT_UP  | 1 << Board::SERVE;
+    unsigned char right = 1 << Board::RIGHT_DOWN | 1 << Board::RIGHT_UP | 1 << Board::SERVE;
+    localMask  = side == Board::Ball::P_LEFT ? left : right;
+    remoteMask = side == Board::Ball::P_LEFT ? right : left;
+
+    // The other host is at most the rollback depth ahead, and may still be
+    // missing up to twice that of ours, all of which the history must hold.
+    // A depth of 0 would stop both hosts before their first tick.
+    maxRollback = std::max(std::min(_maxRollback, HISTORY / 3), 1u);
+    hash        = hashConfig(match.GetConfig());
+}
+
+Session::~Session()
+{
+    if (fd >= 0)
+        close(fd);
+}
+
+bool Session::Open(uint16_t localPort, const std::string& host, uint16_t peerPort)
+{
+    addrinfo hints = {};
+    hints.ai_family   = AF_UNSPEC;
+    hints.ai_socktype = SOCK_DGRAM;
+    addrinfo* found;
+    std::string port = std::to_string(peerPort);
+    int error = getaddrinfo(host.c_str(), port.c_str(), &hints, &found);
+    if (error != 0)
+    {
+        std::cerr << "Error resolving " << host << ": " << gai_strerror(error) << std::endl;
+        return false;
+    }
+    memcpy(&peer, found->ai_addr, found->ai_addrlen);
+    peerLength = found->ai_addrlen;
+    int family = found->ai_family;
+    freeaddrinfo(found);
+
+    fd = socket(family, SOCK_DGRAM, 0);
+    if (fd < 0)
+    {
+        std::cerr << "Error " << errno << " from socket: " << strerror(errno) << std::endl;
+        return false;
+    }
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+
+    sockaddr_storage local = {};
+    socklen_t        localLength;
+    if (family == AF_INET6)
+    {
+        sockaddr_in6* a = reinterpret_cast<sockaddr_in6*>(&local);
+        a->sin6_family = AF_INET6;
+        a->sin6_addr   = in6addr_any;
+        a->sin6_port   = htons(localPort);
+        localLength    = sizeof *a;
+    }
+    else
+    {
+        sockaddr_in* a = reinterpret_cast<sockaddr_in*>(&local);
+        a->sin_family      = AF_INET;
+        a->sin_addr.s_addr = htonl(INADDR_ANY);
+        a->sin_port        = htons(localPort);
+        localLength        = sizeof *a;
+    }
+    if (bind(fd, reinterpret_cast<sockaddr*>(&local), localLength) != 0)
+    {
+        std::cerr << "Error " << errno << " from bind: " << strerror(errno) << std::endl;
+        close(fd);
+        fd = -1;
+        return false;
+    }
+    return true;
+}
+
+void Session::Emulate(double _loss, double _delay, double _jitter, uint32_t seed)
+{
+    loss   = _loss;
+    delay  = _delay;
+    jitter = _jitter;
+    rng.seed(seed);
+}
+
+Session::Slot& Session::At(uint64_t tick)
+{
+    Slot& slot = history[tick % HISTORY];
+    if (slot.tick != tick)
+        slot = Slot{tick};
+    return slot;
+}
+
+bool Session::Tick(unsigned char buttons)
+{
+    Receive();
+
+    uint64_t now = match.GetTicks();
+    if (rollbackFrom < now)
+        Rollback(rollbackFrom);
+    rollbackFrom = UINT64_MAX;
+    Commit();
+
+    // Waits for the other host rather than predict further than can be
+    // rolled back.
+    if (now >= confirmed + maxRollback)
+    {
+        stats.nStalls++;
+        Send();
+        return false;
+    }
+
+    Slot& slot = At(now);
+    match.Save(slot.keyframe);
+    slot.local = buttons & localMask;
+    if (!slot.known)
+        slot.remote = lastKnown;
+    Play(slot);
+    stats.nTicks++;
+
+    Send();
+    return true;
+}
+
+void Session::Receive()
+{
+    unsigned char packet[PACKET_HEADER + 255];
+    for (;;)
+    {
+        ssize_t size = recv(fd, packet, sizeof packet, 0);
+        if (size < 0)
+            break;
+        if (size < static_cast<ssize_t>(PACKET_HEADER) || get(packet) != hash
+            || size != static_cast<ssize_t>(PACKET_HEADER + packet[12]))
+            continue;
+        stats.nReceived++;
+
+        acked = std::max<uint64_t>(acked, get(packet + 4));
+
+        // Buttons for ticks already played that differ from the prediction
+        // mean a rollback. The other host can't be further ahead than the
+        // rollback depth, so anything past that is bogus.
+        uint64_t now   = match.GetTicks();
+        uint64_t first = get(packet + 8);
+        for (uint64_t t = std::max(first, confirmed); t < first + packet[12]; t++)
+        {
+            if (t > now + maxRollback)
+                break;
+            Slot& slot = At(t);
+            if (slot.known)
+                continue;
+            unsigned char remote = packet[PACKET_HEADER + (t - first)];
+            if (t < now && remote != slot.remote)
+                rollbackFrom = std::min(rollbackFrom, t);
+            slot.remote = remote;
+            slot.known  = true;
+        }
+
+        while (history[confirmed % HISTORY].tick == confirmed && history[confirmed % HISTORY].known)
+        {
+            lastKnown = history[confirmed % HISTORY].remote;
+            confirmed++;
+        }
+    }
+}
+
+void Session::Rollback(uint64_t from)
+{
+    auto start = Clock::now();
+    uint64_t now = match.GetTicks();
+
+    match.Restore(At(from).keyframe);
+    for (uint64_t t = from; t < now; t++)
+    {
+        // Predictions are made again from the newer buttons.
+        Slot& slot = At(t);
+        if (t != from)
+            match.Save(slot.keyframe);
+        if (!slot.known)
+            slot.remote = lastKnown;
+        Play(slot);
+    }
+
+    double us = std::chrono::duration<double, std::micro>(Clock::now() - start).count();
+    stats.nRollbacks++;
+    stats.nResimulated   += now - from;
+    stats.nMaxDepth       = std::max(stats.nMaxDepth, static_cast<uint32_t>(now - from));
+    stats.fMeanRollbackUs += (us - stats.fMeanRollbackUs) / static_cast<double>(stats.nRollbacks);
+    stats.fMaxRollbackUs  = std::max(stats.fMaxRollbackUs, us);
+}
+
+void Session::Play(Slot& slot)
+{
+    // What the tick records is held until its buttons are confirmed, and
+    // dropped if it's played again.
+    slot.events.Clear();
+    Telemetry::Deferred::Scope scope(slot.events);
+    match.Tick(slot.local | (slot.remote & remoteMask));
+}
+
+void Session::Commit()
+{
+    // Rollbacks were done first, so confirmed ticks were played with the
+    // buttons received.
+    uint64_t upTo = std::min(confirmed, match.GetTicks());
+    for (; committed < upTo; committed++)
+        history[committed % HISTORY].events.Commit();
+}
+
+void Session::Send()
+{
+    if (fd < 0)
+        return;
+
+    // Everything the other host hasn't acknowledged. It has had at least
+    // the ticks twice the rollback depth back, whatever acks were lost.
+    uint64_t now   = match.GetTicks();
+    uint64_t first = std::max<uint64_t>(acked, now > 2 * maxRollback ? now - 2 * maxRollback : 0);
+    first = std::min(first, now);
+
+    std::vector<unsigned char> packet;
+    put(packet, hash);
+    put(packet, static_cast<uint32_t>(confirmed));
+    put(packet, static_cast<uint32_t>(first));
+    packet.push_back(static_cast<unsigned char>(now - first));
+    for (uint64_t t = first; t < now; t++)
+        packet.push_back(history[t % HISTORY].local);
+    stats.nSent++;
+
+    if (loss <= 0.0 && delay <= 0.0 && jitter <= 0.0)
+    {
+        sendto(fd, packet.data(), packet.size(), 0, reinterpret_cast<sockaddr*>(&peer), peerLength);
+        return;
+    }
+
+    if (std::uniform_real_distribution<double>(0.0, 1.0)(rng) < loss)
+        stats.nDropped++;
+    else
+    {
+        double ms = delay + std::uniform_real_distribution<double>(0.0, jitter)(rng);
+        auto   due = Clock::now() + std::chrono::duration_cast<Clock::duration>(
+                         std::chrono::duration<double, std::milli>(ms));
+        delayed.push_back({due, std::move(packet)});
+    }
+    Flush();
+}
+
+void Session::Flush()
+{
+    auto now = Clock::now();
+    auto due = std::partition(delayed.begin(), delayed.end(),
+                              [&](const Delayed& d) { return d.due > now; });
+    for (auto it = due; it != delayed.end(); ++it)
+        sendto(fd, it->packet.data(), it->packet.size(), 0, reinterpret_cast<sockaddr*>(&peer), peerLength);
+    delayed.erase(due, delayed.end());
+}
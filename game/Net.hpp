@@ -0,0 +1,143 @@
+/*
+
+    Two-host play over UDP. Each host owns one paddle and runs the whole
+    match, sending its own buttons for every tick to the other host.
+
+    A tick doesn't wait for the other host's buttons. They are predicted to
+    be whatever was last received, and the match goes on. Once the real ones
+    arrive, if the guess was wrong, the match is rolled back to a keyframe
+    saved before that tick and played forward again with them. A host that
+    gets further than the rollback depth ahead of what it has received stops
+    ticking until the other host catches up.
+
+    Every packet carries all the sender's buttons the receiver hasn't
+    acknowledged, so a lost packet is covered by the next one:
+
+        u32     hash of the match config, to ignore any other game
+        u32     first tick the sender is still missing buttons for
+        u32     tick of the first buttons sent
+        u8      number of buttons sent
+        u8[]    buttons, one byte per tick
+
+    Multi-byte fields are little-endian.
+
+    Packets can also be dropped and delayed on purpose, to test rollbacks on
+    one machine over loopback.
+
+*/
+
+#ifndef _NET_BLOCK
+#define _NET_BLOCK
+
+#include <chrono>
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+#include <sys/socket.h>
+
+#include "Board.hpp"
+#include "Telemetry.hpp"
+
+namespace Net
+{
+
+// Splits host:port at the last colon, so an IPv6 address can be given as
+// [addr]:port. False unless the port is a number from 1 to 65535.
+bool SplitAddress(const std::string& text, std::string& host, uint16_t& port);
+
+class Session
+{
+public:
+    // Ticks are kept this far back, which bounds the rollback depth.
+    static const uint32_t HISTORY = 64;
+
+    // The match is ticked by the session and must have the same config as
+    // the other host's. The rollback depth is kept between 1 and a third of
+    // the history.
+    Session(Board::Match&, Board::Ball::Players side, uint32_t maxRollback = 12);
+    Session(const Session&) = delete;
+    Session& operator=(const Session&) = delete;
+    ~Session();
+
+    // Binds the local port and resolves the other host. False on failure.
+    bool Open(uint16_t localPort, const std::string& peer, uint16_t peerPort);
+
+    // Drops a fraction of the packets sent, and delays the rest by a time
+    // plus up to jitter more, in ms.
+    void Emulate(double loss, double delay, double jitter, uint32_t seed = 1);
+
+    // Advances the match a tick with the local buttons, after first rolling
+    // back for any buttons received that weren't predicted. False, without
+    // ticking, while the other host is too far behind.
+    bool Tick(unsigned char buttons);
+
+    // Ticks up to which the other host's buttons are all known.
+    uint64_t GetConfirmed() const { return confirmed; }
+
+    struct Stats
+    {
+        uint64_t nTicks       = 0;
+        uint64_t nStalls      = 0;
+        uint64_t nRollbacks   = 0;
+        uint64_t nResimulated = 0;   // Ticks played again.
+        uint32_t nMaxDepth    = 0;   // Most ticks rolled back at once.
+        double   fMeanRollbackUs = 0.0;
+        double   fMaxRollbackUs  = 0.0;
+        uint64_t nSent        = 0;
+        uint64_t nReceived    = 0;
+        uint64_t nDropped     = 0;   // By Emulate.
+    };
+    const Stats& GetStats() const { return stats; }
+
+private:
+    struct Slot
+    {
+        uint64_t        tick   = UINT64_MAX;
+        Board::Keyframe keyframe;    // The match before this tick.
+        unsigned char   local  = 0;
+        unsigned char   remote = 0;  // Received if known, else predicted.
+        bool            known  = false;
+        Telemetry::Deferred events;  // Of the tick as last played.
+    };
+
+    Slot& At(uint64_t tick);
+    void  Receive();
+    void  Rollback(uint64_t from);
+    void  Play(Slot&);
+    void  Commit();
+    void  Send();
+    void  Flush();
+
+    Board::Match& match;
+    unsigned char localMask, remoteMask;
+    uint32_t      maxRollback;
+    uint32_t      hash;
+
+    std::vector<Slot> history;
+    uint64_t          confirmed = 0;    // Remote buttons known below this.
+    unsigned char     lastKnown = 0;    // Remote buttons of confirmed - 1.
+    uint64_t          acked     = 0;    // Local buttons the other host has.
+    uint64_t          rollbackFrom = UINT64_MAX;
+    uint64_t          committed = 0;    // Telemetry recorded below this.
+
+    int              fd = -1;
+    sockaddr_storage peer;
+    socklen_t        peerLength = 0;
+
+    // Emulated network.
+    struct Delayed
+    {
+        std::chrono::steady_clock::time_point due;
+        std::vector<unsigned char>            packet;
+    };
+    double               loss = 0.0, delay = 0.0, jitter = 0.0;
+    std::mt19937         rng;
+    std::vector<Delayed> delayed;
+
+    Stats stats;
+};
+
+}
+
+#endif
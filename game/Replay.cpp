@@ -0,0 +1,491 @@
+#include <algorithm>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "Replay.hpp"
+
+using namespace Replay;
+
+namespace
+{
+
+const char          MAGIC[4]         = {'P', 'R', 'P', 'L'};
+const char          ARCHIVE_MAGIC[4] = {'P', 'A', 'R', 'C'};
+const unsigned char VERSION          = 1;
+const unsigned char ARCHIVE_VERSION  = 2;
+const size_t        HEADER           = 16;
+const size_t        ARCHIVE_HEADER   = 20;
+const size_t        RECORD           = 48;
+
+/* A keyframe record:
+       u64 entry offset, u64 ticks held, u8 buttons, u64 tick,
+       f32 x and y of each paddle, u32 score of each paddle,
+       f32 ball x, y, velocity x, y and speed,
+       u8 state, u8 next serve, u8 winner, u8 pressing, u32 rng,
+       f32 rally time, u32 rally hits. */
+const size_t        KEYFRAME         = 85;
+
+const unsigned char BUTTON_MASK = (1 << NUM_BUTTONS) - 1;
+
+void put(std::vector<unsigned char>& out, uint64_t value, int size)
+{
+    for (int i = 0; i < size; i++)
+        out.push_back(static_cast<unsigned char>(value >> (8 * i)));
+}
+
+void putFloat(std::vector<unsigned char>& out, float value)
+{
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof bits);
+    put(out, bits, 4);
+}
+
+uint64_t get(const unsigned char* in, int size)
+{
+    uint64_t value = 0;
+    for (int i = 0; i < size; i++)
+        value |= static_cast<uint64_t>(in[i]) << (8 * i);
+    return value;
+}
+
+float getFloat(const unsigned char* in)
+{
+    uint32_t bits = static_cast<uint32_t>(get(in, 4));
+    float    value;
+    memcpy(&value, &bits, sizeof value);
+    return value;
+}
+
+// Decodes the varint at data[i], moving i past it. False if it's cut short.
+bool getVarint(const unsigned char* data, size_t size, size_t& i, uint64_t& value)
+{
+    value = 0;
+    for (int shift = 0; shift < 64; shift += 7)
+    {
+        if (i >= size)
+            return false;
+        unsigned char byte = data[i++];
+        value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+        if (!(byte & 0x80))
+            return true;
+    }
+    return false;
+}
+
+// Whether putConfig keeps every field whole.
+bool fits(const Board::Config& config)
+{
+    return config.size.x >= 0 && config.size.x <= 65535 && config.size.y >= 0 && config.size.y <= 65535
+        && config.tickRate <= MAX_TICK_RATE && config.maxScore >= 0 && config.maxScore <= 255;
+}
+
+void putConfig(std::vector<unsigned char>& out, const Board::Config& config)
+{
+    put(out, config.size.x, 2);
+    put(out, config.size.y, 2);
+    put(out, config.seed, 4);
+    put(out, config.tickRate, 2);
+    put(out, config.maxScore, 1);
+}
+
+Board::Config getConfig(const unsigned char* in)
+{
+    Board::Config config;
+    config.size.x   = static_cast<int>(get(in, 2));
+    config.size.y   = static_cast<int>(get(in + 2, 2));
+    config.seed     = static_cast<uint32_t>(get(in + 4, 4));
+    config.tickRate = static_cast<uint32_t>(get(in + 8, 2));
+    config.maxScore = static_cast<int>(get(in + 10, 1));
+    return config;
+}
+
+void putKeyframe(std::vector<unsigned char>& out, const Stream::Position& p, const Board::Keyframe& k)
+{
+    put(out, p.offset, 8);
+    put(out, p.held, 8);
+    put(out, p.buttons, 1);
+    put(out, k.ticks, 8);
+    for (int i = 0; i < 2; i++)
+    {
+        putFloat(out, k.paddles[i].x);
+        putFloat(out, k.paddles[i].y);
+    }
+    for (int i = 0; i < 2; i++)
+        put(out, static_cast<uint32_t>(k.scores[i]), 4);
+    putFloat(out, k.ball.x);
+    putFloat(out, k.ball.y);
+    putFloat(out, k.velocity.x);
+    putFloat(out, k.velocity.y);
+    putFloat(out, k.speed);
+    put(out, k.state, 1);
+    put(out, k.nextServe, 1);
+    put(out, k.winner, 1);
+    put(out, k.pressing, 1);
+    put(out, k.rng, 4);
+    putFloat(out, k.rallyTime);
+    put(out, static_cast<uint32_t>(k.rallyHits), 4);
+}
+
+void getKeyframe(const unsigned char* in, Stream::Position& p, Board::Keyframe& k)
+{
+    p.offset  = get(in, 8);
+    p.held    = get(in + 8, 8);
+    p.buttons = static_cast<unsigned char>(get(in + 16, 1));
+    k.ticks   = get(in + 17, 8);
+    in += 25;
+    for (int i = 0; i < 2; i++, in += 8)
+        k.paddles[i] = olc::vf2d{getFloat(in), getFloat(in + 4)};
+    for (int i = 0; i < 2; i++, in += 4)
+        k.scores[i] = static_cast<int32_t>(get(in, 4));
+    k.ball      = olc::vf2d{getFloat(in), getFloat(in + 4)};
+    k.velocity  = olc::vf2d{getFloat(in + 8), getFloat(in + 12)};
+    k.speed     = getFloat(in + 16);
+    k.state     = static_cast<Board::Ball::States>(in[20]);
+    k.nextServe = static_cast<Board::Ball::Players>(in[21]);
+    k.winner    = static_cast<Board::Ball::Players>(in[22]);
+    k.pressing  = in[23] != 0;
+    k.rng       = static_cast<uint32_t>(get(in + 24, 4));
+    k.rallyTime = getFloat(in + 28);
+    k.rallyHits = static_cast<int32_t>(get(in + 32, 4));
+}
+
+}
+
+/* ------------------------------------------------------
+------------------- Stream functions. -------------------
+------------------------------------------------------ */
+
+Stream::Stream(const unsigned char* _data, size_t _size)
+    : data(_data), size(_size)
+{
+    Read();
+}
+
+void Stream::Read()
+{
+    size_t   i = position.offset;
+    uint64_t value;
+    valid = getVarint(data, size, i, value);
+    ticks = value >> NUM_BUTTONS;
+    mask  = value & BUTTON_MASK;
+    next  = i;
+}
+
+bool Stream::Next(unsigned char& buttons)
+{
+    // Moves past every entry whose buttons have been held long enough.
+    while (valid && position.held == ticks)
+    {
+        if (mask == 0)
+            return false;
+        position.buttons ^= mask;
+        position.offset   = next;
+        position.held     = 0;
+        Read();
+    }
+    if (!valid)
+        return false;
+    position.held++;
+    buttons = position.buttons;
+    return true;
+}
+
+void Stream::Seek(const Position& p)
+{
+    position = p;
+    Read();
+}
+
+/* ------------------------------------------------------
+------------------ Recorder functions. ------------------
+------------------------------------------------------ */
+
+bool Recorder::Open(const std::string& path, const Board::Config& config)
+{
+    Close();
+    if (!fits(config))
+        return false;
+    file = fopen(path.c_str(), "wb");
+    if (file == nullptr)
+        return false;
+
+    std::vector<unsigned char> header(MAGIC, MAGIC + 4);
+    put(header, VERSION, 1);
+    putConfig(header, config);
+
+    buttons = 0;
+    held    = 0;
+    ticks   = 0;
+    bytes   = fwrite(header.data(), 1, header.size(), file);
+    return bytes == HEADER;
+}
+
+void Recorder::Tick(unsigned char _buttons)
+{
+    if (file == nullptr)
+        return;
+
+    _buttons &= BUTTON_MASK;
+    if (_buttons != buttons)
+    {
+        Write(held, buttons ^ _buttons);
+        buttons = _buttons;
+        held    = 0;
+    }
+    held++;
+    ticks++;
+}
+
+bool Recorder::Close()
+{
+    if (file == nullptr)
+        return true;
+
+    Write(held, 0);
+    bool ok = ferror(file) == 0;
+    ok &= fclose(file) == 0;
+    file = nullptr;
+    return ok;
+}
+
+void Recorder::Write(uint64_t ticks, unsigned char mask)
+{
+    uint64_t value = ticks << NUM_BUTTONS | mask;
+    do
+    {
+        unsigned char byte = value & 0x7F;
+        value >>= 7;
+        fputc(value ? byte | 0x80 : byte, file);
+        bytes++;
+    } while (value);
+}
+
+/* ------------------------------------------------------
+------------------- Player functions. -------------------
+------------------------------------------------------ */
+
+bool Player::Open(const std::string& path)
+{
+    FILE* file = fopen(path.c_str(), "rb");
+    if (file == nullptr)
+        return false;
+    std::vector<unsigned char> data;
+    unsigned char chunk[4096];
+    for (size_t n; (n = fread(chunk, 1, sizeof chunk, file)) > 0; )
+        data.insert(data.end(), chunk, chunk + n);
+    fclose(file);
+
+    if (data.size() < HEADER || !std::equal(MAGIC, MAGIC + 4, data.begin()) || data[4] != VERSION)
+        return false;
+    Board::Config header = getConfig(&data[5]);
+    if (header.tickRate == 0)
+        return false;
+
+    // Walks every entry up front, so a truncated file is caught here
+    // rather than partway through playing it.
+    uint64_t total = 0;
+    for (size_t i = HEADER; ; )
+    {
+        uint64_t value;
+        if (!getVarint(data.data(), data.size(), i, value))
+            return false;
+        total += value >> NUM_BUTTONS;
+        if ((value & BUTTON_MASK) == 0)
+            break;
+    }
+
+    config  = header;
+    entries.assign(data.begin() + HEADER, data.end());
+    length  = total;
+    Rewind();
+    return true;
+}
+
+bool Player::Next(unsigned char& buttons)
+{
+    if (!stream.Next(buttons))
+        return false;
+    tick++;
+    return true;
+}
+
+void Player::Rewind()
+{
+    stream = Stream(entries.data(), entries.size());
+    tick   = 0;
+}
+
+/* ------------------------------------------------------
+--------------- Archive writer functions. ---------------
+------------------------------------------------------ */
+
+bool ArchiveWriter::Open(const std::string& path, uint32_t _interval)
+{
+    Close();
+    if (_interval == 0)
+        return false;
+    file = fopen(path.c_str(), "wb");
+    if (file == nullptr)
+        return false;
+
+    // The header is filled in by Close, once the index's place is known.
+    unsigned char header[ARCHIVE_HEADER] = {};
+    interval = _interval;
+    matches  = 0;
+    index.clear();
+    ok = fwrite(header, 1, sizeof header, file) == sizeof header;
+    return ok;
+}
+
+bool ArchiveWriter::Add(const Player& player)
+{
+    if (file == nullptr || !fits(player.GetConfig()))
+        return false;
+
+    // Plays the match, keeping a keyframe every interval ticks.
+    const std::vector<unsigned char>& entries = player.GetEntries();
+    Board::Match match(player.GetConfig());
+    Stream       stream(entries.data(), entries.size());
+    std::vector<unsigned char> keyframes;
+    uint32_t count = 0;
+    for (unsigned char buttons; ; match.Tick(buttons))
+    {
+        if (match.GetTicks() % interval == 0)
+        {
+            Board::Keyframe k;
+            match.Save(k);
+            putKeyframe(keyframes, stream.Tell(), k);
+            count++;
+        }
+        if (!stream.Next(buttons))
+            break;
+    }
+
+    uint64_t offset = static_cast<uint64_t>(ftell(file));
+    putConfig(index, player.GetConfig());
+    put(index, 0, 1);
+    put(index, match.GetTicks(), 8);
+    put(index, offset, 8);
+    put(index, entries.size(), 4);
+    put(index, offset + entries.size(), 8);
+    put(index, count, 4);
+    put(index, interval, 4);
+    matches++;
+
+    ok &= fwrite(entries.data(), 1, entries.size(), file) == entries.size();
+    ok &= fwrite(keyframes.data(), 1, keyframes.size(), file) == keyframes.size();
+    return ok;
+}
+
+bool ArchiveWriter::Close()
+{
+    if (file == nullptr)
+        return true;
+
+    std::vector<unsigned char> header(ARCHIVE_MAGIC, ARCHIVE_MAGIC + 4);
+    put(header, ARCHIVE_VERSION, 1);
+    put(header, 0, 3);
+    put(header, matches, 4);
+    put(header, static_cast<uint64_t>(ftell(file)), 8);
+
+    ok &= fwrite(index.data(), 1, index.size(), file) == index.size();
+    ok &= fseek(file, 0, SEEK_SET) == 0;
+    ok &= fwrite(header.data(), 1, header.size(), file) == header.size();
+    ok &= fclose(file) == 0;
+    file = nullptr;
+    return ok;
+}
+
+/* ------------------------------------------------------
+------------------ Archive functions. -------------------
+------------------------------------------------------ */
+
+bool Archive::Open(const std::string& path)
+{
+    Close();
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+        return false;
+    struct stat info;
+    if (fstat(fd, &info) != 0 || info.st_size < static_cast<off_t>(ARCHIVE_HEADER))
+    {
+        close(fd);
+        return false;
+    }
+    void* mapped = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mapped == MAP_FAILED)
+        return false;
+    data = static_cast<const unsigned char*>(mapped);
+    size = static_cast<size_t>(info.st_size);
+
+    matches = static_cast<size_t>(get(data + 8, 4));
+    index   = get(data + 12, 8);
+    if (!std::equal(ARCHIVE_MAGIC, ARCHIVE_MAGIC + 4, data) || data[4] != ARCHIVE_VERSION
+        || index > size || matches > (size - index) / RECORD)
+    {
+        Close();
+        return false;
+    }
+    return true;
+}
+
+void Archive::Close()
+{
+    if (data != nullptr)
+        munmap(const_cast<unsigned char*>(data), size);
+    data    = nullptr;
+    size    = 0;
+    matches = 0;
+}
+
+const unsigned char* Archive::Record(size_t match) const
+{
+    return data + index + match * RECORD;
+}
+
+Board::Config Archive::GetConfig(size_t match) const
+{
+    return match < matches ? getConfig(Record(match)) : Board::Config();
+}
+
+uint64_t Archive::GetLength(size_t match) const
+{
+    return match < matches ? get(Record(match) + 12, 8) : 0;
+}
+
+bool Archive::Seek(size_t match, uint64_t tick, Board::Match& m, Stream& stream) const
+{
+    if (match >= matches)
+        return false;
+    const unsigned char* record = Record(match);
+    uint64_t length    = get(record + 12, 8);
+    uint64_t entries   = get(record + 20, 8);
+    uint64_t bytes     = get(record + 28, 4);
+    uint64_t keyframes = get(record + 32, 8);
+    uint64_t count     = get(record + 40, 4);
+    uint64_t interval  = get(record + 44, 4);
+    if (tick > length || interval == 0 || tick / interval >= count
+        || entries > size || bytes > size - entries
+        || keyframes > size || count > (size - keyframes) / KEYFRAME)
+        return false;
+
+    Stream::Position position;
+    Board::Keyframe  k;
+    getKeyframe(data + keyframes + tick / interval * KEYFRAME, position, k);
+    m.Restore(k);
+    stream = Stream(data + entries, bytes);
+    stream.Seek(position);
+
+    for (uint64_t t = k.ticks; t < tick; t++)
+    {
+        unsigned char buttons;
+        if (!stream.Next(buttons))
+            return false;
+        m.Tick(buttons);
+    }
+    return true;
+}
@@ -0,0 +1,227 @@
+/*
+
+    Replays of a match. A replay stores the Config the match was played
+    with and the controller's state byte for every tick, which is all
+    Board::Match needs to play the match again exactly.
+
+    A replay file starts with a 16 byte header:
+
+        "PRPL"  magic
+        u8      version, 1
+        u16     board width
+        u16     board height
+        u32     seed
+        u16     ticks per second
+        u8      score to win
+
+    The header is followed by one entry for each time the buttons changed.
+    An entry is a varint (7 bits per byte, low bits first, high bit set on
+    all bytes but the last) of (ticks << 5 | mask). Ticks is how long the
+    previous buttons were held, and mask is which buttons then changed.
+    Buttons start released. A mask of 0 ends the file. Buttons are held for
+    dozens of ticks at a time, so a match takes a few kilobytes.
+
+    An archive packs many replays into one file for reviewing them, and
+    keeps a Board::Keyframe every so many ticks of each so that any tick
+    can be reached by restoring one and playing the rest. It is read
+    through mmap, and only the parts a seek needs are touched:
+
+        "PARC"  magic
+        u8      version, 2
+        u8[3]   reserved
+        u32     matches
+        u64     offset of the index
+
+        for each match, its replay entries then its keyframes
+
+        index, one 48 byte record per match:
+            u16 width, u16 height, u32 seed, u16 ticks per second,
+            u8 score to win, u8 reserved, u64 ticks, u64 entries offset,
+            u32 entries size, u64 keyframes offset, u32 keyframes,
+            u32 ticks between keyframes
+
+    A keyframe is a fixed size record of where the entries were at its
+    tick and the Board::Keyframe, see Replay.cpp.
+
+    Multi-byte fields are little-endian.
+
+*/
+
+#ifndef _REPLAY_BLOCK
+#define _REPLAY_BLOCK
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "Board.hpp"
+
+namespace Replay
+{
+
+// The most ticks per second the header's u16 holds. A config with more, or
+// a board over 65535 pixels wide or tall, can't be recorded.
+const uint32_t MAX_TICK_RATE = 65535;
+
+// Reads the buttons of each tick from a replay's entries.
+class Stream
+{
+public:
+    Stream() = default;
+    Stream(const unsigned char* data, size_t size);
+
+    // Buttons of the next tick, false once the entries end or are cut short.
+    bool Next(unsigned char& buttons);
+
+    // Where the stream is, so that it can be resumed from there.
+    struct Position
+    {
+        uint64_t      offset  = 0; // Of the entry whose buttons are held.
+        uint64_t      held    = 0; // Ticks they've been held.
+        unsigned char buttons = 0;
+    };
+    Position Tell() const { return position; }
+    void     Seek(const Position&);
+
+private:
+    // Decodes the entry at position.offset.
+    void Read();
+
+    const unsigned char* data = nullptr;
+    size_t               size = 0;
+
+    Position      position;
+    uint64_t      next  = 0;     // Offset of the entry after it.
+    uint64_t      ticks = 0;
+    unsigned char mask  = 0;
+    bool          valid = false;
+};
+
+class Recorder
+{
+public:
+    Recorder() = default;
+    Recorder(const Recorder&) = delete;
+    Recorder& operator=(const Recorder&) = delete;
+    ~Recorder() { Close(); }
+
+    // Creates the file and writes the header. False if it can't be written,
+    // or the config doesn't fit the header.
+    bool Open(const std::string& path, const Board::Config&);
+    bool IsOpen() const { return file != nullptr; }
+
+    // Adds the buttons of the next tick.
+    void Tick(unsigned char buttons);
+
+    // Ends the recording. False if any of it couldn't be written.
+    bool Close();
+
+    uint64_t GetTicks() const { return ticks; }
+    uint64_t GetBytes() const { return bytes; }
+
+private:
+    void Write(uint64_t ticks, unsigned char mask);
+
+    FILE*         file    = nullptr;
+    unsigned char buttons = 0;
+    uint64_t      held    = 0;
+    uint64_t      ticks   = 0;
+    uint64_t      bytes   = 0;
+};
+
+class Player
+{
+public:
+    Player() = default;
+    Player(const Player&) = delete;
+    Player& operator=(const Player&) = delete;
+
+    // Reads a whole replay. False if it can't be read or isn't a replay.
+    bool Open(const std::string& path);
+
+    const Board::Config& GetConfig() const { return config; }
+
+    // Buttons of the next tick, false once the replay has ended.
+    bool Next(unsigned char& buttons);
+
+    // Ticks played so far and in total.
+    uint64_t GetTick()   const { return tick; }
+    uint64_t GetLength() const { return length; }
+
+    // Starts again from the first tick.
+    void Rewind();
+
+    // The entries after the header.
+    const std::vector<unsigned char>& GetEntries() const { return entries; }
+
+private:
+    Board::Config              config;
+    std::vector<unsigned char> entries;
+    uint64_t                   length = 0;
+
+    Stream   stream;
+    uint64_t tick = 0;
+};
+
+class ArchiveWriter
+{
+public:
+    ArchiveWriter() = default;
+    ArchiveWriter(const ArchiveWriter&) = delete;
+    ArchiveWriter& operator=(const ArchiveWriter&) = delete;
+    ~ArchiveWriter() { Close(); }
+
+    // Creates the archive. Matches added get a keyframe every interval ticks.
+    bool Open(const std::string& path, uint32_t interval = 1200);
+    bool IsOpen() const { return file != nullptr; }
+
+    // Plays the replay to take its keyframes and appends it. False if the
+    // player's config doesn't fit the index.
+    bool Add(const Player&);
+
+    // Writes the index. False if any of the archive couldn't be written.
+    bool Close();
+
+private:
+    FILE*                      file     = nullptr;
+    uint32_t                   interval = 0;
+    uint32_t                   matches  = 0;
+    std::vector<unsigned char> index;
+    bool                       ok       = true;
+};
+
+class Archive
+{
+public:
+    Archive() = default;
+    Archive(const Archive&) = delete;
+    Archive& operator=(const Archive&) = delete;
+    ~Archive() { Close(); }
+
+    // Maps the archive and checks its index. False if it isn't an archive.
+    bool Open(const std::string& path);
+    void Close();
+
+    size_t        GetMatches() const { return matches; }
+    Board::Config GetConfig(size_t match) const;
+    uint64_t      GetLength(size_t match) const;
+
+    // Leaves a match made with GetConfig(match) as it was after the given
+    // number of ticks, and the stream reading the ticks after that. Costs a
+    // keyframe restore and fewer ticks than the keyframe interval. False if
+    // the match or tick don't exist or the archive is damaged.
+    bool Seek(size_t match, uint64_t tick, Board::Match&, Stream&) const;
+
+private:
+    const unsigned char* Record(size_t match) const;
+
+    const unsigned char* data    = nullptr;
+    size_t               size    = 0;
+    size_t               matches = 0;
+    uint64_t             index   = 0;
+};
+
+}
+
+#endif
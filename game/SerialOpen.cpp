@@ -2,7 +2,7 @@
 
 void setSerialPortFlags(struct termios&, long);
 
-int SerialOpen::port(char device[], long baudRate)
+int SerialOpen::port(const char device[], long baudRate)
 {
     // Tries opening the device for reading and writing.
     int port = open(device, O_RDWR);
@@ -25,8 +25,8 @@ namespace SerialOpen
 {
     const long DEFAULT_BAUD_RATE = 9600;
 
-    int        port(char  [], long); // Device, baud rate.
-    inline int port(char d[]) { return port(d, DEFAULT_BAUD_RATE); }
+    int        port(const char [], long); // Device, baud rate.
+    inline int port(const char d[]) { return port(d, DEFAULT_BAUD_RATE); }
 }
 
 #endif
@@ -0,0 +1,668 @@
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "Spectate.hpp"
+
+using namespace Spectate;
+
+namespace
+{
+
+const unsigned char MAGIC[4] = {'P', 'S', 'P', 'C'};
+const unsigned char VERSION  = 1;
+const size_t        HEADER   = 12;
+
+// Fixed point positions and velocities.
+const float SCALE = 16.0f;
+
+int32_t quantize(float value)
+{
+    return static_cast<int32_t>(std::lround(value * SCALE));
+}
+
+float unquantize(int32_t value)
+{
+    return static_cast<float>(value) / SCALE;
+}
+
+void toFields(const Frame& f, int32_t* fields)
+{
+    int32_t values[Encoder::FIELDS] = {
+        static_cast<int32_t>(f.tick),
+        quantize(f.paddles[0].x), quantize(f.paddles[0].y),
+        quantize(f.paddles[1].x), quantize(f.paddles[1].y),
+        quantize(f.ball.x), quantize(f.ball.y),
+        quantize(f.velocity.x), quantize(f.velocity.y),
+        f.scores[0], f.scores[1],
+        f.state, f.nextServe, f.winner
+    };
+    std::copy(values, values + Encoder::FIELDS, fields);
+}
+
+void fromFields(const int32_t* fields, Frame& f)
+{
+    f.tick       = static_cast<uint32_t>(fields[0]);
+    f.paddles[0] = {unquantize(fields[1]), unquantize(fields[2])};
+    f.paddles[1] = {unquantize(fields[3]), unquantize(fields[4])};
+    f.ball       = {unquantize(fields[5]), unquantize(fields[6])};
+    f.velocity   = {unquantize(fields[7]), unquantize(fields[8])};
+    f.scores[0]  = fields[9];
+    f.scores[1]  = fields[10];
+    f.state      = static_cast<Board::Ball::States>(fields[11]);
+    f.nextServe  = static_cast<Board::Ball::Players>(fields[12]);
+    f.winner     = static_cast<Board::Ball::Players>(fields[13]);
+}
+
+class BitWriter
+{
+public:
+    BitWriter(std::vector<unsigned char>& _out) : out(_out) {}
+
+    // Up to 32 bits, low first.
+    void Put(uint32_t value, int bits)
+    {
+        if (bits == 0)
+            return;
+        pending |= static_cast<uint64_t>(value & (0xFFFFFFFFu >> (32 - bits))) << used;
+        used    += bits;
+        for (; used >= 8; used -= 8, pending >>= 8)
+            out.push_back(static_cast<unsigned char>(pending));
+    }
+
+    void Finish()
+    {
+        if (used > 0)
+            out.push_back(static_cast<unsigned char>(pending));
+        pending = 0;
+        used    = 0;
+    }
+
+private:
+    std::vector<unsigned char>& out;
+    uint64_t pending = 0;
+    int      used    = 0;
+};
+
+class BitReader
+{
+public:
+    BitReader(const unsigned char* _in, size_t _size) : in(_in), size(_size) {}
+
+    // Reads past the end give zeros and set overrun.
+    uint32_t Get(int bits)
+    {
+        while (used < bits)
+        {
+            pending |= static_cast<uint64_t>(read < size ? in[read] : 0) << used;
+            overrun |= read >= size;
+            read++;
+            used += 8;
+        }
+        uint32_t value = static_cast<uint32_t>(pending & (0xFFFFFFFFull >> (32 - bits)));
+        pending >>= bits;
+        used     -= bits;
+        return bits == 0 ? 0 : value;
+    }
+
+    bool overrun = false;
+
+private:
+    const unsigned char* in;
+    size_t   size;
+    size_t   read    = 0;
+    uint64_t pending = 0;
+    int      used    = 0;
+};
+
+void putChange(BitWriter& bits, int32_t from, int32_t to)
+{
+    int32_t  delta  = static_cast<int32_t>(static_cast<uint32_t>(to) - static_cast<uint32_t>(from));
+    uint32_t zigzag = static_cast<uint32_t>(delta) << 1 ^ static_cast<uint32_t>(delta >> 31);
+    if (zigzag == 0)
+    {
+        bits.Put(0, 1);
+        return;
+    }
+    int length = 32 - __builtin_clz(zigzag);
+    bits.Put(1, 1);
+    bits.Put(length - 1, 5);
+    bits.Put(zigzag, length - 1);
+}
+
+int32_t getChange(BitReader& bits, int32_t from)
+{
+    if (bits.Get(1) == 0)
+        return from;
+    int      length = static_cast<int>(bits.Get(5)) + 1;
+    uint32_t zigzag = bits.Get(length - 1) | 1u << (length - 1);
+    int32_t  delta  = static_cast<int32_t>(zigzag >> 1 ^ (0u - (zigzag & 1)));
+    return static_cast<int32_t>(static_cast<uint32_t>(from) + static_cast<uint32_t>(delta));
+}
+
+void put16(std::vector<unsigned char>& out, uint32_t value)
+{
+    out.push_back(static_cast<unsigned char>(value));
+    out.push_back(static_cast<unsigned char>(value >> 8));
+}
+
+}
+
+/* ------------------------------------------------------
+------------------- Frame functions. --------------------
+------------------------------------------------------ */
+
+Frame::Frame(const Board::Keyframe& k)
+    : tick(static_cast<uint32_t>(k.ticks)), ball(k.ball), velocity(k.velocity),
+      state(k.state), nextServe(k.nextServe), winner(k.winner)
+{
+    paddles[0] = k.paddles[0];
+    paddles[1] = k.paddles[1];
+    scores[0]  = k.scores[0];
+    scores[1]  = k.scores[1];
+}
+
+void Frame::Apply(Board::State& s) const
+{
+    s.paddles[0].pos = paddles[0];
+    s.paddles[1].pos = paddles[1];
+    s.ball.pos       = ball;
+    s.velocity       = velocity;
+    s.scores[0]      = scores[0];
+    s.scores[1]      = scores[1];
+    s.state          = state;
+    s.nextServe      = nextServe;
+    s.winner         = winner;
+}
+
+/* ------------------------------------------------------
+------------ Encoder and Decoder functions. -------------
+------------------------------------------------------ */
+
+void Encoder::Header(const Board::Config& config, std::vector<unsigned char>& out)
+{
+    out.insert(out.end(), MAGIC, MAGIC + 4);
+    out.push_back(VERSION);
+    put16(out, static_cast<uint32_t>(config.size.x));
+    put16(out, static_cast<uint32_t>(config.size.y));
+    put16(out, config.tickRate);
+    out.push_back(static_cast<unsigned char>(config.maxScore));
+}
+
+void Encoder::Encode(const Frame& f, bool keyframe, std::vector<unsigned char>& out)
+{
+    keyframe = keyframe || !started;
+    if (keyframe)
+        std::fill(last, last + FIELDS, 0);
+    started = true;
+
+    int32_t fields[FIELDS];
+    toFields(f, fields);
+
+    // The length is filled in once known.
+    size_t start = out.size();
+    out.push_back(0);
+    BitWriter bits(out);
+    bits.Put(keyframe, 1);
+    for (int i = 0; i < FIELDS; i++)
+    {
+        putChange(bits, last[i], fields[i]);
+        last[i] = fields[i];
+    }
+    bits.Finish();
+    out[start] = static_cast<unsigned char>(out.size() - start - 1);
+}
+
+void Decoder::Feed(const unsigned char* data, size_t size)
+{
+    // Drops what has been read once it's most of the buffer.
+    if (read > 4096 && read > bytes.size() / 2)
+    {
+        bytes.erase(bytes.begin(), bytes.begin() + static_cast<long>(read));
+        read = 0;
+    }
+    bytes.insert(bytes.end(), data, data + size);
+}
+
+bool Decoder::Next(Frame& f)
+{
+    if (damaged)
+        return false;
+
+    if (!hasConfig)
+    {
+        if (bytes.size() - read < HEADER)
+            return false;
+        const unsigned char* h = bytes.data() + read;
+        if (memcmp(h, MAGIC, 4) != 0 || h[4] != VERSION)
+        {
+            damaged = true;
+            return false;
+        }
+        config.size     = {h[5] | h[6] << 8, h[7] | h[8] << 8};
+        config.tickRate = static_cast<uint32_t>(h[9] | h[10] << 8);
+        config.maxScore = h[11];
+        hasConfig = true;
+        read     += HEADER;
+    }
+
+    while (read < bytes.size() && read + 1 + bytes[read] <= bytes.size())
+    {
+        size_t    length = bytes[read];
+        BitReader bits(bytes.data() + read + 1, length);
+        read += 1 + length;
+
+        bool keyframe = bits.Get(1);
+        if (!keyframe && !started)
+            continue;
+        if (keyframe)
+            std::fill(last, last + Encoder::FIELDS, 0);
+        int32_t fields[Encoder::FIELDS];
+        for (int i = 0; i < Encoder::FIELDS; i++)
+            fields[i] = getChange(bits, last[i]);
+        if (bits.overrun)
+        {
+            damaged = true;
+            return false;
+        }
+        std::copy(fields, fields + Encoder::FIELDS, last);
+        started = true;
+        fromFields(fields, f);
+        return true;
+    }
+    return false;
+}
+
+/* ------------------------------------------------------
+------------------- Server functions. -------------------
+------------------------------------------------------ */
+
+bool Server::Open(uint16_t port, const Board::Config& config)
+{
+    // The header keeps the board and tick rate in 16 bits each.
+    if (config.size.x < 0 || config.size.x > 65535 || config.size.y < 0 || config.size.y > 65535
+        || config.tickRate > 65535)
+    {
+        std::cerr << "Matches are sent to spectators at 65535 ticks a second at most." << std::endl;
+        return false;
+    }
+
+    header.clear();
+    Encoder::Header(config, header);
+    keyframeInterval = std::max<uint32_t>(config.tickRate, 1);
+
+    // Spectators may come over IPv6 or IPv4, unless the host has no IPv6.
+    bool ipv6 = true;
+    listenFd  = socket(AF_INET6, SOCK_STREAM | SOCK_NONBLOCK, 0);
+    if (listenFd < 0)
+    {
+        ipv6     = false;
+        listenFd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK, 0);
+    }
+    if (listenFd < 0)
+    {
+        std::cerr << "Error " << errno << " from socket: " << strerror(errno) << std::endl;
+        return false;
+    }
+    int on = 1, off = 0;
+    setsockopt(listenFd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof on);
+
+    sockaddr_storage address = {};
+    socklen_t        length;
+    if (ipv6)
+    {
+        setsockopt(listenFd, IPPROTO_IPV6, IPV6_V6ONLY, &off, sizeof off);
+        sockaddr_in6& any = reinterpret_cast<sockaddr_in6&>(address);
+        any.sin6_family   = AF_INET6;
+        any.sin6_addr     = in6addr_any;
+        any.sin6_port     = htons(port);
+        length            = sizeof any;
+    }
+    else
+    {
+        sockaddr_in& any    = reinterpret_cast<sockaddr_in&>(address);
+        any.sin_family      = AF_INET;
+        any.sin_addr.s_addr = htonl(INADDR_ANY);
+        any.sin_port        = htons(port);
+        length              = sizeof any;
+    }
+    if (bind(listenFd, reinterpret_cast<sockaddr*>(&address), length) != 0
+        || listen(listenFd, SOMAXCONN) != 0)
+    {
+        std::cerr << "Error " << errno << " listening on port " << port << ": " << strerror(errno) << std::endl;
+        Close();
+        return false;
+    }
+
+    epollFd = epoll_create1(0);
+    wakeFd  = eventfd(0, EFD_NONBLOCK);
+    if (epollFd < 0 || wakeFd < 0)
+    {
+        std::cerr << "Error " << errno << " creating the epoll: " << strerror(errno) << std::endl;
+        Close();
+        return false;
+    }
+    epoll_event event = {};
+    event.events  = EPOLLIN;
+    event.data.fd = listenFd;
+    epoll_ctl(epollFd, EPOLL_CTL_ADD, listenFd, &event);
+    event.data.fd = wakeFd;
+    epoll_ctl(epollFd, EPOLL_CTL_ADD, wakeFd, &event);
+
+    running = true;
+    thread  = std::thread(&Server::Run, this);
+    return true;
+}
+
+void Server::Close()
+{
+    if (running)
+    {
+        running = false;
+        uint64_t one = 1;
+        write(wakeFd, &one, sizeof one);
+        thread.join();
+    }
+    for (auto& client : clients)
+        close(client.first);
+    clients.clear();
+    for (int* fd : {&listenFd, &epollFd, &wakeFd})
+    {
+        if (*fd >= 0)
+            close(*fd);
+        *fd = -1;
+    }
+}
+
+void Server::Publish(const Board::Keyframe& k)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        size_t start = pending.size();
+        bool   keyframe = published % keyframeInterval == 0;
+        encoder.Encode(Frame(k), keyframe, pending);
+        if (keyframe)
+            pendingKeyframe = static_cast<int64_t>(start);
+        stats.nFrames++;
+        stats.nBytesEncoded += pending.size() - start;
+    }
+    published++;
+
+    uint64_t one = 1;
+    write(wakeFd, &one, sizeof one);
+}
+
+Server::Stats Server::GetStats() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return stats;
+}
+
+void Server::Run()
+{
+    epoll_event events[256];
+    while (running)
+    {
+        int count = epoll_wait(epollFd, events, 256, -1);
+        bool woken = false;
+        for (int i = 0; i < count; i++)
+        {
+            int fd = events[i].data.fd;
+            if (fd == listenFd)
+                Accept();
+            else if (fd == wakeFd)
+            {
+                uint64_t n;
+                read(wakeFd, &n, sizeof n);
+                woken = true;
+            }
+            else
+            {
+                auto client = clients.find(fd);
+                if (client == clients.end())
+                    continue;
+
+                // Spectators have nothing to say, so anything but more to
+                // send means they're gone.
+                bool gone = events[i].events & (EPOLLERR | EPOLLHUP | EPOLLRDHUP);
+                if (!gone && events[i].events & EPOLLIN)
+                {
+                    char discard[256];
+                    ssize_t size;
+                    while ((size = recv(fd, discard, sizeof discard, 0)) > 0)
+                        ;
+                    gone = size == 0 || (errno != EAGAIN && errno != EWOULDBLOCK);
+                }
+                if (gone || (events[i].events & EPOLLOUT && !Flush(fd, client->second)))
+                    Drop(fd);
+            }
+        }
+
+        // Every spectator is sent from the same bytes, except those still
+        // blocked, which are sent when they can take more.
+        if (woken)
+        {
+            Take();
+            for (auto it = clients.begin(); it != clients.end(); )
+            {
+                int fd = it->first;
+                bool ok = it->second.blocked ? !Lagging(it->second) : Flush(fd, it->second);
+                ++it;
+                if (!ok)
+                    Drop(fd);
+            }
+        }
+        Trim();
+
+        std::lock_guard<std::mutex> lock(mutex);
+        stats.nClients = clients.size();
+    }
+}
+
+void Server::Take()
+{
+    int64_t key;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        taken.swap(pending);
+        key = pendingKeyframe;
+        pendingKeyframe = -1;
+    }
+    if (key >= 0)
+    {
+        keyframe    = base + buffer.size() + static_cast<uint64_t>(key);
+        hasKeyframe = true;
+    }
+    buffer.insert(buffer.end(), taken.begin(), taken.end());
+    taken.clear();
+}
+
+void Server::Accept()
+{
+    for (;;)
+    {
+        int fd = accept4(listenFd, nullptr, nullptr, SOCK_NONBLOCK);
+        if (fd < 0)
+            return;
+        int on = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof on);
+
+        epoll_event event = {};
+        event.events  = EPOLLIN | EPOLLRDHUP;
+        event.data.fd = fd;
+        if (epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &event) != 0)
+        {
+            close(fd);
+            continue;
+        }
+
+        // New spectators start at the latest keyframe. A closed spectator's
+        // fd may come back, so whatever was kept for it is replaced.
+        Client fresh;
+        fresh.offset = hasKeyframe ? keyframe : base + buffer.size();
+        Client& client = clients.insert_or_assign(fd, fresh).first->second;
+        if (!Flush(fd, client))
+            Drop(fd);
+    }
+}
+
+bool Server::Lagging(const Client& client)
+{
+    if (base + buffer.size() - client.offset <= MAX_LAG)
+        return false;
+    std::lock_guard<std::mutex> lock(mutex);
+    stats.nDropped++;
+    return true;
+}
+
+bool Server::Flush(int fd, Client& client)
+{
+    if (Lagging(client))
+        return false;
+
+    uint64_t end = base + buffer.size();
+
+    uint64_t sent = 0;
+    bool     blocked = false;
+    while (!blocked && (client.header < header.size() || client.offset < end))
+    {
+        bool    inHeader = client.header < header.size();
+        const unsigned char* data = inHeader ? header.data() + client.header : buffer.data() + (client.offset - base);
+        size_t  size = inHeader ? header.size() - client.header : static_cast<size_t>(end - client.offset);
+        ssize_t n = send(fd, data, size, MSG_NOSIGNAL);
+        if (n < 0)
+        {
+            if (errno != EAGAIN && errno != EWOULDBLOCK)
+                return false;
+            blocked = true;
+            break;
+        }
+        if (inHeader)
+            client.header += static_cast<size_t>(n);
+        else
+            client.offset += static_cast<uint64_t>(n);
+        sent += static_cast<uint64_t>(n);
+    }
+
+    // Waits to be told the socket can take more only while it can't.
+    if (blocked != client.blocked)
+    {
+        epoll_event event = {};
+        event.events  = EPOLLIN | EPOLLRDHUP | (blocked ? static_cast<uint32_t>(EPOLLOUT) : 0u);
+        event.data.fd = fd;
+        epoll_ctl(epollFd, EPOLL_CTL_MOD, fd, &event);
+        client.blocked = blocked;
+    }
+
+    if (sent > 0)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stats.nBytesSent += sent;
+    }
+    return true;
+}
+
+void Server::Drop(int fd)
+{
+    epoll_ctl(epollFd, EPOLL_CTL_DEL, fd, nullptr);
+    close(fd);
+    clients.erase(fd);
+}
+
+void Server::Trim()
+{
+    uint64_t keep = hasKeyframe ? keyframe : base + buffer.size();
+    for (auto& client : clients)
+        keep = std::min(keep, client.second.offset);
+    if (keep > base)
+    {
+        buffer.erase(buffer.begin(), buffer.begin() + static_cast<long>(keep - base));
+        base = keep;
+    }
+}
+
+/* ------------------------------------------------------
+------------------- Client functions. -------------------
+------------------------------------------------------ */
+
+Client::~Client()
+{
+    if (fd >= 0)
+        close(fd);
+}
+
+bool Client::Open(const std::string& host, uint16_t port)
+{
+    addrinfo hints = {};
+    hints.ai_family   = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    addrinfo* found;
+    std::string service = std::to_string(port);
+    int error = getaddrinfo(host.c_str(), service.c_str(), &hints, &found);
+    if (error != 0)
+    {
+        std::cerr << "Error resolving " << host << ": " << gai_strerror(error) << std::endl;
+        return false;
+    }
+    fd = socket(found->ai_family, SOCK_STREAM, 0);
+    if (fd < 0 || connect(fd, found->ai_addr, found->ai_addrlen) != 0)
+    {
+        std::cerr << "Error " << errno << " connecting to " << host << ": " << strerror(errno) << std::endl;
+        freeaddrinfo(found);
+        return false;
+    }
+    freeaddrinfo(found);
+
+    Frame f;
+    while (fd >= 0 && !decoder.HasConfig() && !decoder.IsDamaged())
+    {
+        Read(1000);
+        decoder.Next(f);
+    }
+    if (!decoder.HasConfig())
+    {
+        std::cerr << host << " isn't sending a match." << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool Client::Receive(Frame& f, int timeoutMs)
+{
+    bool got = false;
+    while (decoder.Next(f))
+        got = true;
+    if (got || fd < 0)
+        return got;
+
+    Read(timeoutMs);
+    while (decoder.Next(f))
+        got = true;
+    return got;
+}
+
+void Client::Read(int timeoutMs)
+{
+    pollfd p = {fd, POLLIN, 0};
+    if (poll(&p, 1, timeoutMs) <= 0)
+        return;
+
+    unsigned char data[4096];
+    ssize_t size = recv(fd, data, sizeof data, MSG_DONTWAIT);
+    if (size > 0)
+        decoder.Feed(data, static_cast<size_t>(size));
+    else if (size == 0 || (errno != EAGAIN && errno != EWOULDBLOCK) || decoder.IsDamaged())
+    {
+        close(fd);
+        fd = -1;
+    }
+}
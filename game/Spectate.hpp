@@ -0,0 +1,211 @@
+/*
+
+    Live matches for spectators. The server encodes the board once per tick
+    and sends the same bytes to every spectator from one epoll thread.
+
+    The stream starts with a 12 byte header:
+
+        "PSPC"  magic
+        u8      version, 1
+        u16     board width
+        u16     board height
+        u16     ticks per second
+        u8      score to win
+
+    Frames follow, each a byte with the length of its payload and then the
+    payload, a bit-packed list of 14 fields written low bits first: the
+    tick, each paddle's x and y, the ball's x and y and velocity, each
+    score, the state, the next server and the winner. Positions are in
+    1/16ths of a pixel, and velocities in 1/16ths of a pixel per second.
+
+    The payload's first bit is set for a keyframe. Then each field has a bit
+    set if it changed since the last frame, followed by the change. A
+    change is zigzag-encoded (0, -1, 1, -2... become 0, 1, 2, 3...), and
+    written as 5 bits of its bit count less one and then its bits but the
+    top one, which is always set. Keyframes hold the changes from zero, so
+    they can be decoded alone. Most ticks take 5 to 9 bytes.
+
+    There's a keyframe every second. Spectators joining start from the
+    latest one.
+
+*/
+
+#ifndef _SPECTATE_BLOCK
+#define _SPECTATE_BLOCK
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "Board.hpp"
+
+namespace Spectate
+{
+
+// What spectators see of the board.
+struct Frame
+{
+    uint32_t             tick = 0;
+    olc::vf2d            paddles[2];
+    olc::vf2d            ball;
+    olc::vf2d            velocity;
+    int                  scores[2] = {0, 0};
+    Board::Ball::States  state     = Board::Ball::SERVE;
+    Board::Ball::Players nextServe = Board::Ball::P_LEFT;
+    Board::Ball::Players winner    = Board::Ball::P_LEFT;
+
+    Frame() = default;
+    Frame(const Board::Keyframe&);
+
+    // Moves the paddles and ball of a board snapshot of the same config.
+    void Apply(Board::State&) const;
+};
+
+class Encoder
+{
+public:
+    static const int FIELDS = 14;
+
+    // Appends the stream's header.
+    static void Header(const Board::Config&, std::vector<unsigned char>& out);
+
+    // Appends the frame, a keyframe if asked for or if it's the first.
+    void Encode(const Frame&, bool keyframe, std::vector<unsigned char>& out);
+
+private:
+    int32_t last[FIELDS] = {};
+    bool    started      = false;
+};
+
+class Decoder
+{
+public:
+    // Adds bytes received.
+    void Feed(const unsigned char* data, size_t size);
+
+    // True once the header has been received.
+    bool                 HasConfig() const { return hasConfig; }
+    const Board::Config& GetConfig() const { return config; }
+
+    // The next frame received, false if there's none yet. Frames before the
+    // first keyframe are skipped.
+    bool Next(Frame&);
+
+    // True if the bytes aren't a spectator stream.
+    bool IsDamaged() const { return damaged; }
+
+private:
+    std::vector<unsigned char> bytes;
+    size_t                     read = 0;
+
+    Board::Config config;
+    bool          hasConfig = false;
+    bool          damaged   = false;
+    int32_t       last[Encoder::FIELDS] = {};
+    bool          started   = false;
+};
+
+class Server
+{
+public:
+    Server() = default;
+    Server(const Server&) = delete;
+    Server& operator=(const Server&) = delete;
+    ~Server() { Close(); }
+
+    // Listens on the port and starts the thread. False on failure, or if
+    // the config doesn't fit the stream's header.
+    bool Open(uint16_t port, const Board::Config&);
+    void Close();
+
+    // Encodes the board for every spectator. Called by one thread only.
+    void Publish(const Board::Keyframe&);
+
+    struct Stats
+    {
+        uint64_t nClients      = 0;   // Connected now.
+        uint64_t nFrames       = 0;
+        uint64_t nBytesEncoded = 0;
+        uint64_t nBytesSent    = 0;
+        uint64_t nDropped      = 0;   // Spectators too far behind.
+    };
+    Stats GetStats() const;
+
+    // Spectators this far behind are disconnected.
+    static const size_t MAX_LAG = 256 * 1024;
+
+private:
+    struct Client
+    {
+        size_t   header  = 0;     // Header bytes sent.
+        uint64_t offset  = 0;     // Stream bytes sent.
+        bool     blocked = false; // Waiting for EPOLLOUT.
+    };
+
+    void Run();
+    void Take();
+    void Accept();
+    bool Lagging(const Client&);
+    bool Flush(int fd, Client&);
+    void Drop(int fd);
+    void Trim();
+
+    // Publishing thread.
+    Encoder  encoder;
+    uint64_t published = 0;
+    uint32_t keyframeInterval = 120;
+
+    // Shared, frames encoded but not yet taken by the server thread.
+    mutable std::mutex         mutex;
+    std::vector<unsigned char> pending, taken;
+    int64_t                    pendingKeyframe = -1;  // Offset in pending.
+    Stats                      stats;
+
+    // Server thread. The stream is kept from base, the oldest byte a
+    // spectator still needs or the latest keyframe.
+    std::vector<unsigned char>      header;
+    std::vector<unsigned char>      buffer;
+    uint64_t                        base = 0;
+    uint64_t                        keyframe = 0;
+    bool                            hasKeyframe = false;
+    std::unordered_map<int, Client> clients;
+
+    int               listenFd = -1, epollFd = -1, wakeFd = -1;
+    std::atomic<bool> running{false};
+    std::thread       thread;
+};
+
+class Client
+{
+public:
+    Client() = default;
+    Client(const Client&) = delete;
+    Client& operator=(const Client&) = delete;
+    ~Client();
+
+    // Connects and waits for the header. False on failure.
+    bool Open(const std::string& host, uint16_t port);
+    const Board::Config& GetConfig() const { return decoder.GetConfig(); }
+
+    // Waits up to the timeout for frames and returns the latest. False if
+    // there were none.
+    bool Receive(Frame&, int timeoutMs);
+
+    // False once the server has gone away.
+    bool IsOpen() const { return fd >= 0; }
+
+private:
+    // Reads what has arrived, waiting up to the timeout for something.
+    void Read(int timeoutMs);
+
+    int     fd = -1;
+    Decoder decoder;
+};
+
+}
+
+#endif
@@ -0,0 +1,288 @@
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <vector>
+
+#include "Telemetry.hpp"
+
+using namespace Telemetry;
+
+namespace
+{
+
+struct CounterInfo
+{
+    const char* name;
+    const char* help;
+};
+
+struct HistogramInfo
+{
+    const char* name;
+    const char* help;
+    int         bounds;
+    double      le[MAX_BOUNDS];
+};
+
+const CounterInfo COUNTER_INFO[COUNTERS] = {
+    {"pong_serves_total",  "Balls served."},
+    {"pong_hits_total",    "Balls hit back by a paddle."},
+    {"pong_points_total",  "Points scored."},
+    {"pong_matches_total", "Matches won."}
+};
+
+const HistogramInfo HISTOGRAM_INFO[HISTOGRAMS] = {
+    {"pong_rally_hits", "Paddle hits from the serve to the goal.",
+     10, {0, 1, 2, 3, 5, 8, 13, 21, 34, 55}},
+    {"pong_goal_speed_pixels_per_second", "Speed of the ball as it left the board.",
+     10, {400, 450, 500, 550, 600, 700, 800, 1000, 1250, 1500}},
+    {"pong_hit_offset", "Where the ball hit the paddle, from -1 at its top to 1 at its bottom.",
+     10, {-0.8, -0.6, -0.4, -0.2, 0.0, 0.2, 0.4, 0.6, 0.8, 1.0}},
+    {"pong_serve_to_goal_seconds", "Time from the serve to the goal.",
+     10, {0.5, 1, 2, 3, 5, 8, 13, 21, 34, 55}},
+    {"pong_frame_time_seconds", "Time taken by each frame.",
+     11, {0.001, 0.002, 0.004, 0.008, 0.012, 0.0167, 0.02, 0.025, 0.0333, 0.05, 0.1}}
+};
+
+// Written by its thread only, and read by Collect from any.
+struct Shard
+{
+    struct Buckets
+    {
+        std::atomic<uint64_t> counts[MAX_BOUNDS + 1] = {};
+        std::atomic<double>   sum{0.0};
+    };
+
+    std::atomic<uint64_t> counters[COUNTERS] = {};
+    Buckets               histograms[HISTOGRAMS];
+    Deferred*             deferred = nullptr;
+};
+
+// Shards outlive their threads, so nothing recorded is lost.
+std::mutex                          shardsMutex;
+std::vector<std::shared_ptr<Shard>> shards;
+
+Shard& localShard()
+{
+    thread_local std::shared_ptr<Shard> shard = []
+    {
+        auto s = std::make_shared<Shard>();
+        std::lock_guard<std::mutex> lock(shardsMutex);
+        shards.push_back(s);
+        return s;
+    }();
+    return *shard;
+}
+
+template <typename T>
+void bump(std::atomic<T>& value, T by)
+{
+    value.store(value.load(std::memory_order_relaxed) + by, std::memory_order_relaxed);
+}
+
+void add(Shard& shard, Counter c, uint64_t n)
+{
+    bump(shard.counters[c], n);
+}
+
+void observe(Shard& shard, Histogram h, double value)
+{
+    const HistogramInfo& info = HISTOGRAM_INFO[h];
+    int bucket = 0;
+    while (bucket < info.bounds && value > info.le[bucket])
+        bucket++;
+
+    Shard::Buckets& buckets = shard.histograms[h];
+    bump(buckets.counts[bucket], uint64_t(1));
+    bump(buckets.sum, value);
+}
+
+bool writePrometheus(std::ostream& out, const Totals& totals)
+{
+    for (int c = 0; c < COUNTERS; c++)
+    {
+        const CounterInfo& info = COUNTER_INFO[c];
+        out << "# HELP " << info.name << " " << info.help << "\n"
+            << "# TYPE " << info.name << " counter\n"
+            << info.name << " " << totals.counters[c] << "\n";
+    }
+    for (int h = 0; h < HISTOGRAMS; h++)
+    {
+        const HistogramInfo&     info    = HISTOGRAM_INFO[h];
+        const Totals::Buckets&   buckets = totals.histograms[h];
+        out << "# HELP " << info.name << " " << info.help << "\n"
+            << "# TYPE " << info.name << " histogram\n";
+        uint64_t below = 0;
+        for (int b = 0; b < info.bounds; b++)
+        {
+            below += buckets.counts[b];
+            out << info.name << "_bucket{le=\"" << info.le[b] << "\"} " << below << "\n";
+        }
+        out << info.name << "_bucket{le=\"+Inf\"} " << buckets.count << "\n"
+            << info.name << "_sum " << buckets.sum << "\n"
+            << info.name << "_count " << buckets.count << "\n";
+    }
+    return static_cast<bool>(out);
+}
+
+bool writeCsv(std::ostream& out, const Totals& totals)
+{
+    out << "metric,le,value\n";
+    for (int c = 0; c < COUNTERS; c++)
+        out << COUNTER_INFO[c].name << ",," << totals.counters[c] << "\n";
+    for (int h = 0; h < HISTOGRAMS; h++)
+    {
+        const HistogramInfo&   info    = HISTOGRAM_INFO[h];
+        const Totals::Buckets& buckets = totals.histograms[h];
+        uint64_t below = 0;
+        for (int b = 0; b < info.bounds; b++)
+        {
+            below += buckets.counts[b];
+            out << info.name << "_bucket," << info.le[b] << "," << below << "\n";
+        }
+        out << info.name << "_bucket,+Inf," << buckets.count << "\n"
+            << info.name << "_sum,," << buckets.sum << "\n"
+            << info.name << "_count,," << buckets.count << "\n";
+    }
+    return static_cast<bool>(out);
+}
+
+}
+
+/* ------------------------------------------------------
+------------------ Recording functions. -----------------
+------------------------------------------------------ */
+
+std::atomic<bool> Telemetry::enabled{false};
+
+void Telemetry::Enable(bool on)
+{
+    enabled = on;
+}
+
+void Telemetry::AddSlow(Counter c, uint64_t n)
+{
+    Shard& shard = localShard();
+    if (shard.deferred != nullptr)
+        shard.deferred->events.push_back({false, c, static_cast<double>(n)});
+    else
+        add(shard, c, n);
+}
+
+void Telemetry::ObserveSlow(Histogram h, double value)
+{
+    Shard& shard = localShard();
+    if (shard.deferred != nullptr)
+        shard.deferred->events.push_back({true, h, value});
+    else
+        observe(shard, h, value);
+}
+
+Deferred::Scope::Scope(Deferred& deferred)
+{
+    Shard& shard   = localShard();
+    previous       = shard.deferred;
+    shard.deferred = &deferred;
+}
+
+Deferred::Scope::~Scope()
+{
+    localShard().deferred = previous;
+}
+
+void Deferred::Commit()
+{
+    Shard& shard = localShard();
+    for (const Event& e : events)
+    {
+        if (e.histogram)
+            observe(shard, static_cast<Histogram>(e.which), e.value);
+        else
+            add(shard, static_cast<Counter>(e.which), static_cast<uint64_t>(e.value));
+    }
+    events.clear();
+}
+
+/* ------------------------------------------------------
+------------------- Export functions. -------------------
+------------------------------------------------------ */
+
+Totals Telemetry::Collect()
+{
+    Totals totals;
+    std::lock_guard<std::mutex> lock(shardsMutex);
+    for (auto& shard : shards)
+    {
+        for (int c = 0; c < COUNTERS; c++)
+            totals.counters[c] += shard->counters[c].load(std::memory_order_relaxed);
+        for (int h = 0; h < HISTOGRAMS; h++)
+        {
+            Shard::Buckets&  from = shard->histograms[h];
+            Totals::Buckets& to   = totals.histograms[h];
+            for (int b = 0; b <= MAX_BOUNDS; b++)
+                to.counts[b] += from.counts[b].load(std::memory_order_relaxed);
+            to.sum += from.sum.load(std::memory_order_relaxed);
+        }
+    }
+
+    // Counts are summed from the buckets, so a shard read partway through
+    // an update still adds up.
+    for (auto& buckets : totals.histograms)
+        for (uint64_t count : buckets.counts)
+            buckets.count += count;
+    return totals;
+}
+
+bool Telemetry::Write(const std::string& path, const Totals& totals)
+{
+    // Written beside the file and renamed over it, so readers never see
+    // half of it.
+    std::string temporary = path + ".tmp";
+    {
+        std::ofstream out(temporary);
+        bool csv = path.size() >= 4 && path.compare(path.size() - 4, 4, ".csv") == 0;
+        if (!out.is_open() || !(csv ? writeCsv(out, totals) : writePrometheus(out, totals)))
+            return false;
+    }
+    return std::rename(temporary.c_str(), path.c_str()) == 0;
+}
+
+void Exporter::Start(const std::string& _path, double intervalSeconds)
+{
+    Stop();
+    path     = _path;
+    interval = intervalSeconds;
+    running  = true;
+    thread   = std::thread(&Exporter::Run, this);
+}
+
+void Exporter::Stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!running)
+            return;
+        running = false;
+    }
+    wake.notify_all();
+    thread.join();
+}
+
+void Exporter::Run()
+{
+    bool failed = false;
+    std::unique_lock<std::mutex> lock(mutex);
+    for (bool last = false; !last; )
+    {
+        wake.wait_for(lock, std::chrono::duration<double>(interval), [&] { return !running; });
+        last = !running;
+
+        lock.unlock();
+        bool ok = Write(path, Collect());
+        if (!ok && !failed)
+            std::cerr << "Error writing telemetry to " << path << "." << std::endl;
+        failed = !ok;
+        lock.lock();
+    }
+}
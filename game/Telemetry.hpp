@@ -0,0 +1,153 @@
+/*
+
+    Counters and histograms of how matches go: serves, paddle hits, points,
+    rally lengths, the ball's speed at each goal, where the ball hits the
+    paddle, the time from serve to goal and the frame time.
+
+    Every thread records into its own shard, which only that thread writes,
+    so recording takes no lock and no atomic read-modify-write. Collect sums
+    the shards, and Exporter does so every so often and writes the result
+    to a file, as CSV if it is named .csv and else in Prometheus' text
+    format, for node_exporter's textfile collector to pick up. The file is
+    replaced whole, so it's never read half written.
+
+    Nothing is recorded until Enable is called, and until then recording
+    costs a load and a branch.
+
+*/
+
+#ifndef _TELEMETRY_BLOCK
+#define _TELEMETRY_BLOCK
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace Telemetry
+{
+
+enum Counter
+{
+    SERVES,
+    HITS,
+    POINTS,
+    MATCHES,
+    COUNTERS
+};
+
+enum Histogram
+{
+    RALLY_HITS,      // Paddle hits from the serve to the goal.
+    GOAL_SPEED,      // Pixels per second.
+    HIT_OFFSET,      // Where on the paddle, -1 its top to 1 its bottom.
+    SERVE_TO_GOAL,   // Seconds.
+    FRAME_TIME,      // Seconds.
+    HISTOGRAMS
+};
+
+// Upper bounds of a histogram's buckets, past the last of which is one more.
+const int MAX_BOUNDS = 12;
+
+extern std::atomic<bool> enabled;
+
+void Enable(bool);
+
+void AddSlow(Counter, uint64_t);
+void ObserveSlow(Histogram, double);
+
+inline void Add(Counter c, uint64_t n = 1)
+{
+    if (enabled.load(std::memory_order_relaxed))
+        AddSlow(c, n);
+}
+
+inline void Observe(Histogram h, double value)
+{
+    if (enabled.load(std::memory_order_relaxed))
+        ObserveSlow(h, value);
+}
+
+// Holds what a thread records until it's known whether it happened, such
+// as the events of a tick played on predicted buttons that may be played
+// again. Commit records them into the thread's shard, and Clear drops them.
+class Deferred
+{
+public:
+    // This thread's events go to the Deferred while a Scope lives.
+    class Scope
+    {
+    public:
+        explicit Scope(Deferred&);
+        ~Scope();
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+
+    private:
+        Deferred* previous;
+    };
+
+    void Commit();
+    void Clear() { events.clear(); }
+
+private:
+    friend void AddSlow(Counter, uint64_t);
+    friend void ObserveSlow(Histogram, double);
+
+    struct Event
+    {
+        bool   histogram;
+        int    which;
+        double value;
+    };
+    std::vector<Event> events;
+};
+
+// Every thread's shard summed.
+struct Totals
+{
+    struct Buckets
+    {
+        uint64_t counts[MAX_BOUNDS + 1] = {};
+        uint64_t count = 0;
+        double   sum   = 0.0;
+    };
+
+    uint64_t counters[COUNTERS] = {};
+    Buckets  histograms[HISTOGRAMS];
+};
+
+Totals Collect();
+
+// Writes the totals to the file, false on failure.
+bool Write(const std::string& path, const Totals&);
+
+// Writes the totals to a file every interval, and once more on Stop.
+class Exporter
+{
+public:
+    Exporter() = default;
+    Exporter(const Exporter&) = delete;
+    Exporter& operator=(const Exporter&) = delete;
+    ~Exporter() { Stop(); }
+
+    void Start(const std::string& path, double intervalSeconds);
+    void Stop();
+
+private:
+    void Run();
+
+    std::string             path;
+    double                  interval = 10.0;
+    std::mutex              mutex;
+    std::condition_variable wake;
+    bool                    running = false;
+    std::thread             thread;
+};
+
+}
+
+#endif
@@ -0,0 +1,496 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+#include "Tournament.hpp"
+
+using namespace Tournament;
+
+namespace
+{
+
+/* ------------------------------------------------------
+--------------------- Pool functions. -------------------
+------------------------------------------------------ */
+
+// Threads with a queue each. A task pushed from one of the pool's threads
+// goes on that thread's queue, and any other round robin. A thread takes
+// the oldest task of its own queue first, so earlier matches of a series
+// run before later ones, and steals the oldest of another's when its own
+// is empty. Spare tasks, which may turn out not to be needed, share one
+// queue and are only taken when every other is empty.
+class StealingPool
+{
+public:
+    using Task = std::function<void()>;
+
+    StealingPool(uint32_t nThreads);
+    ~StealingPool();
+
+    void Push(Task, bool spare = false);
+
+    // Returns once every task pushed, and every task they pushed, has run.
+    void Wait();
+
+private:
+    struct Queue
+    {
+        std::mutex       mutex;
+        std::deque<Task> tasks;
+    };
+
+    void Work(uint32_t self);
+    bool Take(uint32_t self, Task&);
+
+    std::vector<std::unique_ptr<Queue>> queues;
+    Queue                               spares;
+    std::vector<std::thread>            threads;
+
+    std::mutex              mutex;
+    std::condition_variable wake, done;
+    std::atomic<uint64_t>   queued{0};        // Tasks in the queues.
+    std::atomic<uint64_t>   outstanding{0};   // Tasks queued or running.
+    uint32_t                next = 0;         // Queue of the next task from outside.
+    bool                    stopping = false;
+
+    // The queue of the pool's thread that's running, if any.
+    static thread_local const StealingPool* current;
+    static thread_local uint32_t            currentQueue;
+};
+
+thread_local const StealingPool* StealingPool::current      = nullptr;
+thread_local uint32_t            StealingPool::currentQueue = 0;
+
+StealingPool::StealingPool(uint32_t nThreads)
+{
+    for (uint32_t i = 0; i < nThreads; i++)
+        queues.push_back(std::make_unique<Queue>());
+    for (uint32_t i = 0; i < nThreads; i++)
+        threads.emplace_back(&StealingPool::Work, this, i);
+}
+
+StealingPool::~StealingPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (auto& thread : threads)
+        thread.join();
+}
+
+void StealingPool::Push(Task task, bool spare)
+{
+    Queue* queue = &spares;
+    if (!spare && current == this)
+        queue = queues[currentQueue].get();
+    else if (!spare)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        queue = queues[next++ % queues.size()].get();
+    }
+
+    outstanding++;
+    {
+        std::lock_guard<std::mutex> lock(queue->mutex);
+        queue->tasks.push_back(std::move(task));
+    }
+    {
+        // Counted under the lock the threads sleep on, so none misses it.
+        std::lock_guard<std::mutex> lock(mutex);
+        queued++;
+    }
+    wake.notify_one();
+}
+
+void StealingPool::Wait()
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    done.wait(lock, [&] { return outstanding == 0; });
+}
+
+bool StealingPool::Take(uint32_t self, Task& task)
+{
+    for (size_t i = 0; i <= queues.size(); i++)
+    {
+        Queue& queue = i < queues.size() ? *queues[(self + i) % queues.size()] : spares;
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if (!queue.tasks.empty())
+        {
+            task = std::move(queue.tasks.front());
+            queue.tasks.pop_front();
+            queued--;
+            return true;
+        }
+    }
+    return false;
+}
+
+void StealingPool::Work(uint32_t self)
+{
+    current      = this;
+    currentQueue = self;
+    for (;;)
+    {
+        Task task;
+        if (Take(self, task))
+        {
+            task();
+            if (--outstanding == 0)
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                done.notify_all();
+            }
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(mutex);
+        wake.wait(lock, [&] { return queued > 0 || stopping; });
+        if (stopping)
+            return;
+    }
+}
+
+/* ------------------------------------------------------
+-------------------- Bracket functions. -----------------
+------------------------------------------------------ */
+
+// A series as it's played.
+struct Entry
+{
+    Series                series;
+    int                   feeders[2] = {-1, -1};   // Series whose winners play it.
+    std::vector<uint32_t> next;                    // Series waiting on this one.
+    uint32_t              waiting = 0;
+    std::vector<int8_t>   results;                 // Winner of each match, -1 until played.
+    uint32_t              needed = 0;              // Matches queued as needed.
+    std::atomic<bool>     decided{false};
+    std::unique_ptr<std::atomic<bool>[]> claimed;  // Whether each match was taken.
+};
+
+void wait(std::deque<Entry>& entries, uint32_t id, uint32_t on)
+{
+    entries[on].next.push_back(id);
+    entries[id].waiting++;
+}
+
+// Everyone plays everyone once, by the circle method: one player stays put
+// and the others turn around it a place each round. With an odd number,
+// whoever is drawn against the empty place sits the round out.
+void roundRobin(std::deque<Entry>& entries, int nPlayers)
+{
+    int n = nPlayers + nPlayers % 2;
+    std::vector<int> circle(n);
+    for (int i = 0; i < n; i++)
+        circle[i] = i < nPlayers ? i : -1;
+
+    std::vector<int> last(nPlayers, -1);
+    for (int round = 0; round < n - 1; round++)
+    {
+        for (int i = 0; i < n / 2; i++)
+        {
+            int a = circle[i], b = circle[n - 1 - i];
+            if (a < 0 || b < 0)
+                continue;
+
+            uint32_t id = static_cast<uint32_t>(entries.size());
+            entries.emplace_back();
+            entries[id].series.round      = static_cast<uint32_t>(round);
+            entries[id].series.players[0] = a;
+            entries[id].series.players[1] = b;
+            for (int player : {a, b})
+            {
+                if (last[player] >= 0)
+                    wait(entries, id, static_cast<uint32_t>(last[player]));
+                last[player] = static_cast<int>(id);
+            }
+        }
+        std::rotate(circle.begin() + 1, circle.end() - 1, circle.end());
+    }
+}
+
+// Single elimination. Seeds are placed so the top two can only meet in the
+// final, and the byes go to the top seeds in the first round.
+void elimination(std::deque<Entry>& entries, int nPlayers)
+{
+    std::vector<int> seeds = {0};
+    while (seeds.size() < static_cast<size_t>(nPlayers))
+    {
+        std::vector<int> more;
+        int size = static_cast<int>(seeds.size()) * 2;
+        for (int seed : seeds)
+        {
+            more.push_back(seed);
+            more.push_back(size - 1 - seed);
+        }
+        seeds = more;
+    }
+
+    // Who's in each place of the round: a player, the winner of a series,
+    // or a bye.
+    struct Place
+    {
+        enum {PLAYER, WINNER, BYE} kind;
+        int id;
+    };
+    std::vector<Place> places;
+    for (int seed : seeds)
+        places.push_back(seed < nPlayers ? Place{Place::PLAYER, seed} : Place{Place::BYE, -1});
+
+    for (uint32_t round = 0; places.size() > 1; round++)
+    {
+        std::vector<Place> next;
+        for (size_t i = 0; i < places.size(); i += 2)
+        {
+            const Place* pair = &places[i];
+            if (pair[0].kind == Place::BYE || pair[1].kind == Place::BYE)
+            {
+                next.push_back(pair[0].kind == Place::BYE ? pair[1] : pair[0]);
+                continue;
+            }
+
+            uint32_t id = static_cast<uint32_t>(entries.size());
+            entries.emplace_back();
+            entries[id].series.round = round;
+            for (int k = 0; k < 2; k++)
+            {
+                if (pair[k].kind == Place::PLAYER)
+                    entries[id].series.players[k] = pair[k].id;
+                else
+                {
+                    entries[id].feeders[k] = pair[k].id;
+                    wait(entries, id, static_cast<uint32_t>(pair[k].id));
+                }
+            }
+            next.push_back(Place{Place::WINNER, static_cast<int>(id)});
+        }
+        places = next;
+    }
+}
+
+/* ------------------------------------------------------
+--------------------- Match functions. ------------------
+------------------------------------------------------ */
+
+// 0 if the left player won. When time runs out the leader wins, or
+// whoever scored last if it's level. If nobody has scored, a coin seeded
+// from the match decides, as the board would have it the left player.
+int play(const Options& options, const Player& left, const Player& right, uint64_t key)
+{
+    Board::Config config = options.rules;
+    config.seed = Board::MixSeed(key * 3);
+    Board::Match   match(config);
+    AI::Controller l(config, Board::Ball::P_LEFT, left.difficulty, Board::MixSeed(key * 3 + 1));
+    AI::Controller r(config, Board::Ball::P_RIGHT, right.difficulty, Board::MixSeed(key * 3 + 2));
+
+    uint64_t limit = static_cast<uint64_t>(options.maxSeconds * config.tickRate);
+    Board::State s;
+    match.Snapshot(s);
+    while (s.state != Board::Ball::WIN && match.GetTicks() < limit)
+    {
+        match.Tick(l.Decide(s) | r.Decide(s));
+        match.Snapshot(s);
+    }
+    if (s.scores[0] != s.scores[1])
+        return s.scores[0] > s.scores[1] ? 0 : 1;
+    if (s.scores[0] == 0)
+        return static_cast<int>(Board::MixSeed(~key) & 1);
+    return s.winner == Board::Ball::P_LEFT ? 0 : 1;
+}
+
+struct Schedule
+{
+    const std::vector<Player>& players;
+    const Options&             options;
+    std::deque<Entry>          entries;
+    StealingPool               pool;
+
+    std::mutex            mutex;   // Over the entries' results.
+    std::atomic<uint64_t> played{0};
+
+    Schedule(const std::vector<Player>& _players, const Options& _options, uint32_t threads)
+        : players(_players), options(_options), pool(threads) {}
+
+    // Queues as many matches as it takes to win the series, and the rest
+    // as spares, so threads with nothing else to do can play them while
+    // the first are still deciding it.
+    void start(uint32_t id)
+    {
+        Entry& entry = entries[id];
+        entry.results.assign(options.bestOf, -1);
+        entry.claimed.reset(new std::atomic<bool>[options.bestOf]());
+        for (uint32_t game = 0; game < options.bestOf; game++)
+            pool.Push([this, id, game] { match(id, game); }, game >= majority());
+        entry.needed = majority();
+    }
+
+    uint32_t majority() const { return options.bestOf / 2 + 1; }
+
+    void match(uint32_t id, uint32_t game)
+    {
+        Entry& entry = entries[id];
+        if (entry.decided || entry.claimed[game].exchange(true))
+            return;
+
+        const int* p   = entry.series.players;
+        uint64_t   key = (static_cast<uint64_t>(options.rules.seed) << 40) ^ (uint64_t(id) << 8 | game);
+        int first = game % 2 == 0 ? 0 : 1;
+        int left  = play(options, players[p[first]], players[p[1 - first]], key);
+        int won   = left == 0 ? first : 1 - first;
+        played++;
+
+        std::lock_guard<std::mutex> lock(mutex);
+        entry.results[game] = static_cast<int8_t>(won);
+
+        // Matches count in order, up to the one that decides the series,
+        // so it comes out as if they had been played one at a time.
+        Series& series = entry.series;
+        while (!entry.decided && series.games.size() < entry.results.size()
+               && entry.results[series.games.size()] >= 0)
+        {
+            int w = entry.results[series.games.size()];
+            series.games.push_back(static_cast<uint8_t>(w));
+            if (++series.wins[w] == static_cast<int>(majority()))
+                decide(id, w);
+        }
+        if (entry.decided)
+            return;
+
+        // Neither can win in fewer matches than the leader needs, so those
+        // are needed whatever happens. Any spare among them is queued
+        // again, to be played by whoever takes it first.
+        uint32_t lead   = static_cast<uint32_t>(std::max(series.wins[0], series.wins[1]));
+        uint32_t needed = static_cast<uint32_t>(series.games.size()) + majority() - lead;
+        for (; entry.needed < needed; entry.needed++)
+        {
+            uint32_t next = entry.needed;
+            pool.Push([this, id, next] { match(id, next); });
+        }
+    }
+
+    void decide(uint32_t id, int winner)
+    {
+        Entry& entry = entries[id];
+        entry.series.winner = winner;
+        entry.decided       = true;
+        for (uint32_t n : entry.next)
+        {
+            Entry& after = entries[n];
+            for (int k = 0; k < 2; k++)
+                if (after.feeders[k] == static_cast<int>(id))
+                    after.series.players[k] = entry.series.players[winner];
+            if (--after.waiting == 0)
+                start(n);
+        }
+    }
+};
+
+void rate(const Options& options, Results& results, size_t nPlayers)
+{
+    std::vector<Standing>& standings = results.standings;
+    standings.assign(nPlayers, Standing{});
+    for (size_t i = 0; i < nPlayers; i++)
+    {
+        standings[i].player = static_cast<int>(i);
+        standings[i].rating = options.rating;
+    }
+
+    for (const Series& series : results.series)
+    {
+        Standing& a = standings[series.players[0]];
+        Standing& b = standings[series.players[1]];
+        for (uint8_t w : series.games)
+        {
+            double expected = 1.0 / (1.0 + std::pow(10.0, (b.rating - a.rating) / 400.0));
+            double score    = w == 0 ? 1.0 : 0.0;
+            a.rating += options.kFactor * (score - expected);
+            b.rating -= options.kFactor * (score - expected);
+        }
+        a.matchesWon  += static_cast<uint32_t>(series.wins[0]);
+        a.matchesLost += static_cast<uint32_t>(series.wins[1]);
+        b.matchesWon  += static_cast<uint32_t>(series.wins[1]);
+        b.matchesLost += static_cast<uint32_t>(series.wins[0]);
+        (series.winner == 0 ? a : b).seriesWon++;
+        (series.winner == 0 ? b : a).seriesLost++;
+    }
+
+    std::stable_sort(standings.begin(), standings.end(), [](const Standing& x, const Standing& y)
+    {
+        return x.rating > y.rating;
+    });
+}
+
+}
+
+/* ------------------------------------------------------
+------------------ Tournament functions. ----------------
+------------------------------------------------------ */
+
+bool Tournament::Run(const std::vector<Player>& players, const Options& options, Results& results)
+{
+    if (players.size() < 2 || players.size() > 1024)
+    {
+        std::cerr << "A tournament takes from 2 to 1024 players." << std::endl;
+        return false;
+    }
+    if (options.bestOf % 2 == 0 || options.bestOf > 127)
+    {
+        std::cerr << "Series must be best of an odd number of matches, up to 127." << std::endl;
+        return false;
+    }
+    // The time limit becomes a number of ticks. NaN fails the comparison.
+    if (!(options.maxSeconds > 0.0 && options.maxSeconds <= 86400.0) || options.rules.tickRate == 0)
+    {
+        std::cerr << "Matches must have a tick rate, and over 0 and up to 86400 seconds to be played."
+                  << std::endl;
+        return false;
+    }
+    if (options.threads > 1024)
+    {
+        std::cerr << "A tournament runs on up to 1024 threads." << std::endl;
+        return false;
+    }
+
+    uint32_t threads = options.threads ? options.threads : std::max(1u, std::thread::hardware_concurrency());
+    auto start = std::chrono::steady_clock::now();
+    {
+        Schedule run(players, options, threads);
+        int n = static_cast<int>(players.size());
+        if (options.format == ROUND_ROBIN)
+            roundRobin(run.entries, n);
+        else
+            elimination(run.entries, n);
+
+        // Under the lock, so series that finish early don't start the ones
+        // after them while this is still going through them.
+        {
+            std::lock_guard<std::mutex> lock(run.mutex);
+            for (uint32_t id = 0; id < run.entries.size(); id++)
+                if (run.entries[id].waiting == 0)
+                    run.start(id);
+        }
+        run.pool.Wait();
+
+        results.series.clear();
+        for (const Entry& entry : run.entries)
+            results.series.push_back(entry.series);
+        results.played = run.played;
+    }
+    results.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    results.threads = threads;
+
+    results.counted = 0;
+    for (const Series& series : results.series)
+        results.counted += series.games.size();
+    rate(options, results, players.size());
+    return true;
+}
@@ -0,0 +1,96 @@
+/*
+
+    Tournaments between computer players, for comparing them: a round
+    robin, where everyone plays everyone, or a single elimination bracket
+    seeded in the order the players are given, with byes for the top seeds
+    when their number isn't a power of two. Every pairing is a best of N
+    series of headless matches, with the players swapping sides each match.
+
+    The bracket is expanded into series up front, each waiting on the ones
+    before it: in a bracket the two whose winners it's between, and in a
+    round robin each player's series of the round before. A series starts
+    as soon as those have finished rather than when the whole round has.
+    The matches run on a work stealing pool, where each thread queues the
+    matches of the series it starts and takes from the others when its own
+    queue runs dry. Only the matches a series is sure to need are queued
+    as work; the rest are spares, played by threads that would otherwise
+    sit idle, so the cores stay busy while a round drains. Only as many
+    matches as decide a series count, so a spare is sometimes wasted, but
+    never instead of a match that was needed.
+
+    Every match's serves and computer errors are seeded from the series
+    and match, and Elo ratings are worked out afterwards in the order the
+    series were expanded, so a tournament comes out the same however many
+    threads run it.
+
+*/
+
+#ifndef _TOURNAMENT_BLOCK
+#define _TOURNAMENT_BLOCK
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "AI.hpp"
+#include "Board.hpp"
+
+namespace Tournament
+{
+
+enum Formats {ROUND_ROBIN, ELIMINATION};
+
+struct Player
+{
+    std::string    name;
+    AI::Difficulty difficulty;
+};
+
+struct Options
+{
+    Formats       format     = ROUND_ROBIN;
+    uint32_t      bestOf     = 5;        // Odd.
+    Board::Config rules;                 // Its seed seeds every match.
+    double        maxSeconds = 600.0;    // Of play, after which the leader wins,
+                                         // or a seeded coin toss if no one scored.
+    uint32_t      threads    = 0;        // Every core.
+    double        rating     = 1500.0;   // Everyone's rating to start.
+    double        kFactor    = 32.0;
+};
+
+// players[0] plays on the left in the even matches, and on the right in
+// the odd ones.
+struct Series
+{
+    uint32_t             round      = 0;
+    int                  players[2] = {-1, -1};   // Indices of the players.
+    int                  wins[2]    = {0, 0};     // Matches that counted.
+    int                  winner     = -1;         // 0 or 1, of players.
+    std::vector<uint8_t> games;                   // Who won each that counted.
+};
+
+struct Standing
+{
+    int      player;
+    double   rating;
+    uint32_t seriesWon, seriesLost;
+    uint32_t matchesWon, matchesLost;
+};
+
+struct Results
+{
+    std::vector<Series>   series;      // In rounds.
+    std::vector<Standing> standings;   // Best rated first.
+    uint64_t              played = 0;  // Matches, counted or not.
+    uint64_t              counted = 0;
+    double                seconds = 0.0;
+    uint32_t              threads = 0;
+};
+
+// Plays a tournament. False, with nothing played, if the options are
+// wrong.
+bool Run(const std::vector<Player>&, const Options&, Results&);
+
+}
+
+#endif
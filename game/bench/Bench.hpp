@@ -0,0 +1,136 @@
+/*
+
+    Minimal micro-benchmark harness. Each case is warmed up, then timed in
+    batches large enough to swamp the clock's resolution. The per-call times
+    of the batches are summarised by their median and median absolute
+    deviation (MAD), which shrug off the odd preempted batch, and printed as
+    one JSON object per line so runs can be diffed and plotted.
+
+*/
+
+#ifndef _BENCH_BLOCK
+#define _BENCH_BLOCK
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace Bench
+{
+
+struct Result
+{
+    std::string name;
+    double      median;  // ns per call.
+    double      mad;     // ns per call.
+    double      min;     // ns per call.
+    uint64_t    batch;   // Calls per sample.
+    size_t      samples;
+};
+
+// Keeps the compiler from optimising a result away.
+template <class T>
+inline void DoNotOptimize(T const& value)
+{
+    asm volatile("" : : "r,m"(value) : "memory");
+}
+
+inline void ClobberMemory()
+{
+    asm volatile("" : : : "memory");
+}
+
+struct Options
+{
+    double warmupSeconds = 0.1;
+    double sampleSeconds = 0.005;
+    size_t samples       = 51;
+};
+
+template <class F>
+Result Run(const std::string& name, F&& f, Options options = Options())
+{
+    using Clock = std::chrono::steady_clock;
+    auto secondsSince = [](Clock::time_point t)
+    {
+        return std::chrono::duration<double>(Clock::now() - t).count();
+    };
+
+    // Warms caches, branch predictors and clocks, and sizes the batches.
+    uint64_t calls = 0;
+    auto start = Clock::now();
+    while (secondsSince(start) < options.warmupSeconds)
+    {
+        f();
+        calls++;
+    }
+    double perCall = options.warmupSeconds / static_cast<double>(std::max<uint64_t>(calls, 1));
+    uint64_t batch = std::max<uint64_t>(1, static_cast<uint64_t>(options.sampleSeconds / perCall));
+
+    std::vector<double> times;
+    for (size_t s = 0; s < options.samples; s++)
+    {
+        auto t = Clock::now();
+        for (uint64_t i = 0; i < batch; i++)
+            f();
+        ClobberMemory();
+        times.push_back(secondsSince(t) * 1e9 / static_cast<double>(batch));
+    }
+
+    auto median = [](std::vector<double> v)
+    {
+        std::nth_element(v.begin(), v.begin() + v.size() / 2, v.end());
+        return v[v.size() / 2];
+    };
+
+    Result r;
+    r.name    = name;
+    r.median  = median(times);
+    r.min     = *std::min_element(times.begin(), times.end());
+    r.batch   = batch;
+    r.samples = times.size();
+    for (auto& t : times)
+        t = std::abs(t - r.median);
+    r.mad = median(times);
+    return r;
+}
+
+// Describes the build, as the first line of a run, so results from
+// different compilers and flags aren't compared by mistake.
+inline void PrintContext(std::ostream& os = std::cout)
+{
+    os << "{\"context\":{\"compiler\":\"" << __VERSION__ << "\""
+#if defined(__OPTIMIZE__)
+       << ",\"optimized\":true"
+#else
+       << ",\"optimized\":false"
+#endif
+#if defined(__AVX2__)
+       << ",\"simd\":\"avx2\""
+#elif defined(__SSE2__)
+       << ",\"simd\":\"sse2\""
+#else
+       << ",\"simd\":\"none\""
+#endif
+       << "}}" << std::endl;
+}
+
+inline void Print(const Result& r, std::ostream& os = std::cout)
+{
+    os << "{\"name\":\"" << r.name << "\""
+       << ",\"unit\":\"ns\""
+       << ",\"median\":" << r.median
+       << ",\"mad\":"    << r.mad
+       << ",\"min\":"    << r.min
+       << ",\"batch\":"  << r.batch
+       << ",\"samples\":" << r.samples
+       << "}" << std::endl;
+}
+
+}
+
+#endif
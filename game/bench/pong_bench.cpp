@@ -0,0 +1,292 @@
+/*
+
+    Benchmarks for the game's hot paths, built against a headless engine by
+    `make pong_bench` and run by `make bench`.
+
+    Run with a substring as the only argument to run the matching cases only.
+
+*/
+
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../olcPixelGameEngine.hpp"
+#include "../AI.hpp"
+#include "../Board.hpp"
+#include "../Spectate.hpp"
+#include "../Telemetry.hpp"
+#include "../../controller/controller-info.hpp"
+#include "Bench.hpp"
+
+// Engine that is never started; it only provides the drawing routines.
+class BenchEngine : public olc::PixelGameEngine
+{
+public:
+    BenchEngine() { sAppName = "pong_bench"; }
+};
+
+int main(int argc, char* argv[])
+{
+    std::string filter = argc > 1 ? argv[1] : "";
+    Bench::PrintContext();
+    auto run = [&](const std::string& name, auto&& f, Bench::Options options = Bench::Options())
+    {
+        if (name.find(filter) != std::string::npos)
+            Bench::Print(Bench::Run(name, f, options));
+    };
+
+    BenchEngine game;
+    game.Construct(1080, 720, 1, 1);
+    game.olc_ConstructFontSheet();
+
+    olc::Sprite target(1080, 720);
+    game.SetDrawTarget(&target);
+
+    /* Game logic, on the board the game starts with. */
+
+    Board::Config config;
+    bool buttons[NUM_BUTTONS] = {};
+    Board::Paddle left(config, 24.0f, &buttons[0], &buttons[1]);
+    Board::Paddle right(config, 1080.0f - 24.0f, &buttons[3], &buttons[4]);
+    Board::Ball ball(config, &buttons[2]);
+    ball.AddPaddle(left);
+    ball.AddPaddle(right);
+
+    // A ball overlapping the left paddle's face.
+    Board::Ball bouncer(config, &buttons[2]);
+    olc::vf2d bouncePos = left.pos + olc::vf2d{10.0f, 50.0f};
+    left.UpdateEdges();
+
+    run("Rectangle::CollidingWith", [&]
+    {
+        bouncer.pos.y += 1.0f;
+        if (bouncer.pos.y > 720.0f) bouncer.pos.y = 0.0f;
+        bouncer.UpdateEdges();
+        Bench::DoNotOptimize(bouncer.CollidingWith(left));
+    });
+    uint32_t step = 0;
+    run("Rectangle::KeepInbound", [&]
+    {
+        // Alternates between in bounds and off each edge.
+        const olc::vf2d positions[] = {{500, 300}, {-5, 300}, {500, -5}, {1100, 300}, {500, 800}};
+        bouncer.pos = positions[step++ % 5];
+        Bench::DoNotOptimize(bouncer.KeepInbound());
+    });
+    run("Ball::BounceOn", [&]
+    {
+        bouncer.pos = bouncePos;
+        bouncer.UpdateEdges();
+        bouncer.BounceOn(left);
+        Bench::DoNotOptimize(bouncer.pos);
+    });
+    run("Ball::Update", [&]
+    {
+        // Pressing serve every other tick keeps the ball in play after a point.
+        buttons[2] = !buttons[2];
+        ball.Update(1.0f / 240.0f);
+        Bench::DoNotOptimize(ball.pos);
+    });
+    // The same, recording telemetry of every serve, hit and goal.
+    Telemetry::Enable(true);
+    run("Ball::Update/telemetry", [&]
+    {
+        buttons[2] = !buttons[2];
+        ball.Update(1.0f / 240.0f);
+        Bench::DoNotOptimize(ball.pos);
+    });
+    Telemetry::Enable(false);
+    Board::Match match(config);
+    run("Match::Tick", [&]
+    {
+        match.Tick(match.GetTicks() % 2 ? 1 << Board::SERVE : 0);
+        Bench::DoNotOptimize(match);
+    });
+    // Snapshots on their own, for how many a frame can afford.
+    Board::Keyframe snapshot;
+    run("Match::Save", [&]
+    {
+        match.Save(snapshot);
+        Bench::DoNotOptimize(snapshot);
+    });
+    run("Match::Restore", [&]
+    {
+        match.Restore(snapshot);
+        Bench::DoNotOptimize(match);
+    });
+    // What a rollback as deep as two-host play allows by default costs.
+    Board::Keyframe keyframes[12];
+    match.Save(keyframes[0]);
+    run("Match::Restore+12 ticks", [&]
+    {
+        match.Restore(keyframes[0]);
+        for (int i = 0; i < 12; i++)
+        {
+            if (i > 0)
+                match.Save(keyframes[i]);
+            match.Tick(i % 2 ? 1 << Board::SERVE : 1 << Board::LEFT_UP);
+        }
+        Bench::DoNotOptimize(match);
+    });
+    // A computer player's decision, which is the same work wherever the
+    // ball is.
+    Board::Match   aiMatch(config);
+    AI::Controller ai(config, Board::Ball::P_RIGHT);
+    Board::State   aiView;
+    run("Match::Tick+AI::Decide", [&]
+    {
+        aiMatch.Snapshot(aiView);
+        aiMatch.Tick(ai.Decide(aiView) | (aiMatch.GetTicks() % 2 ? 1 << Board::SERVE : 0));
+        Bench::DoNotOptimize(aiMatch);
+    });
+    // Encoding a tick for spectators, once whatever their number.
+    Spectate::Encoder          encoder;
+    std::vector<unsigned char> stream;
+    run("Spectate::Encoder::Encode", [&]
+    {
+        match.Tick(match.GetTicks() % 2 ? 1 << Board::SERVE : 1 << Board::LEFT_UP);
+        match.Save(keyframes[0]);
+        stream.clear();
+        encoder.Encode(Spectate::Frame(keyframes[0]), false, stream);
+        Bench::DoNotOptimize(stream);
+    });
+    uint8_t byte = 0;
+    run("decodeButtons", [&]
+    {
+        decodeButtons(byte++, buttons);
+        Bench::DoNotOptimize(buttons);
+    });
+    buttons[2] = false;
+
+    /* The board's own drawing: paddles, the score and the serve message. */
+
+    run("FillRect/RGBA/20x120", [&] { game.FillRect(24, 300, 20, 120, olc::GREY); });
+    for (uint32_t scale : {1u, 3u, 20u})
+        run("DrawString/NORMAL/" + std::to_string(scale), [&]
+        {
+            game.DrawString(10, 10, scale == 20 ? "0\t0" : "Player 1, it's your turn to serve!", olc::DARK_GREY, scale);
+        });
+
+    /* Translucent overlays. */
+
+    olc::Pixel shade(0, 0, 0, 128);
+    olc::Sprite sprite(64, 64);
+    for (int y = 0; y < sprite.height; y++)
+        for (int x = 0; x < sprite.width; x++)
+            sprite.SetPixel(x, y, olc::Pixel(x * 4, y * 4, 128, (x + y) * 2));
+
+    game.SetPixelMode(olc::Pixel::ALPHA);
+    run("Draw/ALPHA/1080x720", [&]
+    {
+        for (int y = 0; y < 720; y++)
+            for (int x = 0; x < 1080; x++)
+                game.Draw(x, y, shade);
+    });
+    run("FillRect/ALPHA/1080x720", [&] { game.FillRect(0, 0, 1080, 720, shade); });
+    run("DrawSprite/ALPHA/64x64/1", [&] { game.DrawSprite(100, 100, &sprite, 1); });
+    run("DrawSprite/ALPHA/64x64/4", [&] { game.DrawSprite(100, 100, &sprite, 4); });
+    game.SetPixelMode(olc::Pixel::NORMAL);
+
+    /* User blend functors: through SetPixelMode() and as a template argument. */
+
+    auto invert = [](int, int, const olc::Pixel& s, const olc::Pixel& d)
+    {
+        return olc::Pixel(255 - d.r, 255 - d.g, 255 - d.b, s.a);
+    };
+    game.SetPixelMode(invert);
+    run("FillRect/CUSTOM/1080x720", [&] { game.FillRect(0, 0, 1080, 720, shade); });
+    game.SetPixelMode(olc::Pixel::NORMAL);
+    run("FillRect/FUNCTOR/1080x720", [&]
+    {
+        game.FillRect(0, 0, 1080, 720, shade, olc::PixelOpCustom(invert));
+    });
+
+    std::string text = "Player 1, it's your turn to serve!";
+    run("DrawString/ALPHA/3", [&] { game.DrawString(10, 10, text, shade, 3); });
+    run("DrawString/ALPHA/20", [&] { game.DrawString(10, 10, "0\t0", shade, 20); });
+
+    /* The same frame stored as full colour and as palette indices. */
+
+    olc::Sprite indexed(1080, 720, {olc::BLANK, olc::DARK_GREY, olc::VERY_DARK_BLUE, olc::GREY});
+    std::vector<olc::Pixel> row(1080);
+    for (olc::Sprite* frame : {&target, &indexed})
+    {
+        std::string format = frame->IsIndexed() ? "INDEXED" : "RGBA";
+        game.SetDrawTarget(frame);
+        run("Clear/" + format + "/1080x720", [&] { game.Clear(olc::VERY_DARK_BLUE); });
+        run("FillRect/" + format + "/1080x720", [&] { game.FillRect(0, 0, 1080, 720, olc::GREY); });
+        run("Expand/" + format + "/1080x720", [&]
+        {
+            for (int y = 0; y < 720; y++)
+                frame->ExpandRow(0, y, 1080, row.data());
+            Bench::DoNotOptimize(row.data());
+        });
+    }
+    game.SetDrawTarget(&target);
+
+    /* A whole board at 4K, rasterized in tiles by a growing number of threads. */
+
+    olc::Sprite cabinet(3840, 2160);
+    auto frame = [&]
+    {
+        game.SetDrawTarget(&cabinet);
+        game.Clear(olc::DARK_BLUE);
+        game.FillRect(12, 12, 3840 - 24, 2160 - 24, olc::BLACK);
+        for (int y = 12; y < 2160; y += 48)
+            game.FillRect(1914, y, 12, 24, olc::DARK_BLUE);
+        game.FillRect(72, 900, 24, 360, olc::WHITE);
+        game.FillRect(3744, 700, 24, 360, olc::WHITE);
+        game.DrawSprite(1500, 1200, &sprite, 1);
+        game.DrawString(1500, 60, "3\t7", olc::DARK_BLUE, 60);
+        game.DrawString(1200, 1500, text, olc::DARK_BLUE, 9);
+        game.FlushRasterizer();
+    };
+    std::vector<uint32_t> threads = {1, 2, 4, std::max(1u, std::thread::hardware_concurrency())};
+    for (size_t i = 0; i < threads.size(); i++)
+    {
+        if (i > 0 && threads[i] <= threads[i - 1])
+            continue;
+        game.SetRasterThreads(threads[i]);
+        run("Frame/3840x2160/threads=" + std::to_string(threads[i]), frame);
+    }
+    game.SetRasterThreads(1);
+
+    /* The same 4K frame upscaled from a board drawn at a half and a quarter. */
+
+    std::vector<olc::Pixel> upscaled(3840 * 2160);
+    for (uint32_t factor : {2u, 4u})
+    {
+        olc::Sprite board(3840 / factor, 2160 / factor);
+        run("Upscale/3840x2160/x" + std::to_string(factor), [&]
+        {
+            olc::UpscaleNearest(board.pColData, board.width, board.height, upscaled.data(), factor);
+            Bench::DoNotOptimize(upscaled.data());
+        });
+    }
+
+    /* Handing a board-sized snapshot from the simulation to the renderer. */
+
+    struct Snapshot { olc::vf2d pos[3]; olc::vi2d size[3]; int scores[2]; int state; };
+    olc::TripleBuffer<Snapshot> snapshots;
+    run("TripleBuffer/Publish+Latest", [&]
+    {
+        snapshots.Back().scores[0]++;
+        snapshots.Publish();
+        Bench::DoNotOptimize(snapshots.Latest().scores[0]);
+    });
+
+    /* Frame pacing: one sample per frame, so the MAD is the frame-time jitter. */
+
+    Bench::Options perFrame;
+    perFrame.sampleSeconds = 0.0;
+    perFrame.samples = 241;
+    olc::FrameScheduler scheduler;
+    for (auto mode : {olc::FrameScheduler::Mode::PRECISE, olc::FrameScheduler::Mode::LOW_POWER})
+    {
+        scheduler.SetTargetRate(240.0, mode);
+        std::string name = mode == olc::FrameScheduler::Mode::PRECISE ? "PRECISE" : "LOW_POWER";
+        run("FrameScheduler/" + name + "/240Hz", [&] { scheduler.Wait(); }, perFrame);
+    }
+
+    return 0;
+}
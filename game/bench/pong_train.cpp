@@ -0,0 +1,116 @@
+/*
+
+    Training workload for the profile-guided build, run by `make pgo`.
+
+    Plays scripted matches on a headless engine with the same layers and
+    drawing as the game, first with palette-indexed layers and then with
+    full colour ones. The profile therefore covers the simulation, the
+    board's text and the controller byte decode. No display or controller
+    is needed, and every run is identical: the buttons follow a script and
+    the serves a fixed seed.
+
+*/
+
+#include <memory>
+#include <vector>
+
+#include "../olcPixelGameEngine.hpp"
+#include "../Board.hpp"
+
+// Frames per match, each a tick of the simulation.
+const int      FRAMES = 2400;
+const uint32_t TICKS  = 120;
+
+class Trainer : public olc::PixelGameEngine
+{
+public:
+    Trainer(bool _fullColor) : fullColor(_fullColor) { sAppName = "pong_train"; }
+
+private:
+    bool fullColor;
+    int  frame = 0;
+
+    std::unique_ptr<Board::Match> match;
+    Board::State                  state;
+
+public:
+    bool OnUserCreate() override
+    {
+        SetRasterThreads(0);
+
+        std::vector<olc::Pixel> palette = {
+            olc::BLANK,
+            Board::BORDER_COLOR,
+            Board::BACKGROUND_COLOR,
+            Board::PLAY_OBJECT_COLOR
+        };
+        if (!fullColor)
+            SetLayerPalette(0, palette);
+
+        Board::Config config;
+        config.size     = {ScreenWidth(), ScreenHeight()};
+        config.tickRate = TICKS;
+        match = std::make_unique<Board::Match>(config);
+        match->Snapshot(state);
+
+        // The game's background: border, board and centre line.
+        int borderWidth = 4;
+        int bgLayer = CreateLayer();
+        if (!fullColor)
+            SetLayerPalette(bgLayer, palette);
+        SetDrawTarget(bgLayer);
+        Clear(Board::BORDER_COLOR);
+        FillRect(borderWidth, borderWidth, ScreenWidth() - 2*borderWidth, ScreenHeight() - 2*borderWidth,
+                 Board::BACKGROUND_COLOR);
+        for (int y = borderWidth; y < ScreenHeight() + borderWidth; y += 4*borderWidth)
+            FillRect((ScreenWidth() - borderWidth) / 2, y, borderWidth, 2*borderWidth, Board::BORDER_COLOR);
+        EnableLayer(bgLayer, true);
+        SetDrawTarget(nullptr);
+
+        return true;
+    }
+
+    bool OnUserUpdate(float) override
+    {
+        match->Tick(Script());
+        match->Snapshot(state);
+
+        Clear(olc::BLANK);
+        Board::Draw(this, state);
+
+        return ++frame < FRAMES;
+    }
+
+private:
+    // The byte the controller would send this frame. Serve is tapped every
+    // half second and both paddles chase the ball, except that the right
+    // one dozes off now and then so points get scored.
+    unsigned char Script() const
+    {
+        unsigned char byte = (frame / 60) % 2 ? 1 << Board::SERVE : 0;
+
+        float ballY = state.ball.pos.y + state.ball.size.y / 2.0f;
+        auto chase = [&](const Board::State::Rect& paddle, int down, int up)
+        {
+            float paddleY = paddle.pos.y + paddle.size.y / 2.0f;
+            if (ballY > paddleY + 10.0f) byte |= 1 << down;
+            if (ballY < paddleY - 10.0f) byte |= 1 << up;
+        };
+        chase(state.paddles[0], Board::LEFT_DOWN, Board::LEFT_UP);
+        if ((frame / 300) % 3 != 2)
+            chase(state.paddles[1], Board::RIGHT_DOWN, Board::RIGHT_UP);
+        return byte;
+    }
+};
+
+int main()
+{
+    for (bool fullColor : {false, true})
+    {
+        Trainer trainer(fullColor);
+        if (!trainer.Construct(1080, 720, 1, 1))
+            return 1;
+        trainer.Start();
+    }
+    return 0;
+}
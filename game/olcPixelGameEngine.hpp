@@ -81,6 +81,15 @@
 	vblank_mode=0 ./YourProgName
 
 
+	Compiling Headless
+	~~~~~~~~~~~~~~~~~~
+	Define OLC_PLATFORM_HEADLESS for every source file to build without a
+	window or graphics device. Layers are kept in memory, the game loop runs
+	as fast as it can and the title bar (with the FPS) is printed to stdout:
+
+	g++ -o YourProgName YourSource.cpp -DOLC_PLATFORM_HEADLESS -lpthread -std=c++17
+
+
 	Compiling in Code::Blocks on Windows
 	~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 	Well I wont judge you, but make sure your Code::Blocks installation
@@ -219,6 +228,11 @@ int main()
 #include <algorithm>
 #include <array>
 #include <cstring>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <cstdio>
 
 // O------------------------------------------------------------------------------O
 // | COMPILER CONFIGURATION ODDITIES                                              |
@@ -256,8 +270,26 @@ int main()
 
 #define UNUSED(x) (void)(x)
 
+// Timing zones for olc::Profiler, see there
+#if defined(OLC_PROFILER)
+	#define OLC_PROFILE_CONCAT_(a, b) a##b
+	#define OLC_PROFILE_CONCAT(a, b) OLC_PROFILE_CONCAT_(a, b)
+	#define OLC_PROFILE_ZONE(name) olc::ProfileZone OLC_PROFILE_CONCAT(olc_zone_, __LINE__)(name)
+	#define OLC_PROFILE_THREAD(name) olc::Profiler::SetThreadName(name)
+#else
+	#define OLC_PROFILE_ZONE(name) ((void)0)
+	#define OLC_PROFILE_THREAD(name) ((void)0)
+#endif
+
+#if !defined(OLC_NO_SIMD) && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+	#define OLC_SIMD_SSE2
+	#include <emmintrin.h>
+#endif
+
 
-#if !defined(OLC_GFX_OPENGL33) && !defined(OLC_GFX_DIRECTX10)
+#if defined(OLC_PLATFORM_HEADLESS)
+	#define OLC_GFX_NULL
+#elif !defined(OLC_GFX_OPENGL33) && !defined(OLC_GFX_DIRECTX10)
 	#define OLC_GFX_OPENGL10
 #endif
 
@@ -298,6 +330,94 @@ namespace olc
 
 	Pixel PixelF(float red, float green, float blue, float alpha = 1.0f);
 
+	// Alpha blending in 8-bit fixed point. Alpha and blend factor run from 0 to
+	// 256 (opaque), and results are opaque just like Pixel::ALPHA always was.
+	// The span versions do 4 pixels per instruction where SSE2 is available
+	uint32_t BlendAlpha(uint8_t a, uint32_t nBlend);
+	Pixel    BlendPixel(Pixel d, Pixel s, uint32_t nBlend);
+	void     BlendSpan(Pixel* dst, Pixel src, int32_t n, uint32_t nBlend);
+	void     BlendSpan(Pixel* dst, const Pixel* src, int32_t n, uint32_t nBlend);
+
+	// Nearest neighbour upscaling by a whole factor. UpscaleRow() writes w * factor
+	// pixels, UpscaleNearest() a (w * factor) x (h * factor) image
+	void     UpscaleRow(const Pixel* src, int32_t w, Pixel* dst, uint32_t factor);
+	void     UpscaleNearest(const Pixel* src, int32_t w, int32_t h, Pixel* dst, uint32_t factor);
+
+
+
+	// O------------------------------------------------------------------------------O
+	// | olc::PixelOp - Pixel modes as types for the templated drawing routines       |
+	// O------------------------------------------------------------------------------O
+	// A pixel op writes spans: Fill() with a single colour, Copy() from source
+	// pixels; x and y locate dst[0] on the draw target. Drawing routines are
+	// instantiated per op, so the mode is resolved once per primitive and the
+	// span loops inline into the rasterizer
+	struct PixelOpNormal
+	{
+		static constexpr bool bUniform = true;
+		void Fill(Pixel* dst, Pixel p, int32_t n, int32_t, int32_t) const
+		{ std::fill(dst, dst + n, p); }
+		void Copy(Pixel* dst, const Pixel* src, int32_t n, int32_t, int32_t) const
+		{ std::copy(src, src + n, dst); }
+	};
+
+	struct PixelOpMask
+	{
+		static constexpr bool bUniform = true;
+		void Fill(Pixel* dst, Pixel p, int32_t n, int32_t, int32_t) const
+		{ if (p.a == 255) std::fill(dst, dst + n, p); }
+		void Copy(Pixel* dst, const Pixel* src, int32_t n, int32_t, int32_t) const
+		{ for (int32_t i = 0; i < n; i++) dst[i].n = (src[i].n >> 24) == 0xFF ? src[i].n : dst[i].n; }
+	};
+
+	struct PixelOpAlpha
+	{
+		static constexpr bool bUniform = true;
+		uint32_t nBlend = 256; // 0 to 256, see BlendAlpha()
+		void Fill(Pixel* dst, Pixel p, int32_t n, int32_t, int32_t) const
+		{ if (n == 1) *dst = BlendPixel(*dst, p, nBlend); else BlendSpan(dst, p, n, nBlend); }
+		void Copy(Pixel* dst, const Pixel* src, int32_t n, int32_t, int32_t) const
+		{ BlendSpan(dst, src, n, nBlend); }
+	};
+
+	// Wraps a Pixel(x, y, source, destination) functor, like SetPixelMode() takes
+	template<class F>
+	struct PixelOpFunc
+	{
+		F func;
+		void Fill(Pixel* dst, Pixel p, int32_t n, int32_t x, int32_t y) const
+		{ for (int32_t i = 0; i < n; i++) dst[i] = func(x + i, y, p, dst[i]); }
+		void Copy(Pixel* dst, const Pixel* src, int32_t n, int32_t x, int32_t y) const
+		{ for (int32_t i = 0; i < n; i++) dst[i] = func(x + i, y, src[i], dst[i]); }
+	};
+
+	template<class F>
+	PixelOpFunc<F> PixelOpCustom(F func) { return { func }; }
+
+	// Ops whose result depends on the colours alone, not x and y, declare
+	// bUniform. On indexed targets they run once per palette entry
+	template<class Op, class = void> struct IsUniformPixelOp : std::false_type {};
+	template<class Op> struct IsUniformPixelOp<Op, std::void_t<decltype(Op::bUniform)>> : std::bool_constant<Op::bUniform> {};
+
+	class Sprite;
+
+	// The window of a sprite that rasterization may write to. Coordinates given
+	// to the rasterizers are nScale times finer than the sprite's pixels, the
+	// window is in pixels
+	struct RasterTarget
+	{
+		Sprite* spr = nullptr;
+		int32_t x1 = 0, y1 = 0, x2 = 0, y2 = 0;
+		int32_t nScale = 1;
+		// First pixel whose centre lies at or beyond coordinate c. Areas cover
+		// the pixels whose centres they contain, as if sampled at full size
+		int32_t Edge(int32_t c) const
+		{ int32_t a = c - nScale / 2; return a >= 0 ? (a + nScale - 1) / nScale : -(-a / nScale); }
+		// Pixel containing coordinate c, so points and thin lines never vanish
+		int32_t Cell(int32_t c) const
+		{ return c >= 0 ? c / nScale : -((-c + nScale - 1) / nScale); }
+	};
+
 
 
 	// O------------------------------------------------------------------------------O
@@ -339,7 +459,7 @@ namespace olc
 		T y = 0;
 		v2d_generic() : x(0), y(0)                        {                                                            }
 		v2d_generic(T _x, T _y) : x(_x), y(_y)            {                                                            }
-		v2d_generic(const v2d_generic& v) : x(v.x), y(v.y){                                                            }
+		v2d_generic(const v2d_generic& v) = default;
 		T mag()                                           { return std::sqrt(x * x + y * y);                           }
 		T mag2()					                         { return x * x + y * y;                                      }
 		v2d_generic  norm()                               { T r = 1 / mag(); return v2d_generic(x*r, y*r);             }
@@ -434,6 +554,7 @@ namespace olc
 		Sprite();
 		Sprite(const std::string& sImageFile, olc::ResourcePack *pack = nullptr);
 		Sprite(int32_t w, int32_t h);
+		Sprite(int32_t w, int32_t h, const std::vector<Pixel>& palette);
 		~Sprite();
 
 	public:
@@ -455,9 +576,39 @@ namespace olc
 		bool  SetPixel(const olc::vi2d& a, Pixel p);
 		Pixel Sample(float x, float y) const;
 		Pixel SampleBL(float u, float v) const;
+		// Indexed sprites are converted back to full colour first
 		Pixel* GetData();
 		Pixel *pColData = nullptr;
 		Mode modeSample = Mode::NORMAL;
+
+	public:
+		// Region written since the sprite was last uploaded to a texture,
+		// min inclusive, max exclusive. Handing out raw data via GetData()
+		// marks the whole sprite, as we can't know what will be written
+		void MarkDirty();
+		void MarkDirty(int32_t x, int32_t y, int32_t w, int32_t h);
+		void ClearDirty();
+		bool IsDirty() const;
+		olc::vi2d vDirtyMin = { 0, 0 };
+		olc::vi2d vDirtyMax = { 0, 0 };
+
+	public:
+		// An indexed sprite stores one byte per pixel, looked up in a palette of
+		// up to 256 colours only when read or uploaded; pColData is nullptr then.
+		// SetPalette() converts the pixels to their closest entries, and an
+		// empty palette converts the sprite back to full colour. The palette
+		// never changes while drawing: colours it lacks, such as those blended
+		// in ALPHA mode, are stored as the closest entry
+		void SetPalette(const std::vector<Pixel>& palette);
+		const std::vector<Pixel>& GetPalette() const;
+		bool IsIndexed() const;
+		// Index of a colour, or of the closest colour if it's missing
+		uint8_t PaletteIndex(Pixel p) const;
+		uint8_t* GetIndexData();
+		// Writes the colours of n pixels starting at (x, y), whatever the format
+		void ExpandRow(int32_t x, int32_t y, int32_t n, Pixel* dst) const;
+		uint8_t* pIndexData = nullptr;
+		std::vector<Pixel> vecPalette;
 	};
 
 	// O------------------------------------------------------------------------------O
@@ -494,6 +645,321 @@ namespace olc
 	};
 
 
+	// O------------------------------------------------------------------------------O
+	// | olc::FrameRecorder - Encodes captured frames to a file on its own thread     |
+	// O------------------------------------------------------------------------------O
+	class FrameRecorder
+	{
+	public:
+		enum class Format { Y4M, RGBA };
+
+		struct Stats
+		{
+			uint64_t nFramesWritten = 0;
+			uint64_t nFramesDropped = 0;
+			// Time the game thread spent handing frames over
+			double   fMeanCaptureUs = 0.0;
+			double   fMaxCaptureUs  = 0.0;
+		};
+
+	public:
+		FrameRecorder() = default;
+		~FrameRecorder();
+
+		// Opens the file and allocates every frame buffer up front, so capturing
+		// never allocates. The backdrop, if any, is copied and blended under
+		// each frame's transparent pixels
+		olc::rcode Start(const std::string& sFile, Format format, int32_t width, int32_t height,
+			uint32_t nFrameRate, const olc::Sprite* backdrop = nullptr, uint32_t nPoolSize = 4);
+		void Stop();
+		bool IsRecording() const;
+		// Swaps the sprite's pixel buffer for a recycled one and queues the
+		// original for encoding, so no pixels are copied on the calling thread.
+		// The sprite's contents are undefined afterwards. If the encoder has
+		// fallen behind and no buffer is free, the frame is dropped instead.
+		// Indexed sprites, and sprites nUpscale times smaller than the frame,
+		// are expanded into a recycled buffer and left untouched
+		void Capture(olc::Sprite* spr, uint32_t nUpscale = 1);
+		Stats GetStats() const;
+
+	private:
+		void EncoderThread();
+		void WriteFrame(const olc::Pixel* frame);
+
+		std::ofstream            ofsFile;
+		Format                   nFormat = Format::Y4M;
+		olc::vi2d                vSize = { 0, 0 };
+		std::vector<olc::Pixel>  vecBackdrop;
+		std::vector<uint8_t>     vecStaging;
+		std::vector<olc::Pixel>  vecCaptureRow;
+
+		// The recorder owns exactly the buffers in these two queues. A swap
+		// in Capture hands one of them to the sprite and takes the sprite's
+		// in its place, so the set changes but its size never does
+		mutable std::mutex       muxQueue;
+		std::condition_variable  cvQueue;
+		std::deque<olc::Pixel*>  qFree;
+		std::deque<olc::Pixel*>  qFilled;
+		bool                     bStopping = false;
+		std::thread              tEncoder;
+
+		uint64_t nFramesWritten = 0;
+		uint64_t nFramesDropped = 0;
+		uint64_t nFramesCaptured = 0;
+		double   fTotalCaptureUs = 0.0;
+		double   fMaxCaptureUs = 0.0;
+	};
+
+
+	// O------------------------------------------------------------------------------O
+	// | olc::WorkerPool - Persistent threads for data parallel jobs                  |
+	// O------------------------------------------------------------------------------O
+	class WorkerPool
+	{
+	public:
+		WorkerPool() = default;
+		~WorkerPool();
+
+		// nThreads counts the calling thread, so 1 starts no workers
+		void Start(uint32_t nThreads);
+		void Stop();
+		uint32_t GetThreadCount() const;
+		// Calls job(i) for every i in [0, nJobs) across the workers and the
+		// calling thread, and returns once all of them have finished
+		void ParallelFor(uint32_t nJobs, const std::function<void(uint32_t)>& job);
+
+	private:
+		void WorkerThread();
+		void RunJobs();
+
+		std::vector<std::thread> vecThreads;
+		std::mutex               muxJobs;
+		std::condition_variable  cvStart;
+		std::condition_variable  cvDone;
+		const std::function<void(uint32_t)>* pJob = nullptr;
+		uint32_t                 nJobs = 0;
+		std::atomic<uint32_t>    nNextJob{ 0 };
+		uint32_t                 nBusy = 0;
+		uint64_t                 nGeneration = 0;
+		bool                     bStopping = false;
+	};
+
+
+	// O------------------------------------------------------------------------------O
+	// | olc::FrameScheduler - Paces frames to a target rate on a monotonic clock     |
+	// O------------------------------------------------------------------------------O
+	class FrameScheduler
+	{
+	public:
+		// PRECISE sleeps until just short of each deadline and spins the rest of
+		// the way. LOW_POWER only sleeps, so it idles the core but inherits the
+		// OS's wake-up latency. JUST_IN_TIME waits like PRECISE, but treats each
+		// deadline as the time the frame should be presented by, and starts it
+		// as late as the recent frame cost allows, so input is read as close to
+		// the present as possible
+		enum class Mode { PRECISE, LOW_POWER, JUST_IN_TIME };
+
+		struct Stats
+		{
+			uint64_t nFrames = 0;
+			// Frames that started a whole period or more late. The schedule
+			// restarts from them rather than rushing to catch up. JUST_IN_TIME
+			// also counts frames presented after their deadline
+			uint64_t nMissed = 0;
+			// Start-to-start intervals
+			double   fMeanIntervalUs = 0.0;
+			double   fStdDevIntervalUs = 0.0;
+			// How long after its deadline each frame actually started
+			double   fMeanLatenessUs = 0.0;
+			double   fMaxLatenessUs = 0.0;
+			// From each frame starting, and reading input, to its present
+			double   fMeanInputAgeUs = 0.0;
+			double   fMaxInputAgeUs = 0.0;
+		};
+
+		using Clock = std::chrono::steady_clock;
+
+	public:
+		FrameScheduler() = default;
+
+		// fHz of 0 leaves frames unpaced. Resets the statistics
+		void SetTargetRate(double fHz, Mode mode = Mode::PRECISE);
+		double GetTargetRate() const;
+		Mode GetMode() const;
+		// Blocks until the next frame is due and returns the time it started
+		Clock::time_point Wait();
+		// Called once the frame's work is done, just before presenting it. The
+		// time since Wait() is the frame cost JUST_IN_TIME plans with
+		void FrameReady();
+		// Called once the frame has been presented
+		void FramePresented();
+		// Whether presents wait for the display (vsync). If so, JUST_IN_TIME
+		// aligns deadlines with the times presents return
+		void SetPresentSync(bool b);
+		Stats GetStats() const;
+		void ResetStats();
+
+	private:
+		void WaitUntil(Clock::time_point tp);
+		// How long before its deadline a frame should start
+		Clock::duration Lead() const;
+
+		Clock::duration   dPeriod{ 0 };
+		Mode              nMode = Mode::PRECISE;
+		bool              bScheduled = false;
+		Clock::time_point tpDeadline;
+		Clock::time_point tpLastStart;
+		// Time left to spin after sleeping, tracks how late the OS wakes us
+		Clock::duration   dSpinMargin = std::chrono::milliseconds(1);
+		bool              bPresentSync = false;
+		// Exponentially weighted mean and variance of the frame cost
+		bool              bCostKnown = false;
+		double            fCostMeanUs = 0.0;
+		double            fCostVarUs = 0.0;
+		// Deviations of cost to leave spare, raised by missed deadlines
+		double            fMarginDevs = 3.0;
+
+		uint64_t nFrames = 0;
+		uint64_t nMissed = 0;
+		uint64_t nIntervals = 0;
+		double   fSumIntervalUs = 0.0;
+		double   fSumIntervalSqUs = 0.0;
+		double   fSumLatenessUs = 0.0;
+		double   fMaxLatenessUs = 0.0;
+		uint64_t nPresents = 0;
+		double   fSumInputAgeUs = 0.0;
+		double   fMaxInputAgeUs = 0.0;
+	};
+
+
+	// O------------------------------------------------------------------------------O
+	// | olc::Profiler - Per-thread timing zones, exported as a Chrome trace          |
+	// O------------------------------------------------------------------------------O
+	// OLC_PROFILE_ZONE("name") times the rest of the enclosing scope. It compiles
+	// to nothing unless OLC_PROFILER is defined, and records nothing until the
+	// profiler is enabled, as does OLC_PROFILE_THREAD("name") for SetThreadName().
+	// Each thread keeps its latest zones in a ring of its own, so recording a
+	// zone never locks or allocates
+	class Profiler
+	{
+	public:
+		struct Zone
+		{
+			// Not copied, so it must outlive the profiler - use literals
+			const char* sName = nullptr;
+			uint64_t    nStartNs = 0;
+			uint64_t    nEndNs = 0;
+		};
+
+	public:
+		static void Enable(bool b);
+		static bool IsEnabled()
+		{ return bEnabled.load(std::memory_order_relaxed); }
+		// Rounded up to a power of two. Applies to rings created afterwards,
+		// ie threads that haven't recorded a zone yet
+		static void SetCapacity(size_t nZones);
+		// Labels the calling thread in traces
+		static void SetThreadName(const std::string& sName);
+		static uint64_t Now()
+		{ return uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count()); }
+		static void Record(const char* sName, uint64_t nStartNs, uint64_t nEndNs);
+		// Writes every thread's zones in Chrome's trace event format, for
+		// chrome://tracing or ui.perfetto.dev. Zones recorded meanwhile by
+		// other threads may be missing
+		static olc::rcode WriteChromeTrace(const std::string& sFile);
+		static void Clear();
+
+	private:
+		// A zone's fields are atomic so other threads may copy them while
+		// the ring wraps over them; relaxed, they cost what plain ones do
+		struct Slot
+		{
+			std::atomic<const char*> sName{ nullptr };
+			std::atomic<uint64_t>    nStartNs{ 0 };
+			std::atomic<uint64_t>    nEndNs{ 0 };
+		};
+		struct Ring
+		{
+			std::unique_ptr<Slot[]> pSlots;
+			size_t                  nSlots = 0;
+			std::atomic<uint64_t>   nWritten{ 0 };
+			// Zones before this were cleared; only the ring's thread writes nWritten
+			std::atomic<uint64_t>   nCleared{ 0 };
+			uint32_t                nThread = 0;
+			std::string             sThreadName;
+		};
+		static Ring& LocalRing();
+		// The zones the ring holds, copied, and none the thread was overwriting meanwhile
+		static std::vector<Zone> Snapshot(const Ring& ring);
+
+		static std::atomic<bool> bEnabled;
+		static std::mutex muxRings;
+		// Shared so a thread's zones outlive it
+		static std::vector<std::shared_ptr<Ring>> vecRings;
+		static size_t nCapacity;
+	};
+
+	class ProfileZone
+	{
+	public:
+		explicit ProfileZone(const char* sName)
+			: sName(sName), nStartNs(Profiler::IsEnabled() ? Profiler::Now() : 0) {}
+		~ProfileZone()
+		{ if (nStartNs != 0) Profiler::Record(sName, nStartNs, Profiler::Now()); }
+		ProfileZone(const ProfileZone&) = delete;
+		ProfileZone& operator=(const ProfileZone&) = delete;
+
+	private:
+		const char* sName;
+		uint64_t    nStartNs;
+	};
+
+
+	// O------------------------------------------------------------------------------O
+	// | olc::TripleBuffer - Hands the latest value from one thread to another        |
+	// O------------------------------------------------------------------------------O
+	// One producer fills Back() and Publish()es it, one consumer reads the newest
+	// published value through Latest(). Neither side ever waits for the other:
+	// the producer always owns a slot to write, and values published faster than
+	// the consumer reads them are skipped
+	template<class T>
+	class TripleBuffer
+	{
+	public:
+		TripleBuffer() = default;
+
+		// Sets every slot, for use before either side starts
+		void Fill(const T& value)
+		{ vSlots.fill(value); }
+
+		// Producer side
+		T& Back()
+		{ return vSlots[nBack]; }
+		void Publish()
+		{ nBack = nMiddle.exchange(uint8_t(nBack | FRESH), std::memory_order_acq_rel) & INDEX; }
+
+		// Consumer side. Returns the previous value again if nothing has been
+		// published since
+		const T& Latest()
+		{
+			if (nMiddle.load(std::memory_order_relaxed) & FRESH)
+				nFront = nMiddle.exchange(nFront, std::memory_order_acq_rel) & INDEX;
+			return vSlots[nFront];
+		}
+		bool HasNew() const
+		{ return (nMiddle.load(std::memory_order_relaxed) & FRESH) != 0; }
+
+	private:
+		static constexpr uint8_t INDEX = 0x03;
+		static constexpr uint8_t FRESH = 0x04;
+
+		std::array<T, 3>     vSlots{};
+		uint8_t              nBack = 0;
+		std::atomic<uint8_t> nMiddle{ 1 };
+		uint8_t              nFront = 2;
+	};
+
+
 	// O------------------------------------------------------------------------------O
 	// | Auxilliary components internal to engine                                     |
 	// O------------------------------------------------------------------------------O
@@ -531,6 +997,7 @@ namespace olc
 	class Renderer
 	{
 	public:
+		virtual ~Renderer() = default;
 		virtual void       PrepareDevice() = 0;
 		virtual olc::rcode CreateDevice(std::vector<void*> params, bool bFullScreen, bool bVSYNC) = 0;
 		virtual olc::rcode DestroyDevice() = 0;
@@ -544,12 +1011,17 @@ namespace olc
 		virtual void       ApplyTexture(uint32_t id) = 0;
 		virtual void       UpdateViewport(const olc::vi2d& pos, const olc::vi2d& size) = 0;
 		virtual void       ClearBuffer(olc::Pixel p, bool bDepth) = 0;
+		// Renderers that keep the presented frame in CPU memory can return it here
+		virtual olc::Sprite* ReadFrame() { return nullptr; }
 		static olc::PixelGameEngine* ptrPGE;
+		// Bytes of texel data sent to the device since the engine last reset it
+		uint32_t nUploadBytes = 0;
 	};
 	
 	class Platform
 	{
 	public:
+		virtual ~Platform() = default;
 		virtual olc::rcode ApplicationStartUp() = 0;
 		virtual olc::rcode ApplicationCleanUp() = 0;
 		virtual olc::rcode ThreadStartUp() = 0;
@@ -621,6 +1093,40 @@ namespace olc
 		void SetDrawTarget(Sprite *target);
 		// Gets the current Frames Per Second
 		uint32_t GetFPS();
+		// Gets the number of texture bytes uploaded during the last frame
+		uint32_t GetUploadBytes();
+		// Gets the last presented frame as composited on the CPU, or nullptr
+		// if the renderer doesn't keep one (only the headless renderer does)
+		olc::Sprite* GetFrameBuffer();
+
+	public: // Recording
+		// Records layer 0 to a file after every frame. Layer 0's buffer is given
+		// to the encoder rather than copied, so its contents are undefined at the
+		// start of each frame while recording - Clear() it every frame. The other
+		// visible layers are assumed static and are captured once as a backdrop
+		olc::rcode StartRecording(const std::string& sFile, olc::FrameRecorder::Format format = olc::FrameRecorder::Format::Y4M, uint32_t nFrameRate = 60);
+		void StopRecording();
+		bool IsRecording() const;
+		olc::FrameRecorder::Stats GetRecordingStats() const;
+
+	public: // Tiled rasterization
+		// Splits draw targets into square tiles and rasterizes Clear(), FillRect(),
+		// DrawString() and DrawSprite() tile by tile across nThreads threads, where
+		// 0 means one per core and 1 turns tiling off. Those calls are queued and
+		// only run when anything else draws, the draw target changes, or the frame
+		// ends, so sprites given to DrawSprite() must not change or be deleted
+		// until then. CUSTOM pixel mode is never queued
+		void SetRasterThreads(uint32_t nThreads, int32_t nTileSize = 128);
+		uint32_t GetRasterThreads() const;
+		// Rasterizes anything queued now
+		void FlushRasterizer();
+
+	public: // Frame pacing
+		// Starts frames at most fHz times a second, or as fast as possible for 0
+		// (the default). See olc::FrameScheduler for the modes
+		void SetFrameRate(double fHz, olc::FrameScheduler::Mode mode = olc::FrameScheduler::Mode::PRECISE);
+		olc::FrameScheduler::Stats GetFrameStats() const;
+		void ResetFrameStats();
 		// Gets last update of elapsed time
 		const float GetElapsedTime() const;
 		// Gets Actual Window size
@@ -636,6 +1142,13 @@ namespace olc
 		void SetLayerScale(uint8_t layer, float x, float y);
 		void SetLayerTint(uint8_t layer, const olc::Pixel& tint);
 		void SetLayerCustomRenderFunction(uint8_t layer, std::function<void()> f);
+		// Stores the layer as one byte per pixel, see olc::Sprite::SetPalette()
+		void SetLayerPalette(uint8_t layer, const std::vector<olc::Pixel>& palette);
+		// Layers hold 1/nDivisor of the screen's pixels in each direction and are
+		// scaled back up when drawn, trading detail for fill rate. Drawing to a
+		// layer still takes screen coordinates. Layers are cleared
+		void SetRenderScale(uint32_t nDivisor);
+		uint32_t GetRenderScale() const;
 
 		std::vector<LayerDesc>& GetLayers();
 		uint32_t CreateLayer();
@@ -726,6 +1239,21 @@ namespace olc
 		// Clears the rendering back buffer
 		void ClearBuffer(Pixel p, bool bDepth = true);
 
+	public: // TEMPLATED DRAWING ROUTINES
+		// As above, but pixels are written through the given op (olc::PixelOpNormal,
+		// PixelOpMask, PixelOpAlpha or PixelOpCustom(func)) rather than the pixel mode.
+		// The routines above pick the op for the current mode once and call these
+		template<class Op> bool Draw(int32_t x, int32_t y, Pixel p, const Op& op);
+		template<class Op> void DrawLine(int32_t x1, int32_t y1, int32_t x2, int32_t y2, Pixel p, uint32_t pattern, const Op& op);
+		template<class Op> void DrawCircle(int32_t x, int32_t y, int32_t radius, Pixel p, uint8_t mask, const Op& op);
+		template<class Op> void FillCircle(int32_t x, int32_t y, int32_t radius, Pixel p, const Op& op);
+		template<class Op> void DrawRect(int32_t x, int32_t y, int32_t w, int32_t h, Pixel p, const Op& op);
+		template<class Op> void FillRect(int32_t x, int32_t y, int32_t w, int32_t h, Pixel p, const Op& op);
+		template<class Op> void DrawTriangle(int32_t x1, int32_t y1, int32_t x2, int32_t y2, int32_t x3, int32_t y3, Pixel p, const Op& op);
+		template<class Op> void FillTriangle(int32_t x1, int32_t y1, int32_t x2, int32_t y2, int32_t x3, int32_t y3, Pixel p, const Op& op);
+		template<class Op> void DrawPartialSprite(int32_t x, int32_t y, Sprite *sprite, int32_t ox, int32_t oy, int32_t w, int32_t h, uint32_t scale, uint8_t flip, const Op& op);
+		template<class Op> void DrawString(int32_t x, int32_t y, const std::string& sText, Pixel col, uint32_t scale, const Op& op);
+
 
 	public: // Branding
 		std::string sAppName;
@@ -734,6 +1262,7 @@ namespace olc
 		Sprite*     pDrawTarget           = nullptr;
 		Pixel::Mode	nPixelMode            = Pixel::NORMAL;
 		float		fBlendFactor          = 1.0f;
+		uint32_t	nBlendFactor          = 256;
 		olc::vi2d	vScreenSize           = { 256, 240 };
 		olc::vf2d	vInvScreenSize        = { 1.0f / 256.0f, 1.0f / 240.0f };
 		olc::vi2d	vPixelSize            = { 4, 4 };
@@ -759,8 +1288,38 @@ namespace olc
 		std::vector<LayerDesc> vLayers;
 		uint8_t		nTargetLayer          = 0;
 		uint32_t	nLastFPS              = 0;
+		uint32_t	nLastUploadBytes      = 0;
+		int32_t		nRenderScale          = 1;
+		// Render scale of the current draw target, 1 unless it's a layer
+		int32_t		nTargetScale          = 1;
+		std::unique_ptr<olc::FrameRecorder> pRecorder;
+
+		// Tiled rasterization: commands are queued in order and each tile's bin
+		// lists the commands overlapping it
+		struct TileCommand
+		{
+			enum class Type : uint8_t { RECT, STRING, SPRITE } nType = Type::RECT;
+			Pixel::Mode nMode = Pixel::NORMAL;
+			uint32_t nBlend = 256;
+			int32_t x = 0, y = 0, w = 0, h = 0;
+			Pixel col;
+			Sprite* sprite = nullptr;
+			int32_t ox = 0, oy = 0;
+			uint32_t scale = 1;
+			uint8_t flip = 0;
+			uint32_t nText = 0;
+		};
+		std::unique_ptr<olc::WorkerPool> pRasterPool;
+		int32_t		nTileSize = 128;
+		Sprite*		pTileTarget = nullptr;
+		olc::vi2d	vTileCount = { 0, 0 };
+		int32_t		nTileScale = 1;
+		std::vector<TileCommand> vecTileCommands;
+		std::vector<std::vector<uint32_t>> vecTileBins;
+		std::vector<std::string> vecTileText;
 		std::function<olc::Pixel(const int x, const int y, const olc::Pixel&, const olc::Pixel&)> funcPixelMode;
-		std::chrono::time_point<std::chrono::system_clock> m_tp1, m_tp2;
+		olc::FrameScheduler frameScheduler;
+		olc::FrameScheduler::Clock::time_point m_tp1, m_tp2;
 
 		// State of keyboard		
 		bool		pKeyNewState[256]{ 0 };
@@ -772,6 +1331,27 @@ namespace olc
 		bool		pMouseOldState[nMouseButtons]{ 0 };
 		HWButton	pMouseState[nMouseButtons]{ 0 };
 
+		// Calls f with the pixel op matching the current pixel mode
+		template<class F> void olc_WithPixelOp(F&& f);
+		RasterTarget olc_Target();
+		// Marks an area given in draw target coordinates
+		void olc_MarkDirty(int32_t x, int32_t y, int32_t w, int32_t h);
+		olc::vi2d olc_LayerSize() const;
+		void olc_ResizeLayers();
+		bool olc_Tiling() const;
+		void olc_BinCommand(const TileCommand& cmd);
+		void olc_RasterCommand(const RasterTarget& t, const TileCommand& cmd);
+
+		// Rasterizers behind the drawing routines. They clip to the target's
+		// window and write through the op, but leave dirty regions to the caller
+		template<class Op> void olc_RasterPixel(const RasterTarget& t, int32_t x, int32_t y, Pixel p, const Op& op);
+		template<class Op> void olc_PlotIndexed(Sprite* spr, int32_t x, int32_t y, const Pixel& p, const Op& op, bool bCopy);
+		template<class Op> void olc_RasterRectIndexed(const RasterTarget& t, int32_t x1, int32_t y1, int32_t x2, int32_t y2, Pixel p, const Op& op);
+		template<class Op> void olc_RasterRect(const RasterTarget& t, int32_t x1, int32_t y1, int32_t x2, int32_t y2, Pixel p, const Op& op);
+		template<class Op> void olc_RasterSpan(const RasterTarget& t, int32_t x, int32_t y, const Pixel* src, int32_t n, const Op& op);
+		template<class Op> void olc_RasterString(const RasterTarget& t, int32_t x, int32_t y, const std::string& sText, Pixel col, uint32_t scale, const Op& op);
+		template<class Op> void olc_RasterSprite(const RasterTarget& t, int32_t x, int32_t y, Sprite *sprite, int32_t ox, int32_t oy, int32_t w, int32_t h, uint32_t scale, uint8_t flip, const Op& op);
+
 		// The main engine thread
 		void		EngineThread();
 
@@ -808,275 +1388,1658 @@ namespace olc
 
 
 	// O------------------------------------------------------------------------------O
-	// | PGE EXTENSION BASE CLASS - Permits access to PGE functions from extension    |
+	// | olc::PixelGameEngine TEMPLATED DRAWING ROUTINES                              |
 	// O------------------------------------------------------------------------------O
-	class PGEX
+	template<class F>
+	void PixelGameEngine::olc_WithPixelOp(F&& f)
 	{
-		friend class olc::PixelGameEngine;
-	protected:
-		static PixelGameEngine* pge;
-	};
-}
-
-#endif // OLC_PGE_DEF
-
+		switch (nPixelMode)
+		{
+		case Pixel::NORMAL: f(PixelOpNormal()); break;
+		case Pixel::MASK:   f(PixelOpMask()); break;
+		case Pixel::ALPHA:  f(PixelOpAlpha{ nBlendFactor }); break;
+		case Pixel::CUSTOM: f(PixelOpFunc<const decltype(funcPixelMode)&>{ funcPixelMode }); break;
+		}
+	}
 
+	template<class Op>
+	void PixelGameEngine::olc_RasterPixel(const RasterTarget& t, int32_t x, int32_t y, Pixel p, const Op& op)
+	{
+		if (t.nScale > 1) { x = t.Cell(x); y = t.Cell(y); }
+		if (x < t.x1 || x >= t.x2 || y < t.y1 || y >= t.y2) return;
+		if (t.spr->pIndexData)
+			olc_PlotIndexed(t.spr, x, y, p, op, false);
+		else
+			op.Fill(t.spr->pColData + y * t.spr->width + x, p, 1, x, y);
+	}
 
+	// Runs the op on the palette colour underneath and stores the closest index
+	// to the result. bCopy picks Copy() over Fill() for source pixels
+	template<class Op>
+	void PixelGameEngine::olc_PlotIndexed(Sprite* spr, int32_t x, int32_t y, const Pixel& p, const Op& op, bool bCopy)
+	{
+		uint8_t& idx = spr->pIndexData[y * spr->width + x];
+		Pixel d = spr->vecPalette[idx];
+		if (bCopy) op.Copy(&d, &p, 1, x, y); else op.Fill(&d, p, 1, x, y);
+		idx = spr->PaletteIndex(d);
+	}
 
-/*
-	Object Oriented Mode
-	~~~~~~~~~~~~~~~~~~~~
+	template<class Op>
+	void PixelGameEngine::olc_RasterRectIndexed(const RasterTarget& t, int32_t x1, int32_t y1, int32_t x2, int32_t y2, Pixel p, const Op& op)
+	{
+		Sprite* spr = t.spr;
+		if constexpr (IsUniformPixelOp<Op>::value)
+		{
+			// Every pixel with the same index ends up the same colour, so the op
+			// runs over the palette once and the rows are remapped through it
+			std::array<Pixel, 256> vResult;
+			std::array<uint8_t, 256> vRemap;
+			int32_t nColours = int32_t(spr->vecPalette.size());
+			std::copy(spr->vecPalette.begin(), spr->vecPalette.end(), vResult.begin());
+			op.Fill(vResult.data(), p, nColours, 0, 0);
+
+			bool bSame = true, bIdentity = true;
+			for (int32_t i = 0; i < nColours; i++)
+			{
+				vRemap[i] = spr->PaletteIndex(vResult[i]);
+				bSame &= vRemap[i] == vRemap[0];
+				bIdentity &= vRemap[i] == i;
+			}
+			if (bIdentity) return;
 
-	If the olcPixelGameEngine.h is called from several sources it can cause
-	multiple definitions of objects. To prevent this, ONLY ONE of the pathways
-	to including this file must have OLC_PGE_APPLICATION defined before it. This prevents
-	the definitions being duplicated.
+			for (int32_t y = y1; y < y2; y++)
+			{
+				uint8_t* dst = spr->pIndexData + y * spr->width + x1;
+				if (bSame)
+					std::memset(dst, vRemap[0], size_t(x2 - x1));
+				else
+					for (int32_t i = 0; i < x2 - x1; i++) dst[i] = vRemap[dst[i]];
+			}
+		}
+		else
+		{
+			for (int32_t y = y1; y < y2; y++)
+				for (int32_t x = x1; x < x2; x++)
+					olc_PlotIndexed(spr, x, y, p, op, false);
+		}
+	}
 
-	If all else fails, create a file called "olcPixelGameEngine.cpp" with the following
-	two lines. Then you can just #include "olcPixelGameEngine.h" as normal without worrying
-	about defining things. Dont forget to include that cpp file as part of your build!
+	template<class Op>
+	void PixelGameEngine::olc_RasterRect(const RasterTarget& t, int32_t x1, int32_t y1, int32_t x2, int32_t y2, Pixel p, const Op& op)
+	{
+		if (t.nScale > 1) { x1 = t.Edge(x1); y1 = t.Edge(y1); x2 = t.Edge(x2); y2 = t.Edge(y2); }
+		x1 = std::max(x1, t.x1); x2 = std::min(x2, t.x2);
+		y1 = std::max(y1, t.y1); y2 = std::min(y2, t.y2);
+		if (x1 >= x2 || y1 >= y2) return;
+		if (t.spr->pIndexData) { olc_RasterRectIndexed(t, x1, y1, x2, y2, p, op); return; }
+		for (int32_t y = y1; y < y2; y++)
+			op.Fill(t.spr->pColData + y * t.spr->width + x1, p, x2 - x1, x1, y);
+	}
 
-	#define OLC_PGE_APPLICATION
-	#include "olcPixelGameEngine.h"
+	// Unlike the others, takes the position in pixels of the target
+	template<class Op>
+	void PixelGameEngine::olc_RasterSpan(const RasterTarget& t, int32_t x, int32_t y, const Pixel* src, int32_t n, const Op& op)
+	{
+		if (y < t.y1 || y >= t.y2) return;
+		if (x < t.x1) { src += t.x1 - x; n -= t.x1 - x; x = t.x1; }
+		n = std::min(n, t.x2 - x);
+		if (n <= 0) return;
+		if (t.spr->pIndexData)
+			for (int32_t i = 0; i < n; i++) olc_PlotIndexed(t.spr, x + i, y, src[i], op, true);
+		else
+			op.Copy(t.spr->pColData + y * t.spr->width + x, src, n, x, y);
+	}
 
-*/
+	template<class Op>
+	void PixelGameEngine::olc_RasterString(const RasterTarget& t, int32_t x, int32_t y, const std::string& sText, Pixel col, uint32_t scale, const Op& op)
+	{
+		int32_t sx = 0;
+		int32_t sy = 0;
+		int32_t s = int32_t(scale);
+		for (auto c : sText)
+		{
+			if (c == '\n')
+			{
+				sx = 0; sy += 8 * s;
+			}
+			else
+			{
+				int32_t ox = (c - 32) % 16;
+				int32_t oy = (c - 32) / 16;
 
+				// Characters off the font sheet, like tabs, draw as blanks
+				bool bGlyph = ox >= 0 && oy >= 0 && (oy + 1) * 8 <= fontSprite->height;
 
-// O------------------------------------------------------------------------------O
-// | START OF OLC_PGE_APPLICATION                                                 |
-// O------------------------------------------------------------------------------O
-#ifdef OLC_PGE_APPLICATION
-#undef OLC_PGE_APPLICATION
+				// Each run of lit pixels along a glyph row is one span
+				for (int32_t j = 0; bGlyph && j < 8; j++)
+				{
+					const Pixel* row = fontSprite->pColData + (j + oy * 8) * fontSprite->width + ox * 8;
+					int32_t i = 0;
+					while (i < 8)
+					{
+						if (row[i].r == 0) { i++; continue; }
+						int32_t i0 = i;
+						while (i < 8 && row[i].r > 0) i++;
+						olc_RasterRect(t, x + sx + i0 * s, y + sy + j * s, x + sx + i * s, y + sy + (j + 1) * s, col, op);
+					}
+				}
+				sx += 8 * s;
+			}
+		}
+	}
 
-// O------------------------------------------------------------------------------O
-// | olcPixelGameEngine INTERFACE IMPLEMENTATION (CORE)                           |
-// | Note: The core implementation is platform independent                        |
-// O------------------------------------------------------------------------------O
-namespace olc
-{
-	// O------------------------------------------------------------------------------O
-	// | olc::Pixel IMPLEMENTATION                                                    |
-	// O------------------------------------------------------------------------------O
-	Pixel::Pixel()
-	{ r = 0; g = 0; b = 0; a = nDefaultAlpha; }
+	template<class Op>
+	void PixelGameEngine::olc_RasterSprite(const RasterTarget& t, int32_t x, int32_t y, Sprite *sprite, int32_t ox, int32_t oy, int32_t w, int32_t h, uint32_t scale, uint8_t flip, const Op& op)
+	{
+		int32_t fxs = 0, fxm = 1;
+		int32_t fys = 0, fym = 1, fy = 0;
+		if (flip & olc::Sprite::Flip::HORIZ) { fxs = w - 1; fxm = -1; }
+		if (flip & olc::Sprite::Flip::VERT) { fys = h - 1; fym = -1; }
+		static thread_local std::vector<Pixel> vecRow;
 
-	Pixel::Pixel(uint8_t red, uint8_t green, uint8_t blue, uint8_t alpha)
-	{ n = red | (green << 8) | (blue << 16) | (alpha << 24); } // Thanks jarekpelczar 
+		if (t.nScale > 1)
+		{
+			// Sample the sprite at the centre of each pixel it covers
+			int32_t s = int32_t(scale), d = t.nScale;
+			int32_t px1 = std::max(t.Edge(x), t.x1), px2 = std::min(t.Edge(x + w * s), t.x2);
+			int32_t py1 = std::max(t.Edge(y), t.y1), py2 = std::min(t.Edge(y + h * s), t.y2);
+			if (px1 >= px2) return;
+			vecRow.resize(size_t(px2 - px1));
+			for (int32_t py = py1; py < py2; py++)
+			{
+				int32_t sy = fys + fym * ((py * d + d / 2 - y) / s);
+				for (int32_t px = px1; px < px2; px++)
+					vecRow[px - px1] = sprite->GetPixel(ox + fxs + fxm * ((px * d + d / 2 - x) / s), oy + sy);
+				olc_RasterSpan(t, px1, py, vecRow.data(), px2 - px1, op);
+			}
+			return;
+		}
 
+		// Each source row is flipped and scaled once into a span,
+		// which is then written out scale times
+		int32_t nSpan = w * int32_t(scale);
+		vecRow.resize(size_t(nSpan));
 
-	Pixel::Pixel(uint32_t p)
-	{ n = p; }
+		fy = fys;
+		for (int32_t j = 0; j < h; j++, fy += fym)
+		{
+			int32_t dy = y + j * int32_t(scale);
+			if (dy + int32_t(scale) <= t.y1 || dy >= t.y2) continue;
 
-	bool Pixel::operator==(const Pixel& p) const
-	{ return n == p.n; }
+			int32_t fx = fxs;
+			for (int32_t i = 0; i < w; i++, fx += fxm)
+			{
+				Pixel p = sprite->GetPixel(fx + ox, fy + oy);
+				for (uint32_t is = 0; is < scale; is++)
+					vecRow[i * scale + is] = p;
+			}
 
-	bool Pixel::operator!=(const Pixel& p) const
-	{ return n != p.n; }
+			for (uint32_t js = 0; js < scale; js++)
+				olc_RasterSpan(t, x, dy + int32_t(js), vecRow.data(), nSpan, op);
+		}
+	}
 
-	Pixel PixelF(float red, float green, float blue, float alpha)
+	template<class Op>
+	bool PixelGameEngine::Draw(int32_t x, int32_t y, Pixel p, const Op& op)
 	{
-		return Pixel(uint8_t(red * 255.0f), uint8_t(green * 255.0f), uint8_t(blue * 255.0f), uint8_t(alpha * 255.0f));
+		if (!pDrawTarget || x < 0 || y < 0) return false;
+		if (nTargetScale > 1) { x /= nTargetScale; y /= nTargetScale; }
+		if (x >= pDrawTarget->width || y >= pDrawTarget->height) return false;
+		if (!vecTileCommands.empty()) FlushRasterizer();
+		if (pDrawTarget->pIndexData)
+			olc_PlotIndexed(pDrawTarget, x, y, p, op, false);
+		else
+			op.Fill(pDrawTarget->pColData + y * pDrawTarget->width + x, p, 1, x, y);
+		olc::vi2d& vMin = pDrawTarget->vDirtyMin;
+		olc::vi2d& vMax = pDrawTarget->vDirtyMax;
+		vMin.x = std::min(vMin.x, x);     vMin.y = std::min(vMin.y, y);
+		vMax.x = std::max(vMax.x, x + 1); vMax.y = std::max(vMax.y, y + 1);
+		return true;
 	}
 
-	// O------------------------------------------------------------------------------O
-	// | olc::Sprite IMPLEMENTATION                                                   |
-	// O------------------------------------------------------------------------------O
-	Sprite::Sprite()
-	{ pColData = nullptr; width = 0; height = 0; }
-
-	Sprite::Sprite(const std::string& sImageFile, olc::ResourcePack *pack)
-	{ LoadFromFile(sImageFile, pack); }
-
-	Sprite::Sprite(int32_t w, int32_t h)
+	template<class Op>
+	void PixelGameEngine::DrawLine(int32_t x1, int32_t y1, int32_t x2, int32_t y2, Pixel p, uint32_t pattern, const Op& op)
 	{
-		if(pColData) delete[] pColData;
-		width = w;		height = h;
-		pColData = new Pixel[width * height];
-		for (int32_t i = 0; i < width*height; i++)
-			pColData[i] = Pixel();
-	}
+		if (!pDrawTarget) return;
+		RasterTarget t = olc_Target();
+		olc_MarkDirty(std::min(x1, x2), std::min(y1, y2), std::abs(x2 - x1) + 1, std::abs(y2 - y1) + 1);
 
-	Sprite::~Sprite()
-	{ if (pColData) delete[] pColData; }
+		int x, y, dx, dy, dx1, dy1, px, py, xe, ye, i;
+		dx = x2 - x1; dy = y2 - y1;
 
+		auto rol = [&](void){ pattern = (pattern << 1) | (pattern >> 31); return pattern & 1; };
 
-	olc::rcode Sprite::LoadFromPGESprFile(const std::string& sImageFile, olc::ResourcePack *pack)
-	{
-		if (pColData) delete[] pColData;
-		auto ReadData = [&](std::istream &is)
+		// straight lines idea by gurkanctn
+		if (dx == 0) // Line is vertical
 		{
-			is.read((char*)&width, sizeof(int32_t));
-			is.read((char*)&height, sizeof(int32_t));
-			pColData = new Pixel[width * height];
-			is.read((char*)pColData, (size_t)width * (size_t)height * sizeof(uint32_t));
-		};
+			if (y2 < y1) std::swap(y1, y2);
+			for (y = y1; y <= y2; y++) if (rol()) olc_RasterPixel(t, x1, y, p, op);
+			return;
+		}
 
-		// These are essentially Memory Surfaces represented by olc::Sprite
-		// which load very fast, but are completely uncompressed
-		if (pack == nullptr)
+		if (dy == 0) // Line is horizontal
 		{
-			std::ifstream ifs;
-			ifs.open(sImageFile, std::ifstream::binary);
-			if (ifs.is_open())
+			if (x2 < x1) std::swap(x1, x2);
+			// A solid line is a single span, unless it has to be thinned out
+			if (pattern == 0xFFFFFFFF && t.nScale == 1) { olc_RasterRect(t, x1, y1, x2 + 1, y1 + 1, p, op); return; }
+			for (x = x1; x <= x2; x++) if (rol()) olc_RasterPixel(t, x, y1, p, op);
+			return;
+		}
+
+		// Line is Funk-aye
+		dx1 = abs(dx); dy1 = abs(dy);
+		px = 2 * dy1 - dx1;	py = 2 * dx1 - dy1;
+		if (dy1 <= dx1)
+		{
+			if (dx >= 0)
+			{ x = x1; y = y1; xe = x2; }
+			else
+			{ x = x2; y = y2; xe = x1; }
+
+			if (rol()) olc_RasterPixel(t, x, y, p, op);
+
+			for (i = 0; x<xe; i++)
 			{
-				ReadData(ifs);
-				return olc::OK;
+				x = x + 1;
+				if (px<0)
+					px = px + 2 * dy1;
+				else
+				{
+					if ((dx<0 && dy<0) || (dx>0 && dy>0)) y = y + 1; else y = y - 1;
+					px = px + 2 * (dy1 - dx1);
+				}
+				if (rol()) olc_RasterPixel(t, x, y, p, op);
 			}
+		}
+		else
+		{
+			if (dy >= 0)
+			{ x = x1; y = y1; ye = y2; }
 			else
-				return olc::FAIL;
+			{ x = x2; y = y2; ye = y1; }
+
+			if (rol()) olc_RasterPixel(t, x, y, p, op);
+
+			for (i = 0; y<ye; i++)
+			{
+				y = y + 1;
+				if (py <= 0)
+					py = py + 2 * dx1;
+				else
+				{
+					if ((dx<0 && dy<0) || (dx>0 && dy>0)) x = x + 1; else x = x - 1;
+					py = py + 2 * (dx1 - dy1);
+				}
+				if (rol()) olc_RasterPixel(t, x, y, p, op);
+			}
+		}
+	}
+
+	template<class Op>
+	void PixelGameEngine::DrawCircle(int32_t x, int32_t y, int32_t radius, Pixel p, uint8_t mask, const Op& op)
+	{ // Thanks to IanM-Matrix1 #PR121
+		if (!pDrawTarget) return;
+		if (radius < 0 || x < -radius || y < -radius || x - GetDrawTargetWidth() > radius || y - GetDrawTargetHeight() > radius)
+			return;
+
+		RasterTarget t = olc_Target();
+		olc_MarkDirty(x - radius, y - radius, 2 * radius + 1, 2 * radius + 1);
+
+		if (radius > 0)
+		{
+			int x0 = 0;
+			int y0 = radius;
+			int d = 3 - 2 * radius;
+
+			while (y0 >= x0) // only formulate 1/8 of circle
+			{
+				// Draw even octants
+				if (mask & 0x01) olc_RasterPixel(t, x + x0, y - y0, p, op);// Q6 - upper right right
+				if (mask & 0x04) olc_RasterPixel(t, x + y0, y + x0, p, op);// Q4 - lower lower right
+				if (mask & 0x10) olc_RasterPixel(t, x - x0, y + y0, p, op);// Q2 - lower left left
+				if (mask & 0x40) olc_RasterPixel(t, x - y0, y - x0, p, op);// Q0 - upper upper left
+				if (x0 != 0 && x0 != y0)
+				{
+					if (mask & 0x02) olc_RasterPixel(t, x + y0, y - x0, p, op);// Q7 - upper upper right
+					if (mask & 0x08) olc_RasterPixel(t, x + x0, y + y0, p, op);// Q5 - lower right right
+					if (mask & 0x20) olc_RasterPixel(t, x - y0, y + x0, p, op);// Q3 - lower lower left
+					if (mask & 0x80) olc_RasterPixel(t, x - x0, y - y0, p, op);// Q1 - upper left left
+				}
+
+				if (d < 0)
+					d += 4 * x0++ + 6;
+				else
+					d += 4 * (x0++ - y0--) + 10;
+			}
 		}
 		else
+			olc_RasterPixel(t, x, y, p, op);
+	}
+
+	template<class Op>
+	void PixelGameEngine::FillCircle(int32_t x, int32_t y, int32_t radius, Pixel p, const Op& op)
+	{ // Thanks to IanM-Matrix1 #PR121
+		if (!pDrawTarget) return;
+		if (radius < 0 || x < -radius || y < -radius || x - GetDrawTargetWidth() > radius || y - GetDrawTargetHeight() > radius)
+			return;
+
+		RasterTarget t = olc_Target();
+		olc_MarkDirty(x - radius, y - radius, 2 * radius + 1, 2 * radius + 1);
+
+		if (radius > 0)
 		{
-			ResourceBuffer rb = pack->GetFileBuffer(sImageFile);
-			std::istream is(&rb);
-			ReadData(is);
-			return olc::OK;
+			int x0 = 0;
+			int y0 = radius;
+			int d = 3 - 2 * radius;
+
+			auto drawline = [&](int sx, int ex, int y)
+			{ olc_RasterRect(t, sx, y, ex + 1, y + 1, p, op); };
+
+			while (y0 >= x0)
+			{
+				drawline(x - y0, x + y0, y - x0);
+				if (x0 > 0)	drawline(x - y0, x + y0, y + x0);
+
+				if (d < 0)
+					d += 4 * x0++ + 6;
+				else
+				{
+					if (x0 != y0)
+					{
+						drawline(x - x0, x + x0, y - y0);    
+						drawline(x - x0, x + x0, y + y0);    
+					}
+					d += 4 * (x0++ - y0--) + 10;
+				}
+			}
+		}
+		else
+			olc_RasterPixel(t, x, y, p, op);
+	}
+
+	template<class Op>
+	void PixelGameEngine::DrawRect(int32_t x, int32_t y, int32_t w, int32_t h, Pixel p, const Op& op)
+	{
+		DrawLine(x, y, x+w, y, p, 0xFFFFFFFF, op);
+		DrawLine(x+w, y, x+w, y+h, p, 0xFFFFFFFF, op);
+		DrawLine(x+w, y+h, x, y+h, p, 0xFFFFFFFF, op);
+		DrawLine(x, y+h, x, y, p, 0xFFFFFFFF, op);
+	}
+
+	template<class Op>
+	void PixelGameEngine::FillRect(int32_t x, int32_t y, int32_t w, int32_t h, Pixel p, const Op& op)
+	{
+		if (!pDrawTarget) return;
+		olc_RasterRect(olc_Target(), x, y, x + w, y + h, p, op);
+		olc_MarkDirty(x, y, w, h);
+	}
+
+	template<class Op>
+	void PixelGameEngine::DrawTriangle(int32_t x1, int32_t y1, int32_t x2, int32_t y2, int32_t x3, int32_t y3, Pixel p, const Op& op)
+	{
+		DrawLine(x1, y1, x2, y2, p, 0xFFFFFFFF, op);
+		DrawLine(x2, y2, x3, y3, p, 0xFFFFFFFF, op);
+		DrawLine(x3, y3, x1, y1, p, 0xFFFFFFFF, op);
+	}
+
+	// https://www.avrfreaks.net/sites/default/files/triangles.c
+	template<class Op>
+	void PixelGameEngine::FillTriangle(int32_t x1, int32_t y1, int32_t x2, int32_t y2, int32_t x3, int32_t y3, Pixel p, const Op& op)
+	{
+		if (!pDrawTarget) return;
+		RasterTarget rt = olc_Target();
+		int32_t bx = std::min({ x1, x2, x3 }), by = std::min({ y1, y2, y3 });
+		olc_MarkDirty(bx, by, std::max({ x1, x2, x3 }) - bx + 1, std::max({ y1, y2, y3 }) - by + 1);
+
+		auto drawline = [&](int sx, int ex, int ny) { olc_RasterRect(rt, sx, ny, ex + 1, ny + 1, p, op); };
+
+		int t1x, t2x, y, minx, maxx, t1xp, t2xp;
+		bool changed1 = false;
+		bool changed2 = false;
+		int signx1, signx2, dx1, dy1, dx2, dy2;
+		int e1, e2;
+		// Sort vertices
+		if (y1>y2) {std::swap(y1, y2); std::swap(x1, x2); }
+		if (y1>y3) {std::swap(y1, y3); std::swap(x1, x3); }
+		if (y2>y3) {std::swap(y2, y3); std::swap(x2, x3); }
+
+		t1x = t2x = x1; y = y1;   // Starting points
+		dx1 = (int)(x2 - x1);
+		if (dx1<0) { dx1 = -dx1; signx1 = -1; }	else signx1 = 1;
+		dy1 = (int)(y2 - y1);
+
+		dx2 = (int)(x3 - x1);
+		if (dx2<0) { dx2 = -dx2; signx2 = -1; } else signx2 = 1;
+		dy2 = (int)(y3 - y1);
+
+		if (dy1 > dx1) { std::swap(dx1, dy1); changed1 = true; }
+		if (dy2 > dx2) { std::swap(dy2, dx2); changed2 = true; }
+
+		e2 = (int)(dx2 >> 1);
+		// Flat top, just process the second half
+		if (y1 == y2) goto next;
+		e1 = (int)(dx1 >> 1);
+
+		for (int i = 0; i < dx1;) {
+			t1xp = 0; t2xp = 0;
+			if (t1x<t2x) { minx = t1x; maxx = t2x; }
+			else { minx = t2x; maxx = t1x; }
+			// process first line until y value is about to change
+			while (i<dx1) {
+				i++;
+				e1 += dy1;
+				while (e1 >= dx1) {
+					e1 -= dx1;
+					if (changed1) t1xp = signx1;//t1x += signx1;
+					else          goto next1;
+				}
+				if (changed1) break;
+				else t1x += signx1;
+			}
+			// Move line
+		next1:
+			// process second line until y value is about to change
+			while (1) {
+				e2 += dy2;
+				while (e2 >= dx2) {
+					e2 -= dx2;
+					if (changed2) t2xp = signx2;//t2x += signx2;
+					else          goto next2;
+				}
+				if (changed2)     break;
+				else              t2x += signx2;
+			}
+		next2:
+			if (minx>t1x) minx = t1x;
+			if (minx>t2x) minx = t2x;
+			if (maxx<t1x) maxx = t1x;
+			if (maxx<t2x) maxx = t2x;
+			drawline(minx, maxx, y);    // Draw line from min to max points found on the y
+										// Now increase y
+			if (!changed1) t1x += signx1;
+			t1x += t1xp;
+			if (!changed2) t2x += signx2;
+			t2x += t2xp;
+			y += 1;
+			if (y == y2) break;
+
+		}
+	next:
+		// Second half
+		dx1 = (int)(x3 - x2); if (dx1<0) { dx1 = -dx1; signx1 = -1; }
+		else signx1 = 1;
+		dy1 = (int)(y3 - y2);
+		t1x = x2;
+
+		if (dy1 > dx1) {   // swap values
+			std::swap(dy1, dx1);
+			changed1 = true;
+		}
+		else changed1 = false;
+
+		e1 = (int)(dx1 >> 1);
+
+		for (int i = 0; i <= dx1; i++) {
+			t1xp = 0; t2xp = 0;
+			if (t1x<t2x) { minx = t1x; maxx = t2x; }
+			else { minx = t2x; maxx = t1x; }
+			// process first line until y value is about to change
+			while (i<dx1) {
+				e1 += dy1;
+				while (e1 >= dx1) {
+					e1 -= dx1;
+					if (changed1) { t1xp = signx1; break; }//t1x += signx1;
+					else          goto next3;
+				}
+				if (changed1) break;
+				else   	   	  t1x += signx1;
+				if (i<dx1) i++;
+			}
+		next3:
+			// process second line until y value is about to change
+			while (t2x != x3) {
+				e2 += dy2;
+				while (e2 >= dx2) {
+					e2 -= dx2;
+					if (changed2) t2xp = signx2;
+					else          goto next4;
+				}
+				if (changed2)     break;
+				else              t2x += signx2;
+			}
+		next4:
+
+			if (minx>t1x) minx = t1x;
+			if (minx>t2x) minx = t2x;
+			if (maxx<t1x) maxx = t1x;
+			if (maxx<t2x) maxx = t2x;
+			drawline(minx, maxx, y);
+			if (!changed1) t1x += signx1;
+			t1x += t1xp;
+			if (!changed2) t2x += signx2;
+			t2x += t2xp;
+			y += 1;
+			if (y>y3) return;
+		}
+	}
+
+	template<class Op>
+	void PixelGameEngine::DrawPartialSprite(int32_t x, int32_t y, Sprite *sprite, int32_t ox, int32_t oy, int32_t w, int32_t h, uint32_t scale, uint8_t flip, const Op& op)
+	{
+		if (!pDrawTarget || sprite == nullptr || w <= 0 || h <= 0 || scale == 0)
+			return;
+		olc_RasterSprite(olc_Target(), x, y, sprite, ox, oy, w, h, scale, flip, op);
+		olc_MarkDirty(x, y, w * int32_t(scale), h * int32_t(scale));
+	}
+
+	template<class Op>
+	void PixelGameEngine::DrawString(int32_t x, int32_t y, const std::string& sText, Pixel col, uint32_t scale, const Op& op)
+	{
+		if (!pDrawTarget) return;
+		olc_RasterString(olc_Target(), x, y, sText, col, scale, op);
+		olc::vi2d size = GetTextSize(sText) * int32_t(scale);
+		olc_MarkDirty(x, y, size.x, size.y);
+	}
+
+
+
+	// O------------------------------------------------------------------------------O
+	// | PGE EXTENSION BASE CLASS - Permits access to PGE functions from extension    |
+	// O------------------------------------------------------------------------------O
+	class PGEX
+	{
+		friend class olc::PixelGameEngine;
+	protected:
+		static PixelGameEngine* pge;
+	};
+}
+
+#endif // OLC_PGE_DEF
+
+
+
+
+/*
+	Object Oriented Mode
+	~~~~~~~~~~~~~~~~~~~~
+
+	If the olcPixelGameEngine.h is called from several sources it can cause
+	multiple definitions of objects. To prevent this, ONLY ONE of the pathways
+	to including this file must have OLC_PGE_APPLICATION defined before it. This prevents
+	the definitions being duplicated.
+
+	If all else fails, create a file called "olcPixelGameEngine.cpp" with the following
+	two lines. Then you can just #include "olcPixelGameEngine.h" as normal without worrying
+	about defining things. Dont forget to include that cpp file as part of your build!
+
+	#define OLC_PGE_APPLICATION
+	#include "olcPixelGameEngine.h"
+
+*/
+
+
+// O------------------------------------------------------------------------------O
+// | START OF OLC_PGE_APPLICATION                                                 |
+// O------------------------------------------------------------------------------O
+#ifdef OLC_PGE_APPLICATION
+#undef OLC_PGE_APPLICATION
+
+// O------------------------------------------------------------------------------O
+// | olcPixelGameEngine INTERFACE IMPLEMENTATION (CORE)                           |
+// | Note: The core implementation is platform independent                        |
+// O------------------------------------------------------------------------------O
+namespace olc
+{
+	// O------------------------------------------------------------------------------O
+	// | olc::Pixel IMPLEMENTATION                                                    |
+	// O------------------------------------------------------------------------------O
+	Pixel::Pixel()
+	{ r = 0; g = 0; b = 0; a = nDefaultAlpha; }
+
+	Pixel::Pixel(uint8_t red, uint8_t green, uint8_t blue, uint8_t alpha)
+	{ n = red | (green << 8) | (blue << 16) | (alpha << 24); } // Thanks jarekpelczar 
+
+
+	Pixel::Pixel(uint32_t p)
+	{ n = p; }
+
+	bool Pixel::operator==(const Pixel& p) const
+	{ return n == p.n; }
+
+	bool Pixel::operator!=(const Pixel& p) const
+	{ return n != p.n; }
+
+	Pixel PixelF(float red, float green, float blue, float alpha)
+	{
+		return Pixel(uint8_t(red * 255.0f), uint8_t(green * 255.0f), uint8_t(blue * 255.0f), uint8_t(alpha * 255.0f));
+	}
+
+	// O------------------------------------------------------------------------------O
+	// | Fixed point blending                                                         |
+	// O------------------------------------------------------------------------------O
+	uint32_t BlendAlpha(uint8_t a, uint32_t nBlend)
+	{
+		uint32_t A = uint32_t(a) + (a >> 7); // 0..255 -> 0..256
+		return (A * nBlend + 128) >> 8;
+	}
+
+	// Two channels per multiply: every product fits in 16 bits, so R and B
+	// can share a register without carrying into each other
+	static inline uint32_t BlendSWAR(uint32_t d, uint32_t s, uint32_t A)
+	{
+		uint32_t rb = ((s & 0x00FF00FF) * A + (d & 0x00FF00FF) * (256 - A)) >> 8;
+		uint32_t g = (((s >> 8) & 0xFF) * A + ((d >> 8) & 0xFF) * (256 - A)) >> 8;
+		return (rb & 0x00FF00FF) | (g << 8) | 0xFF000000;
+	}
+
+	Pixel BlendPixel(Pixel d, Pixel s, uint32_t nBlend)
+	{ return Pixel(BlendSWAR(d.n, s.n, BlendAlpha(s.a, nBlend))); }
+
+	void BlendSpan(Pixel* dst, Pixel src, int32_t n, uint32_t nBlend)
+	{
+		uint32_t A = BlendAlpha(src.a, nBlend);
+		int32_t i = 0;
+#if defined(OLC_SIMD_SSE2)
+		// dst = (src * A + dst * (256 - A)) >> 8, the src term is constant
+		const __m128i vZero = _mm_setzero_si128();
+		const __m128i vOpaque = _mm_set1_epi32(int(0xFF000000));
+		const __m128i vInvA = _mm_set1_epi16(short(256 - A));
+		const __m128i vSrcA = _mm_set_epi16(
+			short(src.a * A), short(src.b * A), short(src.g * A), short(src.r * A),
+			short(src.a * A), short(src.b * A), short(src.g * A), short(src.r * A));
+		for (; i + 4 <= n; i += 4)
+		{
+			__m128i d = _mm_loadu_si128((const __m128i*)(dst + i));
+			__m128i lo = _mm_unpacklo_epi8(d, vZero);
+			__m128i hi = _mm_unpackhi_epi8(d, vZero);
+			lo = _mm_srli_epi16(_mm_add_epi16(_mm_mullo_epi16(lo, vInvA), vSrcA), 8);
+			hi = _mm_srli_epi16(_mm_add_epi16(_mm_mullo_epi16(hi, vInvA), vSrcA), 8);
+			_mm_storeu_si128((__m128i*)(dst + i), _mm_or_si128(_mm_packus_epi16(lo, hi), vOpaque));
+		}
+#endif
+		for (; i < n; i++)
+			dst[i].n = BlendSWAR(dst[i].n, src.n, A);
+	}
+
+	void BlendSpan(Pixel* dst, const Pixel* src, int32_t n, uint32_t nBlend)
+	{
+		int32_t i = 0;
+#if defined(OLC_SIMD_SSE2)
+		const __m128i vZero = _mm_setzero_si128();
+		const __m128i vOpaque = _mm_set1_epi32(int(0xFF000000));
+		const __m128i v256 = _mm_set1_epi16(256);
+		const __m128i vHalf = _mm_set1_epi16(128);
+		const __m128i vBlend = _mm_set1_epi16(short(nBlend));
+		auto Blend = [&](__m128i s, __m128i d)
+		{
+			// Each pixel's alpha across its four lanes, scaled to 0..256
+			__m128i a = _mm_shufflehi_epi16(_mm_shufflelo_epi16(s, 0xFF), 0xFF);
+			a = _mm_add_epi16(a, _mm_srli_epi16(a, 7));
+			if (nBlend < 256) a = _mm_srli_epi16(_mm_add_epi16(_mm_mullo_epi16(a, vBlend), vHalf), 8);
+			__m128i r = _mm_add_epi16(_mm_mullo_epi16(s, a), _mm_mullo_epi16(d, _mm_sub_epi16(v256, a)));
+			return _mm_srli_epi16(r, 8);
+		};
+		for (; i + 4 <= n; i += 4)
+		{
+			__m128i s = _mm_loadu_si128((const __m128i*)(src + i));
+			__m128i d = _mm_loadu_si128((const __m128i*)(dst + i));
+			__m128i lo = Blend(_mm_unpacklo_epi8(s, vZero), _mm_unpacklo_epi8(d, vZero));
+			__m128i hi = Blend(_mm_unpackhi_epi8(s, vZero), _mm_unpackhi_epi8(d, vZero));
+			_mm_storeu_si128((__m128i*)(dst + i), _mm_or_si128(_mm_packus_epi16(lo, hi), vOpaque));
+		}
+#endif
+		for (; i < n; i++)
+			dst[i].n = BlendSWAR(dst[i].n, src[i].n, BlendAlpha(src[i].a, nBlend));
+	}
+
+	void UpscaleRow(const Pixel* src, int32_t w, Pixel* dst, uint32_t factor)
+	{
+		const int32_t f = int32_t(factor);
+		if (f == 1) { std::memcpy(dst, src, size_t(w) * sizeof(Pixel)); return; }
+
+		int32_t i = 0;
+#if defined(OLC_SIMD_SSE2)
+		if (f == 2)
+		{
+			for (; i + 4 <= w; i += 4)
+			{
+				__m128i s = _mm_loadu_si128((const __m128i*)(src + i));
+				_mm_storeu_si128((__m128i*)(dst + i * 2), _mm_unpacklo_epi32(s, s));
+				_mm_storeu_si128((__m128i*)(dst + i * 2 + 4), _mm_unpackhi_epi32(s, s));
+			}
+		}
+		else if (f == 4)
+		{
+			for (; i + 4 <= w; i += 4)
+			{
+				__m128i s = _mm_loadu_si128((const __m128i*)(src + i));
+				_mm_storeu_si128((__m128i*)(dst + i * 4), _mm_shuffle_epi32(s, 0x00));
+				_mm_storeu_si128((__m128i*)(dst + i * 4 + 4), _mm_shuffle_epi32(s, 0x55));
+				_mm_storeu_si128((__m128i*)(dst + i * 4 + 8), _mm_shuffle_epi32(s, 0xAA));
+				_mm_storeu_si128((__m128i*)(dst + i * 4 + 12), _mm_shuffle_epi32(s, 0xFF));
+			}
+		}
+		else
+		{
+			// Broadcast each pixel across its run four at a time. Runs that aren't
+			// a multiple of four spill into the next, which then overwrites them
+			for (; i + 1 < w; i++)
+			{
+				__m128i s = _mm_set1_epi32(int(src[i].n));
+				for (int32_t k = 0; k < f; k += 4)
+					_mm_storeu_si128((__m128i*)(dst + i * f + k), s);
+			}
+		}
+#endif
+		for (; i < w; i++)
+			std::fill(dst + i * f, dst + (i + 1) * f, src[i]);
+	}
+
+	void UpscaleNearest(const Pixel* src, int32_t w, int32_t h, Pixel* dst, uint32_t factor)
+	{
+		size_t nRow = size_t(w) * factor;
+		for (int32_t y = 0; y < h; y++)
+		{
+			Pixel* row = dst + size_t(y) * factor * nRow;
+			UpscaleRow(src + size_t(y) * w, w, row, factor);
+			for (uint32_t k = 1; k < factor; k++)
+				std::memcpy(row + k * nRow, row, nRow * sizeof(Pixel));
+		}
+	}
+
+	// O------------------------------------------------------------------------------O
+	// | olc::Sprite IMPLEMENTATION                                                   |
+	// O------------------------------------------------------------------------------O
+	Sprite::Sprite()
+	{ pColData = nullptr; width = 0; height = 0; }
+
+	Sprite::Sprite(const std::string& sImageFile, olc::ResourcePack *pack)
+	{ LoadFromFile(sImageFile, pack); }
+
+	Sprite::Sprite(int32_t w, int32_t h)
+	{
+		if(pColData) delete[] pColData;
+		width = w;		height = h;
+		pColData = new Pixel[width * height];
+		for (int32_t i = 0; i < width*height; i++)
+			pColData[i] = Pixel();
+		MarkDirty();
+	}
+
+	Sprite::Sprite(int32_t w, int32_t h, const std::vector<Pixel>& palette)
+	: Sprite(w, h)
+	{ SetPalette(palette); }
+
+	Sprite::~Sprite()
+	{ if (pColData) delete[] pColData; if (pIndexData) delete[] pIndexData; }
+
+
+	olc::rcode Sprite::LoadFromPGESprFile(const std::string& sImageFile, olc::ResourcePack *pack)
+	{
+		if (pColData) delete[] pColData;
+		if (pIndexData) delete[] pIndexData;
+		pIndexData = nullptr; vecPalette.clear();
+		auto ReadData = [&](std::istream &is)
+		{
+			is.read((char*)&width, sizeof(int32_t));
+			is.read((char*)&height, sizeof(int32_t));
+			pColData = new Pixel[width * height];
+			is.read((char*)pColData, (size_t)width * (size_t)height * sizeof(uint32_t));
+			MarkDirty();
+		};
+
+		// These are essentially Memory Surfaces represented by olc::Sprite
+		// which load very fast, but are completely uncompressed
+		if (pack == nullptr)
+		{
+			std::ifstream ifs;
+			ifs.open(sImageFile, std::ifstream::binary);
+			if (ifs.is_open())
+			{
+				ReadData(ifs);
+				return olc::OK;
+			}
+			else
+				return olc::FAIL;
+		}
+		else
+		{
+			ResourceBuffer rb = pack->GetFileBuffer(sImageFile);
+			std::istream is(&rb);
+			ReadData(is);
+			return olc::OK;
+		}
+		return olc::FAIL;
+	}
+
+	olc::rcode Sprite::SaveToPGESprFile(const std::string& sImageFile)
+	{
+		if (pColData == nullptr && pIndexData == nullptr) return olc::FAIL;
+
+		std::ofstream ofs;
+		ofs.open(sImageFile, std::ifstream::binary);
+		if (ofs.is_open())
+		{
+			ofs.write((char*)&width, sizeof(int32_t));
+			ofs.write((char*)&height, sizeof(int32_t));
+			if (pIndexData)
+			{
+				// The file format is full colour, so indexed sprites are expanded a row at a time
+				std::vector<Pixel> vecRow(width);
+				for (int32_t y = 0; y < height; y++)
+				{
+					ExpandRow(0, y, width, vecRow.data());
+					ofs.write((char*)vecRow.data(), (size_t)width * sizeof(uint32_t));
+				}
+			}
+			else
+				ofs.write((char*)pColData, (size_t)width * (size_t)height * sizeof(uint32_t));
+			ofs.close();
+			return ofs ? olc::OK : olc::FAIL;
+		}
+
+		return olc::FAIL;
+	}
+
+	void Sprite::SetSampleMode(olc::Sprite::Mode mode)
+	{ modeSample = mode; }
+
+	Pixel Sprite::GetPixel(const olc::vi2d& a) const
+	{ return GetPixel(a.x, a.y); }
+
+	bool Sprite::SetPixel(const olc::vi2d& a, Pixel p)
+	{ return SetPixel(a.x, a.y, p); }
+
+	Pixel Sprite::GetPixel(int32_t x, int32_t y) const
+	{
+		int32_t i;
+		if (modeSample == olc::Sprite::Mode::NORMAL)
+		{
+			if (x >= 0 && x < width && y >= 0 && y < height)
+				i = y*width + x;
+			else
+				return Pixel(0, 0, 0, 0);
+		}
+		else
+		{
+			i = abs(y%height)*width + abs(x%width);
+		}
+		return pIndexData ? vecPalette[pIndexData[i]] : pColData[i];
+	}
+
+	bool Sprite::SetPixel(int32_t x, int32_t y, Pixel p)
+	{
+		if (x >= 0 && x < width && y >= 0 && y < height)
+		{
+			if (pIndexData) pIndexData[y*width + x] = PaletteIndex(p);
+			else pColData[y*width + x] = p;
+			vDirtyMin.x = std::min(vDirtyMin.x, x);     vDirtyMin.y = std::min(vDirtyMin.y, y);
+			vDirtyMax.x = std::max(vDirtyMax.x, x + 1); vDirtyMax.y = std::max(vDirtyMax.y, y + 1);
+			return true;
+		}
+		else
+			return false;
+	}
+
+	Pixel Sprite::Sample(float x, float y) const
+	{
+		int32_t sx = std::min((int32_t)((x * (float)width)), width - 1);
+		int32_t sy = std::min((int32_t)((y * (float)height)), height - 1);
+		return GetPixel(sx, sy);
+	}
+
+	Pixel Sprite::SampleBL(float u, float v) const
+	{
+		u = u * width - 0.5f;
+		v = v * height - 0.5f;
+		int x = (int)floor(u); // cast to int rounds toward zero, not downward
+		int y = (int)floor(v); // Thanks @joshinils
+		float u_ratio = u - x;
+		float v_ratio = v - y;
+		float u_opposite = 1 - u_ratio;
+		float v_opposite = 1 - v_ratio;
+
+		olc::Pixel p1 = GetPixel(std::max(x, 0), std::max(y, 0));
+		olc::Pixel p2 = GetPixel(std::min(x + 1, (int)width - 1), std::max(y, 0));
+		olc::Pixel p3 = GetPixel(std::max(x, 0), std::min(y + 1, (int)height - 1));
+		olc::Pixel p4 = GetPixel(std::min(x + 1, (int)width - 1), std::min(y + 1, (int)height - 1));
+
+		return olc::Pixel(
+			(uint8_t)((p1.r * u_opposite + p2.r * u_ratio) * v_opposite + (p3.r * u_opposite + p4.r * u_ratio) * v_ratio),
+			(uint8_t)((p1.g * u_opposite + p2.g * u_ratio) * v_opposite + (p3.g * u_opposite + p4.g * u_ratio) * v_ratio),
+			(uint8_t)((p1.b * u_opposite + p2.b * u_ratio) * v_opposite + (p3.b * u_opposite + p4.b * u_ratio) * v_ratio));
+	}
+
+	Pixel* Sprite::GetData()
+	{
+		// Callers write colours straight into the buffer, which an index can't hold
+		if (pIndexData) SetPalette({});
+		MarkDirty();
+		return pColData;
+	}
+
+	void Sprite::SetPalette(const std::vector<Pixel>& palette)
+	{
+		size_t nPixels = size_t(width) * size_t(height);
+		// Back to full colour first, so converting between palettes is one path
+		if (pIndexData)
+		{
+			pColData = new Pixel[nPixels];
+			for (size_t i = 0; i < nPixels; i++) pColData[i] = vecPalette[pIndexData[i]];
+			delete[] pIndexData;
+			pIndexData = nullptr;
+		}
+
+		vecPalette.assign(palette.begin(), palette.begin() + std::min(palette.size(), size_t(256)));
+		if (!vecPalette.empty())
+		{
+			pIndexData = new uint8_t[nPixels];
+			for (size_t i = 0; i < nPixels; i++) pIndexData[i] = PaletteIndex(pColData[i]);
+			delete[] pColData;
+			pColData = nullptr;
+		}
+		MarkDirty();
+	}
+
+	const std::vector<Pixel>& Sprite::GetPalette() const
+	{ return vecPalette; }
+
+	bool Sprite::IsIndexed() const
+	{ return pIndexData != nullptr; }
+
+	uint8_t Sprite::PaletteIndex(Pixel p) const
+	{
+		auto sq = [](int32_t a, int32_t b) { return (a - b) * (a - b); };
+		size_t nClosest = 0;
+		int32_t nBest = INT32_MAX;
+		for (size_t i = 0; i < vecPalette.size(); i++)
+		{
+			const Pixel& c = vecPalette[i];
+			int32_t d = sq(c.r, p.r) + sq(c.g, p.g) + sq(c.b, p.b) + sq(c.a, p.a);
+			if (d < nBest) { nBest = d; nClosest = i; }
+			if (d == 0) break;
+		}
+		return uint8_t(nClosest);
+	}
+
+	uint8_t* Sprite::GetIndexData()
+	{ MarkDirty(); return pIndexData; }
+
+	void Sprite::ExpandRow(int32_t x, int32_t y, int32_t n, Pixel* dst) const
+	{
+		size_t i = size_t(y) * size_t(width) + size_t(x);
+		if (pIndexData)
+		{
+			const Pixel* pal = vecPalette.data();
+			const uint8_t* src = pIndexData + i;
+			for (int32_t j = 0; j < n; j++) dst[j] = pal[src[j]];
+		}
+		else
+			std::memcpy(dst, pColData + i, size_t(n) * sizeof(Pixel));
+	}
+
+	void Sprite::MarkDirty()
+	{ vDirtyMin = { 0, 0 }; vDirtyMax = { width, height }; }
+
+	void Sprite::MarkDirty(int32_t x, int32_t y, int32_t w, int32_t h)
+	{
+		if (w <= 0 || h <= 0) return;
+		if (!IsDirty())
+		{
+			vDirtyMin = { x, y };
+			vDirtyMax = { x + w, y + h };
+		}
+		else
+		{
+			vDirtyMin.x = std::min(vDirtyMin.x, x);     vDirtyMin.y = std::min(vDirtyMin.y, y);
+			vDirtyMax.x = std::max(vDirtyMax.x, x + w); vDirtyMax.y = std::max(vDirtyMax.y, y + h);
+		}
+		vDirtyMin.x = std::max(vDirtyMin.x, 0);     vDirtyMin.y = std::max(vDirtyMin.y, 0);
+		vDirtyMax.x = std::min(vDirtyMax.x, width); vDirtyMax.y = std::min(vDirtyMax.y, height);
+	}
+
+	void Sprite::ClearDirty()
+	{ vDirtyMin = { width, height }; vDirtyMax = { 0, 0 }; }
+
+	bool Sprite::IsDirty() const
+	{ return vDirtyMax.x > vDirtyMin.x && vDirtyMax.y > vDirtyMin.y; }
+
+
+	// O------------------------------------------------------------------------------O
+	// | olc::Decal IMPLEMENTATION                                                   |
+	// O------------------------------------------------------------------------------O
+	Decal::Decal(olc::Sprite* spr)
+	{
+		id = -1;
+		if (spr == nullptr) return;
+		sprite = spr;
+		id = renderer->CreateTexture(sprite->width, sprite->height);
+		Update();
+	}
+
+	void Decal::Update()
+	{
+		if (sprite == nullptr) return;
+		vUVScale = { 1.0f / float(sprite->width), 1.0f / float(sprite->height) };
+		renderer->ApplyTexture(id);
+		renderer->UpdateTexture(id, sprite);
+	}
+
+	Decal::~Decal()
+	{
+		if (id != -1)
+		{
+			renderer->DeleteTexture(id);
+			id = -1;
+		}
+	}
+
+	void Renderable::Create(uint32_t width, uint32_t height)
+	{
+		pSprite = std::make_unique<olc::Sprite>(width, height);
+		pDecal = std::make_unique<olc::Decal>(pSprite.get());
+	}
+
+	olc::rcode Renderable::Load(const std::string& sFile, ResourcePack *pack)
+	{
+		pSprite = std::make_unique<olc::Sprite>();
+		if (pSprite->LoadFromFile(sFile, pack))
+		{
+			pDecal = std::make_unique<olc::Decal>(pSprite.get());
+			return olc::rcode::OK;
+		}
+		else
+		{
+			pSprite.release();
+			pSprite = nullptr;
+			return olc::rcode::NO_FILE;
+		}
+	}
+
+	olc::Decal* Renderable::Decal() const
+	{ return pDecal.get(); }
+
+	olc::Sprite* Renderable::Sprite() const
+	{ return pSprite.get(); }
+
+	// O------------------------------------------------------------------------------O
+	// | olc::FrameRecorder IMPLEMENTATION                                            |
+	// O------------------------------------------------------------------------------O
+	FrameRecorder::~FrameRecorder()
+	{ Stop(); }
+
+	olc::rcode FrameRecorder::Start(const std::string& sFile, Format format, int32_t width, int32_t height,
+		uint32_t nFrameRate, const olc::Sprite* backdrop, uint32_t nPoolSize)
+	{
+		if (IsRecording() || width <= 0 || height <= 0 || nPoolSize == 0) return olc::FAIL;
+
+		ofsFile.open(sFile, std::ofstream::binary);
+		if (!ofsFile.is_open()) return olc::NO_FILE;
+
+		nFormat = format;
+		vSize = { width, height };
+		size_t nPixels = size_t(width) * size_t(height);
+
+		vecBackdrop.assign(nPixels, olc::BLACK);
+		if (backdrop != nullptr && backdrop->width == width && backdrop->height == height)
+			std::copy(backdrop->pColData, backdrop->pColData + nPixels, vecBackdrop.begin());
+		vecStaging.resize(nPixels * (format == Format::Y4M ? 3 : 4));
+
+		for (uint32_t i = 0; i < nPoolSize; i++)
+			qFree.push_back(new olc::Pixel[nPixels]);
+
+		if (format == Format::Y4M)
+			ofsFile << "YUV4MPEG2 W" << width << " H" << height << " F" << nFrameRate << ":1 Ip A1:1 C444 XCOLORRANGE=FULL\n";
+
+		nFramesWritten = nFramesDropped = nFramesCaptured = 0;
+		fTotalCaptureUs = fMaxCaptureUs = 0.0;
+		bStopping = false;
+		tEncoder = std::thread(&FrameRecorder::EncoderThread, this);
+		return olc::OK;
+	}
+
+	void FrameRecorder::Stop()
+	{
+		if (!IsRecording()) return;
+		{
+			std::lock_guard<std::mutex> lock(muxQueue);
+			bStopping = true;
+		}
+		cvQueue.notify_one();
+		tEncoder.join();
+
+		ofsFile.close();
+		// The encoder drained qFilled before returning. Buffers swapped into
+		// sprites belong to those sprites now, and are not freed here
+		for (auto p : qFree) delete[] p;
+		for (auto p : qFilled) delete[] p;
+		qFree.clear();
+		qFilled.clear();
+	}
+
+	bool FrameRecorder::IsRecording() const
+	{ return tEncoder.joinable(); }
+
+	void FrameRecorder::Capture(olc::Sprite* spr, uint32_t nUpscale)
+	{
+		// Upscaled sprites may overhang the frame by less than a pixel
+		int32_t f = int32_t(nUpscale);
+		if (!IsRecording() || spr == nullptr || f < 1
+			|| spr->width * f < vSize.x || (spr->width - 1) * f >= vSize.x
+			|| spr->height * f < vSize.y || (spr->height - 1) * f >= vSize.y) return;
+
+		auto tp1 = std::chrono::steady_clock::now();
+		olc::Pixel* pRecycled = nullptr;
+		if (spr->IsIndexed() || f > 1)
+		{
+			// Nothing to swap, the frame is expanded into a free buffer instead
+			{
+				std::lock_guard<std::mutex> lock(muxQueue);
+				if (!qFree.empty()) { pRecycled = qFree.front(); qFree.pop_front(); }
+			}
+			if (pRecycled != nullptr)
+			{
+				vecCaptureRow.resize(size_t(spr->width) * size_t(f + 1));
+				olc::Pixel* pRow = vecCaptureRow.data();
+				olc::Pixel* pScaled = pRow + spr->width;
+				for (int32_t y = 0; y < spr->height; y++)
+				{
+					if (f == 1) { spr->ExpandRow(0, y, vSize.x, pRecycled + y * vSize.x); continue; }
+					spr->ExpandRow(0, y, spr->width, pRow);
+					olc::UpscaleRow(pRow, spr->width, pScaled, nUpscale);
+					for (int32_t k = y * f; k < std::min((y + 1) * f, vSize.y); k++)
+						std::memcpy(pRecycled + k * vSize.x, pScaled, size_t(vSize.x) * sizeof(olc::Pixel));
+				}
+				{
+					std::lock_guard<std::mutex> lock(muxQueue);
+					qFilled.push_back(pRecycled);
+				}
+				cvQueue.notify_one();
+			}
+		}
+		else
+		{
+			{
+				std::lock_guard<std::mutex> lock(muxQueue);
+				if (!qFree.empty())
+				{
+					pRecycled = qFree.front();
+					qFree.pop_front();
+					qFilled.push_back(spr->pColData);
+				}
+			}
+
+			if (pRecycled != nullptr)
+			{
+				cvQueue.notify_one();
+				spr->pColData = pRecycled;
+				spr->MarkDirty();
+			}
+		}
+
+		std::chrono::duration<double, std::micro> us = std::chrono::steady_clock::now() - tp1;
+		std::lock_guard<std::mutex> lock(muxQueue);
+		if (pRecycled == nullptr) nFramesDropped++;
+		nFramesCaptured++;
+		fTotalCaptureUs += us.count();
+		fMaxCaptureUs = std::max(fMaxCaptureUs, us.count());
+	}
+
+	FrameRecorder::Stats FrameRecorder::GetStats() const
+	{
+		std::lock_guard<std::mutex> lock(muxQueue);
+		Stats s;
+		s.nFramesWritten = nFramesWritten;
+		s.nFramesDropped = nFramesDropped;
+		s.fMeanCaptureUs = nFramesCaptured > 0 ? fTotalCaptureUs / double(nFramesCaptured) : 0.0;
+		s.fMaxCaptureUs = fMaxCaptureUs;
+		return s;
+	}
+
+	void FrameRecorder::EncoderThread()
+	{
+		OLC_PROFILE_THREAD("Encoder");
+		while (true)
+		{
+			olc::Pixel* frame = nullptr;
+			{
+				std::unique_lock<std::mutex> lock(muxQueue);
+				cvQueue.wait(lock, [&] { return bStopping || !qFilled.empty(); });
+				// Drain whatever is queued before honouring a stop
+				if (qFilled.empty()) return;
+				frame = qFilled.front();
+				qFilled.pop_front();
+			}
+
+			{
+				OLC_PROFILE_ZONE("WriteFrame");
+				WriteFrame(frame);
+			}
+
+			std::lock_guard<std::mutex> lock(muxQueue);
+			qFree.push_back(frame);
+			nFramesWritten++;
+		}
+	}
+
+	void FrameRecorder::WriteFrame(const olc::Pixel* frame)
+	{
+		size_t nPixels = size_t(vSize.x) * size_t(vSize.y);
+		uint8_t* pY = vecStaging.data();
+		uint8_t* pU = pY + nPixels;
+		uint8_t* pV = pU + nPixels;
+
+		for (size_t i = 0; i < nPixels; i++)
+		{
+			// Frame over backdrop, as the layers would be composited
+			olc::Pixel s = frame[i], d = vecBackdrop[i];
+			int32_t a = s.a;
+			int32_t r = (s.r * a + d.r * (255 - a) + 127) / 255;
+			int32_t g = (s.g * a + d.g * (255 - a) + 127) / 255;
+			int32_t b = (s.b * a + d.b * (255 - a) + 127) / 255;
+
+			if (nFormat == Format::Y4M)
+			{
+				// BT.601, full range, 8 bit fixed point
+				pY[i] = uint8_t((77 * r + 150 * g + 29 * b + 128) >> 8);
+				pU[i] = uint8_t(((-43 * r - 85 * g + 128 * b + 128) >> 8) + 128);
+				pV[i] = uint8_t(((128 * r - 107 * g - 21 * b + 128) >> 8) + 128);
+			}
+			else
+			{
+				pY[i * 4 + 0] = uint8_t(r);
+				pY[i * 4 + 1] = uint8_t(g);
+				pY[i * 4 + 2] = uint8_t(b);
+				pY[i * 4 + 3] = 255;
+			}
+		}
+
+		if (nFormat == Format::Y4M) ofsFile << "FRAME\n";
+		ofsFile.write((const char*)vecStaging.data(), std::streamsize(vecStaging.size()));
+	}
+
+	// O------------------------------------------------------------------------------O
+	// | olc::WorkerPool IMPLEMENTATION                                               |
+	// O------------------------------------------------------------------------------O
+	WorkerPool::~WorkerPool()
+	{ Stop(); }
+
+	void WorkerPool::Start(uint32_t nThreads)
+	{
+		Stop();
+		bStopping = false;
+		for (uint32_t i = 1; i < nThreads; i++)
+			vecThreads.emplace_back(&WorkerPool::WorkerThread, this);
+	}
+
+	void WorkerPool::Stop()
+	{
+		{
+			std::lock_guard<std::mutex> lock(muxJobs);
+			bStopping = true;
+		}
+		cvStart.notify_all();
+		for (auto& t : vecThreads) t.join();
+		vecThreads.clear();
+	}
+
+	uint32_t WorkerPool::GetThreadCount() const
+	{ return uint32_t(vecThreads.size()) + 1; }
+
+	void WorkerPool::ParallelFor(uint32_t nJobCount, const std::function<void(uint32_t)>& job)
+	{
+		if (vecThreads.empty() || nJobCount < 2)
+		{
+			for (uint32_t i = 0; i < nJobCount; i++) job(i);
+			return;
+		}
+
+		{
+			std::lock_guard<std::mutex> lock(muxJobs);
+			pJob = &job;
+			nJobs = nJobCount;
+			nNextJob = 0;
+			nBusy = uint32_t(vecThreads.size());
+			nGeneration++;
 		}
-		return olc::FAIL;
+		cvStart.notify_all();
+
+		RunJobs();
+
+		std::unique_lock<std::mutex> lock(muxJobs);
+		cvDone.wait(lock, [&] { return nBusy == 0; });
+		pJob = nullptr;
 	}
 
-	olc::rcode Sprite::SaveToPGESprFile(const std::string& sImageFile)
+	void WorkerPool::RunJobs()
 	{
-		if (pColData == nullptr) return olc::FAIL;
+		for (uint32_t i = nNextJob++; i < nJobs; i = nNextJob++)
+			(*pJob)(i);
+	}
 
-		std::ofstream ofs;
-		ofs.open(sImageFile, std::ifstream::binary);
-		if (ofs.is_open())
+	void WorkerPool::WorkerThread()
+	{
+		OLC_PROFILE_THREAD("Worker");
+		uint64_t nSeen = 0;
+		std::unique_lock<std::mutex> lock(muxJobs);
+		while (true)
 		{
-			ofs.write((char*)&width, sizeof(int32_t));
-			ofs.write((char*)&height, sizeof(int32_t));
-			ofs.write((char*)pColData, (size_t)width * (size_t)height * sizeof(uint32_t));
-			ofs.close();
-			return olc::OK;
-		}
+			cvStart.wait(lock, [&] { return bStopping || nGeneration != nSeen; });
+			if (bStopping) return;
+			nSeen = nGeneration;
 
-		return olc::FAIL;
+			lock.unlock();
+			RunJobs();
+			lock.lock();
+
+			if (--nBusy == 0) cvDone.notify_one();
+		}
 	}
 
-	void Sprite::SetSampleMode(olc::Sprite::Mode mode)
-	{ modeSample = mode; }
+	// O------------------------------------------------------------------------------O
+	// | olc::FrameScheduler IMPLEMENTATION                                           |
+	// O------------------------------------------------------------------------------O
+	void FrameScheduler::SetTargetRate(double fHz, Mode mode)
+	{
+		dPeriod = fHz > 0.0 ? std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / fHz)) : Clock::duration(0);
+		nMode = mode;
+		bScheduled = false;
+		ResetStats();
+	}
 
-	Pixel Sprite::GetPixel(const olc::vi2d& a) const
-	{ return GetPixel(a.x, a.y); }
+	double FrameScheduler::GetTargetRate() const
+	{ return dPeriod.count() > 0 ? 1.0 / std::chrono::duration<double>(dPeriod).count() : 0.0; }
 
-	bool Sprite::SetPixel(const olc::vi2d& a, Pixel p)
-	{ return SetPixel(a.x, a.y, p); }
+	FrameScheduler::Mode FrameScheduler::GetMode() const
+	{ return nMode; }
 
-	Pixel Sprite::GetPixel(int32_t x, int32_t y) const
+	FrameScheduler::Clock::time_point FrameScheduler::Wait()
 	{
-		if (modeSample == olc::Sprite::Mode::NORMAL)
+		Clock::time_point tpStart = Clock::now();
+		Clock::time_point tpTarget = tpStart;
+		if (dPeriod.count() > 0)
 		{
-			if (x >= 0 && x < width && y >= 0 && y < height)
-				return pColData[y*width + x];
+			if (!bScheduled)
+			{
+				// The first frame starts the schedule
+				bScheduled = true;
+				tpDeadline = tpStart + Lead();
+			}
 			else
-				return Pixel(0, 0, 0, 0);
+			{
+				tpDeadline += dPeriod;
+				tpTarget = tpDeadline - Lead();
+				if (tpStart >= tpTarget + dPeriod)
+				{
+					nMissed++;
+					tpDeadline = tpStart + Lead();
+					tpTarget = tpStart;
+				}
+				else if (tpStart < tpTarget)
+				{
+					WaitUntil(tpTarget);
+					tpStart = Clock::now();
+				}
+			}
 		}
-		else
+		double fLatenessUs = std::chrono::duration<double, std::micro>(tpStart - tpTarget).count();
+
+		if (nFrames > 0)
 		{
-			return pColData[abs(y%height)*width + abs(x%width)];
+			double fIntervalUs = std::chrono::duration<double, std::micro>(tpStart - tpLastStart).count();
+			fSumIntervalUs += fIntervalUs;
+			fSumIntervalSqUs += fIntervalUs * fIntervalUs;
+			nIntervals++;
 		}
+		fSumLatenessUs += fLatenessUs;
+		fMaxLatenessUs = std::max(fMaxLatenessUs, fLatenessUs);
+		tpLastStart = tpStart;
+		nFrames++;
+		return tpStart;
 	}
 
-	bool Sprite::SetPixel(int32_t x, int32_t y, Pixel p)
+	void FrameScheduler::FrameReady()
 	{
-		if (x >= 0 && x < width && y >= 0 && y < height)
+		double fCostUs = std::chrono::duration<double, std::micro>(Clock::now() - tpLastStart).count();
+		if (!bCostKnown)
 		{
-			pColData[y*width + x] = p;
-			return true;
+			bCostKnown = true;
+			fCostMeanUs = fCostUs;
+			fCostVarUs = 0.0;
+			return;
+		}
+		const double fWeight = 1.0 / 16.0;
+		double fDelta = fCostUs - fCostMeanUs;
+		fCostMeanUs += fWeight * fDelta;
+		fCostVarUs = (1.0 - fWeight) * (fCostVarUs + fWeight * fDelta * fDelta);
+	}
+
+	void FrameScheduler::FramePresented()
+	{
+		Clock::time_point tpPresent = Clock::now();
+		double fAgeUs = std::chrono::duration<double, std::micro>(tpPresent - tpLastStart).count();
+		fSumInputAgeUs += fAgeUs;
+		fMaxInputAgeUs = std::max(fMaxInputAgeUs, fAgeUs);
+		nPresents++;
+
+		if (nMode != Mode::JUST_IN_TIME || !bScheduled) return;
+
+		// A present that waited for the display returns shortly after the
+		// refresh it made, so only a present a good part of a period late
+		// missed one. Each miss buys more margin, which then decays again
+		Clock::time_point tpLate = bPresentSync ? tpDeadline + dPeriod / 2 : tpDeadline;
+		if (tpPresent > tpLate)
+		{
+			nMissed++;
+			fMarginDevs = std::min(fMarginDevs + 1.0, 8.0);
 		}
 		else
-			return false;
+			fMarginDevs = std::max(fMarginDevs - 1.0 / 64.0, 3.0);
+
+		// The refresh a synced present returned on is where deadlines belong
+		if (bPresentSync)
+			tpDeadline = tpPresent;
 	}
 
-	Pixel Sprite::Sample(float x, float y) const
+	void FrameScheduler::SetPresentSync(bool b)
+	{ bPresentSync = b; }
+
+	FrameScheduler::Clock::duration FrameScheduler::Lead() const
 	{
-		int32_t sx = std::min((int32_t)((x * (float)width)), width - 1);
-		int32_t sy = std::min((int32_t)((y * (float)height)), height - 1);
-		return GetPixel(sx, sy);
+		if (nMode != Mode::JUST_IN_TIME || !bCostKnown) return Clock::duration(0);
+
+		// A few deviations cover all but the rarest slow frames, and the floor
+		// covers waking up and presenting
+		double fLeadUs = fCostMeanUs + fMarginDevs * std::sqrt(fCostVarUs) + 250.0;
+		Clock::duration dLead = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double, std::micro>(fLeadUs));
+		return std::min(dLead, dPeriod);
 	}
 
-	Pixel Sprite::SampleBL(float u, float v) const
+	void FrameScheduler::WaitUntil(Clock::time_point tp)
 	{
-		u = u * width - 0.5f;
-		v = v * height - 0.5f;
-		int x = (int)floor(u); // cast to int rounds toward zero, not downward
-		int y = (int)floor(v); // Thanks @joshinils
-		float u_ratio = u - x;
-		float v_ratio = v - y;
-		float u_opposite = 1 - u_ratio;
-		float v_opposite = 1 - v_ratio;
+		if (nMode == Mode::LOW_POWER)
+		{
+			std::this_thread::sleep_until(tp);
+			return;
+		}
 
-		olc::Pixel p1 = GetPixel(std::max(x, 0), std::max(y, 0));
-		olc::Pixel p2 = GetPixel(std::min(x + 1, (int)width - 1), std::max(y, 0));
-		olc::Pixel p3 = GetPixel(std::max(x, 0), std::min(y + 1, (int)height - 1));
-		olc::Pixel p4 = GetPixel(std::min(x + 1, (int)width - 1), std::min(y + 1, (int)height - 1));
+		Clock::time_point tpWake = tp - dSpinMargin;
+		if (tpWake > Clock::now())
+		{
+			std::this_thread::sleep_until(tpWake);
+
+			// Widen the margin at once to cover a late wake-up, then let it
+			// shrink back slowly while wake-ups stay prompt
+			Clock::duration dLate = Clock::now() - tpWake;
+			Clock::duration dWanted = dLate + dLate / 4;
+			dSpinMargin = dWanted > dSpinMargin ? dWanted : dSpinMargin - dSpinMargin / 64;
+			dSpinMargin = std::clamp<Clock::duration>(dSpinMargin, std::chrono::microseconds(50), std::chrono::milliseconds(4));
+		}
 
-		return olc::Pixel(
-			(uint8_t)((p1.r * u_opposite + p2.r * u_ratio) * v_opposite + (p3.r * u_opposite + p4.r * u_ratio) * v_ratio),
-			(uint8_t)((p1.g * u_opposite + p2.g * u_ratio) * v_opposite + (p3.g * u_opposite + p4.g * u_ratio) * v_ratio),
-			(uint8_t)((p1.b * u_opposite + p2.b * u_ratio) * v_opposite + (p3.b * u_opposite + p4.b * u_ratio) * v_ratio));
+		while (Clock::now() < tp)
+			std::this_thread::yield();
 	}
 
-	Pixel* Sprite::GetData()
-	{ return pColData; }
+	FrameScheduler::Stats FrameScheduler::GetStats() const
+	{
+		Stats s;
+		s.nFrames = nFrames;
+		s.nMissed = nMissed;
+		if (nIntervals > 0)
+		{
+			s.fMeanIntervalUs = fSumIntervalUs / double(nIntervals);
+			s.fStdDevIntervalUs = std::sqrt(std::max(0.0, fSumIntervalSqUs / double(nIntervals) - s.fMeanIntervalUs * s.fMeanIntervalUs));
+		}
+		if (nFrames > 0)
+			s.fMeanLatenessUs = fSumLatenessUs / double(nFrames);
+		s.fMaxLatenessUs = fMaxLatenessUs;
+		if (nPresents > 0)
+			s.fMeanInputAgeUs = fSumInputAgeUs / double(nPresents);
+		s.fMaxInputAgeUs = fMaxInputAgeUs;
+		return s;
+	}
 
+	void FrameScheduler::ResetStats()
+	{
+		nFrames = nMissed = nIntervals = nPresents = 0;
+		fSumIntervalUs = fSumIntervalSqUs = fSumLatenessUs = fMaxLatenessUs = 0.0;
+		fSumInputAgeUs = fMaxInputAgeUs = 0.0;
+	}
 
 	// O------------------------------------------------------------------------------O
-	// | olc::Decal IMPLEMENTATION                                                   |
+	// | olc::Profiler IMPLEMENTATION                                                 |
 	// O------------------------------------------------------------------------------O
-	Decal::Decal(olc::Sprite* spr)
+	std::atomic<bool> Profiler::bEnabled{ false };
+	std::mutex Profiler::muxRings;
+	std::vector<std::shared_ptr<Profiler::Ring>> Profiler::vecRings;
+	size_t Profiler::nCapacity = size_t(1) << 16;
+
+	void Profiler::Enable(bool b)
+	{ bEnabled = b; }
+
+	void Profiler::SetCapacity(size_t nZones)
 	{
-		id = -1;
-		if (spr == nullptr) return;
-		sprite = spr;
-		id = renderer->CreateTexture(sprite->width, sprite->height);
-		Update();
+		std::lock_guard<std::mutex> lock(muxRings);
+		nCapacity = 1;
+		while (nCapacity < nZones) nCapacity <<= 1;
 	}
 
-	void Decal::Update()
+	void Profiler::SetThreadName(const std::string& sName)
 	{
-		if (sprite == nullptr) return;
-		vUVScale = { 1.0f / float(sprite->width), 1.0f / float(sprite->height) };
-		renderer->ApplyTexture(id);
-		renderer->UpdateTexture(id, sprite);
+		Ring& ring = LocalRing();
+		std::lock_guard<std::mutex> lock(muxRings);
+		ring.sThreadName = sName;
 	}
 
-	Decal::~Decal()
+	Profiler::Ring& Profiler::LocalRing()
 	{
-		if (id != -1)
+		thread_local std::shared_ptr<Ring> ring = []
 		{
-			renderer->DeleteTexture(id);
-			id = -1;
-		}
+			auto r = std::make_shared<Ring>();
+			std::lock_guard<std::mutex> lock(muxRings);
+			r->pSlots.reset(new Slot[nCapacity]);
+			r->nSlots = nCapacity;
+			r->nThread = uint32_t(vecRings.size()) + 1;
+			vecRings.push_back(r);
+			return r;
+		}();
+		return *ring;
 	}
 
-	void Renderable::Create(uint32_t width, uint32_t height)
+	void Profiler::Record(const char* sName, uint64_t nStartNs, uint64_t nEndNs)
 	{
-		pSprite = std::make_unique<olc::Sprite>(width, height);
-		pDecal = std::make_unique<olc::Decal>(pSprite.get());
+		Ring& ring = LocalRing();
+		uint64_t n = ring.nWritten.load(std::memory_order_relaxed);
+		// Pairs with Snapshot's acquire fence: whoever sees this zone's fields
+		// then sees nWritten at n at least, so knows the slot was being reused
+		std::atomic_thread_fence(std::memory_order_release);
+		Slot& slot = ring.pSlots[size_t(n) & (ring.nSlots - 1)];
+		slot.sName.store(sName, std::memory_order_relaxed);
+		slot.nStartNs.store(nStartNs, std::memory_order_relaxed);
+		slot.nEndNs.store(nEndNs, std::memory_order_relaxed);
+		ring.nWritten.store(n + 1, std::memory_order_release);
 	}
 
-	olc::rcode Renderable::Load(const std::string& sFile, ResourcePack *pack)
+	std::vector<Profiler::Zone> Profiler::Snapshot(const Ring& ring)
 	{
-		pSprite = std::make_unique<olc::Sprite>();
-		if (pSprite->LoadFromFile(sFile, pack))
+		uint64_t nEnd = ring.nWritten.load(std::memory_order_acquire);
+		uint64_t nBegin = std::max(ring.nCleared.load(std::memory_order_relaxed),
+			nEnd > ring.nSlots ? nEnd - ring.nSlots : 0);
+		std::vector<Zone> vecZones;
+		vecZones.reserve(size_t(nEnd - nBegin));
+		for (uint64_t i = nBegin; i < nEnd; i++)
 		{
-			pDecal = std::make_unique<olc::Decal>(pSprite.get());
-			return olc::rcode::OK;
+			const Slot& slot = ring.pSlots[size_t(i) & (ring.nSlots - 1)];
+			vecZones.push_back({ slot.sName.load(std::memory_order_relaxed),
+				slot.nStartNs.load(std::memory_order_relaxed), slot.nEndNs.load(std::memory_order_relaxed) });
 		}
-		else
+
+		// Zone i's slot is reused by zone i + nSlots, which is being written
+		// once nWritten has reached it, so drop any copied from such slots
+		std::atomic_thread_fence(std::memory_order_acquire);
+		uint64_t nNow = ring.nWritten.load(std::memory_order_relaxed);
+		if (nNow >= nBegin + ring.nSlots)
+			vecZones.erase(vecZones.begin(), vecZones.begin() + size_t(std::min(nNow - ring.nSlots + 1 - nBegin, nEnd - nBegin)));
+		return vecZones;
+	}
+
+	olc::rcode Profiler::WriteChromeTrace(const std::string& sFile)
+	{
+		std::ofstream ofs(sFile);
+		if (!ofs.is_open()) return olc::FAIL;
+
+		std::lock_guard<std::mutex> lock(muxRings);
+
+		// Each thread's zones are copied first, so none change while written out
+		std::vector<std::vector<Zone>> vecSnapshots;
+		for (auto& ring : vecRings)
+			vecSnapshots.push_back(Snapshot(*ring));
+
+		// Timestamps are microseconds from the earliest zone still held
+		uint64_t nOrigin = UINT64_MAX;
+		for (auto& vecZones : vecSnapshots)
+			for (auto& z : vecZones)
+				nOrigin = std::min(nOrigin, z.nStartNs);
+
+		auto Escape = [](const std::string& s)
 		{
-			pSprite.release();
-			pSprite = nullptr;
-			return olc::rcode::NO_FILE;
+			std::string e;
+			for (char c : s)
+			{
+				if (c == '"' || c == '\\') e += '\\';
+				if (uint8_t(c) >= 0x20) e += c;
+			}
+			return e;
+		};
+
+		ofs << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+		bool bFirst = true;
+		auto Separator = [&]() -> const char* { const char* sep = bFirst ? "\n" : ",\n"; bFirst = false; return sep; };
+		char sTime[64];
+		for (size_t r = 0; r < vecRings.size(); r++)
+		{
+			auto& ring = vecRings[r];
+			if (!ring->sThreadName.empty())
+				ofs << Separator() << "{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":1,\"tid\":" << ring->nThread
+					<< ",\"args\":{\"name\":\"" << Escape(ring->sThreadName) << "\"}}";
+
+			for (const Zone& z : vecSnapshots[r])
+			{
+				std::snprintf(sTime, sizeof(sTime), "\"ts\":%.3f,\"dur\":%.3f",
+					double(z.nStartNs - nOrigin) / 1000.0, double(z.nEndNs - z.nStartNs) / 1000.0);
+				ofs << Separator() << "{\"ph\":\"X\",\"name\":\"" << Escape(z.sName) << "\",\"pid\":1,\"tid\":"
+					<< ring->nThread << "," << sTime << "}";
+			}
 		}
+		ofs << "\n]}\n";
+		return ofs.good() ? olc::OK : olc::FAIL;
 	}
 
-	olc::Decal* Renderable::Decal() const
-	{ return pDecal.get(); }
-
-	olc::Sprite* Renderable::Sprite() const
-	{ return pSprite.get(); }
+	void Profiler::Clear()
+	{
+		std::lock_guard<std::mutex> lock(muxRings);
+		for (auto& ring : vecRings) ring->nCleared = ring->nWritten.load();
+	}
 
 	// O------------------------------------------------------------------------------O
 	// | olc::ResourcePack IMPLEMENTATION                                             |
@@ -1295,13 +3258,7 @@ namespace olc
 	void PixelGameEngine::SetScreenSize(int w, int h)
 	{
 		vScreenSize = { w, h };
-		for (auto& layer : vLayers)
-		{
-			delete layer.pDrawTarget; // Erase existing layer sprites
-			layer.pDrawTarget = new Sprite(vScreenSize.x, vScreenSize.y);
-			layer.bUpdate = true;
-		}
-		SetDrawTarget(nullptr);
+		olc_ResizeLayers();
 
 		renderer->ClearBuffer(olc::BLACK, true);
 		renderer->DisplayFrame();
@@ -1336,14 +3293,19 @@ namespace olc
 
 	void PixelGameEngine::SetDrawTarget(Sprite *target)
 	{
+		FlushRasterizer();
 		if (target)
 		{
 			pDrawTarget = target;
+			nTargetScale = 1;
+			for (const auto& layer : vLayers)
+				if (layer.pDrawTarget == target) nTargetScale = nRenderScale;
 		}
 		else
 		{
 			nTargetLayer = 0;
 			pDrawTarget = vLayers[0].pDrawTarget;
+			nTargetScale = nRenderScale;
 		}
 	}
 
@@ -1351,7 +3313,9 @@ namespace olc
 	{
 		if (layer < vLayers.size())
 		{
+			FlushRasterizer();
 			pDrawTarget = vLayers[layer].pDrawTarget;
+			nTargetScale = nRenderScale;
 			vLayers[layer].bUpdate = true;
 			nTargetLayer = layer;
 		}
@@ -1378,26 +3342,66 @@ namespace olc
 	void PixelGameEngine::SetLayerCustomRenderFunction(uint8_t layer, std::function<void()> f)
 	{ if (layer < vLayers.size()) vLayers[layer].funcHook = f; }
 
+	void PixelGameEngine::SetRenderScale(uint32_t nDivisor)
+	{
+		FlushRasterizer();
+		nRenderScale = std::max(int32_t(nDivisor), 1);
+		olc_ResizeLayers();
+	}
+
+	uint32_t PixelGameEngine::GetRenderScale() const
+	{ return uint32_t(nRenderScale); }
+
+	olc::vi2d PixelGameEngine::olc_LayerSize() const
+	{ return (vScreenSize + olc::vi2d(nRenderScale - 1, nRenderScale - 1)) / nRenderScale; }
+
+	void PixelGameEngine::olc_ResizeLayers()
+	{
+		olc::vi2d size = olc_LayerSize();
+		for (auto& layer : vLayers)
+		{
+			std::vector<olc::Pixel> palette = layer.pDrawTarget->GetPalette();
+			delete layer.pDrawTarget; // Erase existing layer sprites
+			layer.pDrawTarget = new Sprite(size.x, size.y, palette);
+			layer.bUpdate = true;
+		}
+		pTileTarget = nullptr;
+		SetDrawTarget(nullptr);
+	}
+
+	void PixelGameEngine::SetLayerPalette(uint8_t layer, const std::vector<olc::Pixel>& palette)
+	{
+		if (layer >= vLayers.size()) return;
+		FlushRasterizer();
+		vLayers[layer].pDrawTarget->SetPalette(palette);
+		vLayers[layer].bUpdate = true;
+	}
+
 	std::vector<LayerDesc>& PixelGameEngine::GetLayers()
 	{ return vLayers; }
 
 	uint32_t PixelGameEngine::CreateLayer()
 	{
 		LayerDesc ld;
-		ld.pDrawTarget = new olc::Sprite(vScreenSize.x, vScreenSize.y);
-		ld.nResID = renderer->CreateTexture(vScreenSize.x, vScreenSize.y);
+		olc::vi2d size = olc_LayerSize();
+		ld.pDrawTarget = new olc::Sprite(size.x, size.y);
+		ld.nResID = renderer->CreateTexture(size.x, size.y);
 		renderer->UpdateTexture(ld.nResID, ld.pDrawTarget);		
 		vLayers.push_back(ld);
 		return uint32_t(vLayers.size()) - 1;
 	}
 
 	Sprite* PixelGameEngine::GetDrawTarget()
-	{ return pDrawTarget; }
+	{
+		// The caller may read or write the pixels directly
+		FlushRasterizer();
+		return pDrawTarget;
+	}
 
 	int32_t PixelGameEngine::GetDrawTargetWidth()
 	{
 		if (pDrawTarget)
-			return pDrawTarget->width;
+			return pDrawTarget->width * nTargetScale;
 		else
 			return 0;
 	}
@@ -1405,7 +3409,7 @@ namespace olc
 	int32_t PixelGameEngine::GetDrawTargetHeight()
 	{
 		if (pDrawTarget)
-			return pDrawTarget->height;
+			return pDrawTarget->height * nTargetScale;
 		else
 			return 0;
 	}
@@ -1413,6 +3417,50 @@ namespace olc
 	uint32_t PixelGameEngine::GetFPS()
 	{ return nLastFPS; }
 
+	uint32_t PixelGameEngine::GetUploadBytes()
+	{ return nLastUploadBytes; }
+
+	olc::Sprite* PixelGameEngine::GetFrameBuffer()
+	{ return renderer->ReadFrame(); }
+
+	olc::rcode PixelGameEngine::StartRecording(const std::string& sFile, olc::FrameRecorder::Format format, uint32_t nFrameRate)
+	{
+		if (vLayers.empty()) return olc::FAIL;
+		olc::Sprite* frame = vLayers[0].pDrawTarget;
+
+		// Frames are recorded at screen size, even if layers are scaled down
+		int32_t w = vScreenSize.x, h = vScreenSize.y;
+
+		// Flatten the other visible layers, back to front, into the backdrop
+		olc::Sprite backdrop(w, h);
+		std::fill(backdrop.pColData, backdrop.pColData + size_t(w) * size_t(h), olc::BLACK);
+		for (size_t i = vLayers.size() - 1; i > 0; i--)
+		{
+			const olc::Sprite* layer = vLayers[i].pDrawTarget;
+			if (!vLayers[i].bShow || layer->width != frame->width || layer->height != frame->height) continue;
+			for (int32_t p = 0; p < w * h; p++)
+			{
+				olc::Pixel s = layer->GetPixel(p % w / nRenderScale, p / w / nRenderScale), d = backdrop.pColData[p];
+				backdrop.pColData[p] = olc::Pixel(
+					uint8_t((s.r * s.a + d.r * (255 - s.a) + 127) / 255),
+					uint8_t((s.g * s.a + d.g * (255 - s.a) + 127) / 255),
+					uint8_t((s.b * s.a + d.b * (255 - s.a) + 127) / 255));
+			}
+		}
+
+		if (!pRecorder) pRecorder = std::make_unique<olc::FrameRecorder>();
+		return pRecorder->Start(sFile, format, w, h, nFrameRate, &backdrop);
+	}
+
+	void PixelGameEngine::StopRecording()
+	{ if (pRecorder) pRecorder->Stop(); }
+
+	bool PixelGameEngine::IsRecording() const
+	{ return pRecorder && pRecorder->IsRecording(); }
+
+	olc::FrameRecorder::Stats PixelGameEngine::GetRecordingStats() const
+	{ return pRecorder ? pRecorder->GetStats() : olc::FrameRecorder::Stats(); }
+
 	bool PixelGameEngine::IsFocused()
 	{ return bHasInputFocus; }
 
@@ -1457,221 +3505,204 @@ namespace olc
 
 
 
-	bool PixelGameEngine::Draw(const olc::vi2d& pos, Pixel p)
-	{ return Draw(pos.x, pos.y, p); }
-
-	// This is it, the critical function that plots a pixel
-	bool PixelGameEngine::Draw(int32_t x, int32_t y, Pixel p)
-	{
-		if (!pDrawTarget) return false;
-
-		if (nPixelMode == Pixel::NORMAL)
-		{
-			return pDrawTarget->SetPixel(x, y, p);
-		}
-
-		if (nPixelMode == Pixel::MASK)
-		{
-			if(p.a == 255)
-				return pDrawTarget->SetPixel(x, y, p);
-		}
-
-		if (nPixelMode == Pixel::ALPHA)
-		{
-			Pixel d = pDrawTarget->GetPixel(x, y);
-			float a = (float)(p.a / 255.0f) * fBlendFactor;
-			float c = 1.0f - a;
-			float r = a * (float)p.r + c * (float)d.r;
-			float g = a * (float)p.g + c * (float)d.g;
-			float b = a * (float)p.b + c * (float)d.b;
-			return pDrawTarget->SetPixel(x, y, Pixel((uint8_t)r, (uint8_t)g, (uint8_t)b/*, (uint8_t)(p.a * fBlendFactor)*/));
-		}
-
-		if (nPixelMode == Pixel::CUSTOM)
-		{
-			return pDrawTarget->SetPixel(x, y, funcPixelMode(x, y, p, pDrawTarget->GetPixel(x, y)));
-		}
-
-		return false;
-	}
-
-	void PixelGameEngine::SetSubPixelOffset(float ox, float oy)
+	RasterTarget PixelGameEngine::olc_Target()
 	{
-		//vSubPixelOffset.x = ox * vPixel.x;
-		//vSubPixelOffset.y = oy * vPixel.y;
+		// Direct rasterization has to land on top of anything queued
+		if (!vecTileCommands.empty()) FlushRasterizer();
+		RasterTarget t;
+		t.spr = pDrawTarget;
+		t.x2 = pDrawTarget ? pDrawTarget->width : 0;
+		t.y2 = pDrawTarget ? pDrawTarget->height : 0;
+		t.nScale = nTargetScale;
+		return t;
 	}
 
-	void PixelGameEngine::DrawLine(const olc::vi2d& pos1, const olc::vi2d& pos2, Pixel p, uint32_t pattern)
-	{ DrawLine(pos1.x, pos1.y, pos2.x, pos2.y, p, pattern);	}
-
-	void PixelGameEngine::DrawLine(int32_t x1, int32_t y1, int32_t x2, int32_t y2, Pixel p, uint32_t pattern)
+	void PixelGameEngine::olc_MarkDirty(int32_t x, int32_t y, int32_t w, int32_t h)
 	{
-		int x, y, dx, dy, dx1, dy1, px, py, xe, ye, i;
-		dx = x2 - x1; dy = y2 - y1;
-
-		auto rol = [&](void){ pattern = (pattern << 1) | (pattern >> 31); return pattern & 1; };
-
-		// straight lines idea by gurkanctn
-		if (dx == 0) // Line is vertical
-		{
-			if (y2 < y1) std::swap(y1, y2);
-			for (y = y1; y <= y2; y++) if (rol()) Draw(x1, y, p);
-			return;
-		}
-
-		if (dy == 0) // Line is horizontal
-		{
-			if (x2 < x1) std::swap(x1, x2);
-			for (x = x1; x <= x2; x++) if (rol()) Draw(x, y1, p);
-			return;
-		}
-
-		// Line is Funk-aye
-		dx1 = abs(dx); dy1 = abs(dy);
-		px = 2 * dy1 - dx1;	py = 2 * dx1 - dy1;
-		if (dy1 <= dx1)
+		if (w <= 0 || h <= 0) return;
+		if (nTargetScale > 1)
 		{
-			if (dx >= 0)
-			{ x = x1; y = y1; xe = x2; }
-			else
-			{ x = x2; y = y2; xe = x1; }
-
-			if (rol()) Draw(x, y, p);
-
-			for (i = 0; x<xe; i++)
-			{
-				x = x + 1;
-				if (px<0)
-					px = px + 2 * dy1;
-				else
-				{
-					if ((dx<0 && dy<0) || (dx>0 && dy>0)) y = y + 1; else y = y - 1;
-					px = px + 2 * (dy1 - dx1);
-				}
-				if (rol()) Draw(x, y, p);
-			}
+			RasterTarget t = { nullptr, 0, 0, 0, 0, nTargetScale };
+			int32_t x2 = t.Cell(x + w - 1) + 1, y2 = t.Cell(y + h - 1) + 1;
+			x = t.Cell(x); y = t.Cell(y);
+			w = x2 - x; h = y2 - y;
 		}
-		else
-		{
-			if (dy >= 0)
-			{ x = x1; y = y1; ye = y2; }
-			else
-			{ x = x2; y = y2; ye = y1; }
+		pDrawTarget->MarkDirty(x, y, w, h);
+	}
 
-			if (rol()) Draw(x, y, p);
+	bool PixelGameEngine::Draw(const olc::vi2d& pos, Pixel p)
+	{ return Draw(pos.x, pos.y, p); }
 
-			for (i = 0; y<ye; i++)
-			{
-				y = y + 1;
-				if (py <= 0)
-					py = py + 2 * dx1;
-				else
-				{
-					if ((dx<0 && dy<0) || (dx>0 && dy>0)) x = x + 1; else x = x - 1;
-					py = py + 2 * (dx1 - dy1);
-				}
-				if (rol()) Draw(x, y, p);
-			}
-		}
+	// This is it, the critical function that plots a pixel. Everything else
+	// resolves the pixel mode once and rasterizes through the templated path
+	bool PixelGameEngine::Draw(int32_t x, int32_t y, Pixel p)
+	{
+		bool bDrawn = false;
+		olc_WithPixelOp([&](const auto& op) { bDrawn = Draw(x, y, p, op); });
+		return bDrawn;
 	}
 
+	void PixelGameEngine::SetSubPixelOffset(float ox, float oy)
+	{
+		//vSubPixelOffset.x = ox * vPixel.x;
+		//vSubPixelOffset.y = oy * vPixel.y;
+	}
+
+	void PixelGameEngine::DrawLine(const olc::vi2d& pos1, const olc::vi2d& pos2, Pixel p, uint32_t pattern)
+	{ DrawLine(pos1.x, pos1.y, pos2.x, pos2.y, p, pattern);	}
+
+	void PixelGameEngine::DrawLine(int32_t x1, int32_t y1, int32_t x2, int32_t y2, Pixel p, uint32_t pattern)
+	{ olc_WithPixelOp([&](const auto& op) { DrawLine(x1, y1, x2, y2, p, pattern, op); }); }
+
 	void PixelGameEngine::DrawCircle(const olc::vi2d& pos, int32_t radius, Pixel p, uint8_t mask)
 	{ DrawCircle(pos.x, pos.y, radius, p, mask);}
 
 	void PixelGameEngine::DrawCircle(int32_t x, int32_t y, int32_t radius, Pixel p, uint8_t mask)
-	{ // Thanks to IanM-Matrix1 #PR121
-		if (radius < 0 || x < -radius || y < -radius || x - GetDrawTargetWidth() > radius || y - GetDrawTargetHeight() > radius)
-			return;
+	{ olc_WithPixelOp([&](const auto& op) { DrawCircle(x, y, radius, p, mask, op); }); }
 
-		if (radius > 0)
-		{
-			int x0 = 0;
-			int y0 = radius;
-			int d = 3 - 2 * radius;
+	void PixelGameEngine::FillCircle(const olc::vi2d& pos, int32_t radius, Pixel p)
+	{ FillCircle(pos.x, pos.y, radius, p); }
 
-			while (y0 >= x0) // only formulate 1/8 of circle
-			{
-				// Draw even octants
-				if (mask & 0x01) Draw(x + x0, y - y0, p);// Q6 - upper right right
-				if (mask & 0x04) Draw(x + y0, y + x0, p);// Q4 - lower lower right
-				if (mask & 0x10) Draw(x - x0, y + y0, p);// Q2 - lower left left
-				if (mask & 0x40) Draw(x - y0, y - x0, p);// Q0 - upper upper left
-				if (x0 != 0 && x0 != y0)
-				{
-					if (mask & 0x02) Draw(x + y0, y - x0, p);// Q7 - upper upper right
-					if (mask & 0x08) Draw(x + x0, y + y0, p);// Q5 - lower right right
-					if (mask & 0x20) Draw(x - y0, y + x0, p);// Q3 - lower lower left
-					if (mask & 0x80) Draw(x - x0, y - y0, p);// Q1 - upper left left
-				}
+	void PixelGameEngine::FillCircle(int32_t x, int32_t y, int32_t radius, Pixel p)
+	{ olc_WithPixelOp([&](const auto& op) { FillCircle(x, y, radius, p, op); }); }
 
-				if (d < 0)
-					d += 4 * x0++ + 6;
-				else
-					d += 4 * (x0++ - y0--) + 10;
-			}
-		}
-		else
-			Draw(x, y, p);
+	void PixelGameEngine::DrawRect(const olc::vi2d& pos, const olc::vi2d& size, Pixel p)
+	{ DrawRect(pos.x, pos.y, size.x, size.y, p); }
+
+	void PixelGameEngine::DrawRect(int32_t x, int32_t y, int32_t w, int32_t h, Pixel p)
+	{ olc_WithPixelOp([&](const auto& op) { DrawRect(x, y, w, h, p, op); }); }
+
+	void PixelGameEngine::SetRasterThreads(uint32_t nThreads, int32_t nTileSize)
+	{
+		FlushRasterizer();
+		if (nThreads == 0) nThreads = std::max(1u, std::thread::hardware_concurrency());
+		this->nTileSize = std::max(nTileSize, 8);
+		pTileTarget = nullptr;
+		if (nThreads == 1) { pRasterPool.reset(); return; }
+		if (!pRasterPool) pRasterPool = std::make_unique<olc::WorkerPool>();
+		pRasterPool->Start(nThreads);
 	}
 
-	void PixelGameEngine::FillCircle(const olc::vi2d& pos, int32_t radius, Pixel p)
-	{ FillCircle(pos.x, pos.y, radius, p); }
+	uint32_t PixelGameEngine::GetRasterThreads() const
+	{ return pRasterPool ? pRasterPool->GetThreadCount() : 1; }
 
-	void PixelGameEngine::FillCircle(int32_t x, int32_t y, int32_t radius, Pixel p)
-	{ // Thanks to IanM-Matrix1 #PR121
-		if (radius < 0 || x < -radius || y < -radius || x - GetDrawTargetWidth() > radius || y - GetDrawTargetHeight() > radius)
-			return;
+	bool PixelGameEngine::olc_Tiling() const
+	{ return pRasterPool && pDrawTarget; }
 
-		if (radius > 0)
+	void PixelGameEngine::olc_BinCommand(const TileCommand& cmd)
+	{
+		if (cmd.w <= 0 || cmd.h <= 0) return;
+		// Bins and dirty regions are in pixels of the target
+		RasterTarget t = { nullptr, 0, 0, 0, 0, nTargetScale };
+		int32_t x1 = std::max(t.Cell(cmd.x), 0), x2 = std::min(t.Cell(cmd.x + cmd.w - 1) + 1, pDrawTarget->width);
+		int32_t y1 = std::max(t.Cell(cmd.y), 0), y2 = std::min(t.Cell(cmd.y + cmd.h - 1) + 1, pDrawTarget->height);
+		if (x1 >= x2 || y1 >= y2) return;
+
+		if (pTileTarget != pDrawTarget || nTileScale != nTargetScale)
 		{
-			int x0 = 0;
-			int y0 = radius;
-			int d = 3 - 2 * radius;
+			FlushRasterizer();
+			pTileTarget = pDrawTarget;
+			nTileScale = nTargetScale;
+			vTileCount = { (pTileTarget->width + nTileSize - 1) / nTileSize, (pTileTarget->height + nTileSize - 1) / nTileSize };
+			vecTileBins.resize(size_t(vTileCount.x) * size_t(vTileCount.y));
+		}
 
-			auto drawline = [&](int sx, int ex, int y)
-			{
-				for (int x = sx; x <= ex; x++)
-					Draw(x, y, p);
-			};
+		uint32_t nCommand = uint32_t(vecTileCommands.size());
+		vecTileCommands.push_back(cmd);
+		for (int32_t ty = y1 / nTileSize; ty <= (y2 - 1) / nTileSize; ty++)
+			for (int32_t tx = x1 / nTileSize; tx <= (x2 - 1) / nTileSize; tx++)
+				vecTileBins[ty * vTileCount.x + tx].push_back(nCommand);
 
-			while (y0 >= x0)
-			{
-				drawline(x - y0, x + y0, y - x0);
-				if (x0 > 0)	drawline(x - y0, x + y0, y + x0);
+		pDrawTarget->MarkDirty(x1, y1, x2 - x1, y2 - y1);
+	}
 
-				if (d < 0)
-					d += 4 * x0++ + 6;
-				else
-				{
-					if (x0 != y0)
-					{
-						drawline(x - x0, x + x0, y - y0);    
-						drawline(x - x0, x + x0, y + y0);    
-					}
-					d += 4 * (x0++ - y0--) + 10;
-				}
+	void PixelGameEngine::olc_RasterCommand(const RasterTarget& t, const TileCommand& cmd)
+	{
+		auto raster = [&](const auto& op)
+		{
+			switch (cmd.nType)
+			{
+			case TileCommand::Type::RECT:
+				olc_RasterRect(t, cmd.x, cmd.y, cmd.x + cmd.w, cmd.y + cmd.h, cmd.col, op);
+				break;
+			case TileCommand::Type::STRING:
+				olc_RasterString(t, cmd.x, cmd.y, vecTileText[cmd.nText], cmd.col, cmd.scale, op);
+				break;
+			case TileCommand::Type::SPRITE:
+				olc_RasterSprite(t, cmd.x, cmd.y, cmd.sprite, cmd.ox, cmd.oy, cmd.w / int32_t(cmd.scale), cmd.h / int32_t(cmd.scale), cmd.scale, cmd.flip, op);
+				break;
 			}
+		};
+
+		switch (cmd.nMode)
+		{
+		case Pixel::NORMAL: raster(PixelOpNormal()); break;
+		case Pixel::MASK:   raster(PixelOpMask()); break;
+		case Pixel::ALPHA:  raster(PixelOpAlpha{ cmd.nBlend }); break;
+		case Pixel::CUSTOM: break;
 		}
-		else
-			Draw(x, y, p);
 	}
 
-	void PixelGameEngine::DrawRect(const olc::vi2d& pos, const olc::vi2d& size, Pixel p)
-	{ DrawRect(pos.x, pos.y, size.x, size.y, p); }
-
-	void PixelGameEngine::DrawRect(int32_t x, int32_t y, int32_t w, int32_t h, Pixel p)
+	void PixelGameEngine::FlushRasterizer()
 	{
-		DrawLine(x, y, x+w, y, p);
-		DrawLine(x+w, y, x+w, y+h, p);
-		DrawLine(x+w, y+h, x, y+h, p);
-		DrawLine(x, y+h, x, y, p);
+		if (vecTileCommands.empty()) return;
+
+		OLC_PROFILE_ZONE("FlushRasterizer");
+		pRasterPool->ParallelFor(uint32_t(vecTileBins.size()), [&](uint32_t i)
+		{
+			if (vecTileBins[i].empty()) return;
+			OLC_PROFILE_ZONE("RasterTile");
+			RasterTarget t;
+			t.spr = pTileTarget;
+			t.nScale = nTileScale;
+			t.x1 = int32_t(i % uint32_t(vTileCount.x)) * nTileSize;
+			t.y1 = int32_t(i / uint32_t(vTileCount.x)) * nTileSize;
+			t.x2 = std::min(t.x1 + nTileSize, pTileTarget->width);
+			t.y2 = std::min(t.y1 + nTileSize, pTileTarget->height);
+			for (uint32_t c : vecTileBins[i])
+				olc_RasterCommand(t, vecTileCommands[c]);
+			vecTileBins[i].clear();
+		});
+
+		vecTileCommands.clear();
+		vecTileText.clear();
 	}
 
+	void PixelGameEngine::SetFrameRate(double fHz, olc::FrameScheduler::Mode mode)
+	{ frameScheduler.SetTargetRate(fHz, mode); }
+
+	olc::FrameScheduler::Stats PixelGameEngine::GetFrameStats() const
+	{ return frameScheduler.GetStats(); }
+
+	void PixelGameEngine::ResetFrameStats()
+	{ frameScheduler.ResetStats(); }
+
 	void PixelGameEngine::Clear(Pixel p)
 	{
-		int pixels = GetDrawTargetWidth() * GetDrawTargetHeight();
-		Pixel* m = GetDrawTarget()->GetData();
-		for (int i = 0; i < pixels; i++) m[i] = p;
+		if (olc_Tiling())
+		{
+			// Everything queued for this target would be overwritten anyway
+			if (pTileTarget == pDrawTarget)
+			{
+				for (auto& bin : vecTileBins) bin.clear();
+				vecTileCommands.clear();
+				vecTileText.clear();
+			}
+			TileCommand cmd;
+			cmd.w = GetDrawTargetWidth(); cmd.h = GetDrawTargetHeight(); cmd.col = p;
+			olc_BinCommand(cmd);
+			return;
+		}
+
+		Sprite* spr = GetDrawTarget();
+		int pixels = spr->width * spr->height;
+		if (spr->IsIndexed())
+		{
+			std::memset(spr->GetIndexData(), spr->PaletteIndex(p), size_t(pixels));
+			return;
+		}
+		Pixel* m = spr->GetData();
+		std::fill(m, m + pixels, p);
 	}
 
 	void PixelGameEngine::ClearBuffer(Pixel p, bool bDepth)
@@ -1684,171 +3715,28 @@ namespace olc
 
 	void PixelGameEngine::FillRect(int32_t x, int32_t y, int32_t w, int32_t h, Pixel p)
 	{
-		int32_t x2 = x + w;
-		int32_t y2 = y + h;
-
-		if (x < 0) x = 0;
-		if (x >= (int32_t)GetDrawTargetWidth()) x = (int32_t)GetDrawTargetWidth();
-		if (y < 0) y = 0;
-		if (y >= (int32_t)GetDrawTargetHeight()) y = (int32_t)GetDrawTargetHeight();
-
-		if (x2 < 0) x2 = 0;
-		if (x2 >= (int32_t)GetDrawTargetWidth()) x2 = (int32_t)GetDrawTargetWidth();
-		if (y2 < 0) y2 = 0;
-		if (y2 >= (int32_t)GetDrawTargetHeight()) y2 = (int32_t)GetDrawTargetHeight();
-
-		for (int i = x; i < x2; i++)
-			for (int j = y; j < y2; j++)
-				Draw(i, j, p);
+		if (olc_Tiling() && nPixelMode != Pixel::CUSTOM)
+		{
+			TileCommand cmd;
+			cmd.nMode = nPixelMode; cmd.nBlend = nBlendFactor;
+			cmd.x = x; cmd.y = y; cmd.w = w; cmd.h = h; cmd.col = p;
+			olc_BinCommand(cmd);
+			return;
+		}
+		olc_WithPixelOp([&](const auto& op) { FillRect(x, y, w, h, p, op); });
 	}
 
 	void PixelGameEngine::DrawTriangle(const olc::vi2d& pos1, const olc::vi2d& pos2, const olc::vi2d& pos3, Pixel p)
 	{ DrawTriangle(pos1.x, pos1.y, pos2.x, pos2.y, pos3.x, pos3.y, p); }
 
 	void PixelGameEngine::DrawTriangle(int32_t x1, int32_t y1, int32_t x2, int32_t y2, int32_t x3, int32_t y3, Pixel p)
-	{
-		DrawLine(x1, y1, x2, y2, p);
-		DrawLine(x2, y2, x3, y3, p);
-		DrawLine(x3, y3, x1, y1, p);
-	}
+	{ olc_WithPixelOp([&](const auto& op) { DrawTriangle(x1, y1, x2, y2, x3, y3, p, op); }); }
 
 	void PixelGameEngine::FillTriangle(const olc::vi2d& pos1, const olc::vi2d& pos2, const olc::vi2d& pos3, Pixel p)
-	{ FillTriangle(pos1.x, pos1.y, pos2.x, pos2.y, pos3.x, pos3.y, p); }
-
-	// https://www.avrfreaks.net/sites/default/files/triangles.c
-	void PixelGameEngine::FillTriangle(int32_t x1, int32_t y1, int32_t x2, int32_t y2, int32_t x3, int32_t y3, Pixel p)
-	{
-		auto drawline = [&](int sx, int ex, int ny) { for (int i = sx; i <= ex; i++) Draw(i, ny, p); };
-
-		int t1x, t2x, y, minx, maxx, t1xp, t2xp;
-		bool changed1 = false;
-		bool changed2 = false;
-		int signx1, signx2, dx1, dy1, dx2, dy2;
-		int e1, e2;
-		// Sort vertices
-		if (y1>y2) {std::swap(y1, y2); std::swap(x1, x2); }
-		if (y1>y3) {std::swap(y1, y3); std::swap(x1, x3); }
-		if (y2>y3) {std::swap(y2, y3); std::swap(x2, x3); }
-
-		t1x = t2x = x1; y = y1;   // Starting points
-		dx1 = (int)(x2 - x1);
-		if (dx1<0) { dx1 = -dx1; signx1 = -1; }	else signx1 = 1;
-		dy1 = (int)(y2 - y1);
-
-		dx2 = (int)(x3 - x1);
-		if (dx2<0) { dx2 = -dx2; signx2 = -1; } else signx2 = 1;
-		dy2 = (int)(y3 - y1);
-
-		if (dy1 > dx1) { std::swap(dx1, dy1); changed1 = true; }
-		if (dy2 > dx2) { std::swap(dy2, dx2); changed2 = true; }
-
-		e2 = (int)(dx2 >> 1);
-		// Flat top, just process the second half
-		if (y1 == y2) goto next;
-		e1 = (int)(dx1 >> 1);
-
-		for (int i = 0; i < dx1;) {
-			t1xp = 0; t2xp = 0;
-			if (t1x<t2x) { minx = t1x; maxx = t2x; }
-			else { minx = t2x; maxx = t1x; }
-			// process first line until y value is about to change
-			while (i<dx1) {
-				i++;
-				e1 += dy1;
-				while (e1 >= dx1) {
-					e1 -= dx1;
-					if (changed1) t1xp = signx1;//t1x += signx1;
-					else          goto next1;
-				}
-				if (changed1) break;
-				else t1x += signx1;
-			}
-			// Move line
-		next1:
-			// process second line until y value is about to change
-			while (1) {
-				e2 += dy2;
-				while (e2 >= dx2) {
-					e2 -= dx2;
-					if (changed2) t2xp = signx2;//t2x += signx2;
-					else          goto next2;
-				}
-				if (changed2)     break;
-				else              t2x += signx2;
-			}
-		next2:
-			if (minx>t1x) minx = t1x;
-			if (minx>t2x) minx = t2x;
-			if (maxx<t1x) maxx = t1x;
-			if (maxx<t2x) maxx = t2x;
-			drawline(minx, maxx, y);    // Draw line from min to max points found on the y
-										// Now increase y
-			if (!changed1) t1x += signx1;
-			t1x += t1xp;
-			if (!changed2) t2x += signx2;
-			t2x += t2xp;
-			y += 1;
-			if (y == y2) break;
-
-		}
-	next:
-		// Second half
-		dx1 = (int)(x3 - x2); if (dx1<0) { dx1 = -dx1; signx1 = -1; }
-		else signx1 = 1;
-		dy1 = (int)(y3 - y2);
-		t1x = x2;
-
-		if (dy1 > dx1) {   // swap values
-			std::swap(dy1, dx1);
-			changed1 = true;
-		}
-		else changed1 = false;
-
-		e1 = (int)(dx1 >> 1);
-
-		for (int i = 0; i <= dx1; i++) {
-			t1xp = 0; t2xp = 0;
-			if (t1x<t2x) { minx = t1x; maxx = t2x; }
-			else { minx = t2x; maxx = t1x; }
-			// process first line until y value is about to change
-			while (i<dx1) {
-				e1 += dy1;
-				while (e1 >= dx1) {
-					e1 -= dx1;
-					if (changed1) { t1xp = signx1; break; }//t1x += signx1;
-					else          goto next3;
-				}
-				if (changed1) break;
-				else   	   	  t1x += signx1;
-				if (i<dx1) i++;
-			}
-		next3:
-			// process second line until y value is about to change
-			while (t2x != x3) {
-				e2 += dy2;
-				while (e2 >= dx2) {
-					e2 -= dx2;
-					if (changed2) t2xp = signx2;
-					else          goto next4;
-				}
-				if (changed2)     break;
-				else              t2x += signx2;
-			}
-		next4:
-
-			if (minx>t1x) minx = t1x;
-			if (minx>t2x) minx = t2x;
-			if (maxx<t1x) maxx = t1x;
-			if (maxx<t2x) maxx = t2x;
-			drawline(minx, maxx, y);
-			if (!changed1) t1x += signx1;
-			t1x += t1xp;
-			if (!changed2) t2x += signx2;
-			t2x += t2xp;
-			y += 1;
-			if (y>y3) return;
-		}
-	}
+	{ FillTriangle(pos1.x, pos1.y, pos2.x, pos2.y, pos3.x, pos3.y, p); }
+
+	void PixelGameEngine::FillTriangle(int32_t x1, int32_t y1, int32_t x2, int32_t y2, int32_t x3, int32_t y3, Pixel p)
+	{ olc_WithPixelOp([&](const auto& op) { FillTriangle(x1, y1, x2, y2, x3, y3, p, op); }); }
 
 	void PixelGameEngine::DrawSprite(const olc::vi2d& pos, Sprite *sprite, uint32_t scale, uint8_t flip)
 	{ DrawSprite(pos.x, pos.y, sprite, scale, flip); }
@@ -1858,33 +3746,7 @@ namespace olc
 		if (sprite == nullptr)
 			return;
 
-		int32_t fxs = 0, fxm = 1, fx = 0;
-		int32_t fys = 0, fym = 1, fy = 0;
-		if (flip & olc::Sprite::Flip::HORIZ) { fxs = sprite->width - 1; fxm = -1; }
-		if (flip & olc::Sprite::Flip::VERT) { fys = sprite->height - 1; fym = -1; }
-
-		if (scale > 1)
-		{
-			fx = fxs;
-			for (int32_t i = 0; i < sprite->width; i++, fx += fxm)
-			{
-				fy = fys;
-				for (int32_t j = 0; j < sprite->height; j++, fy += fym)
-					for (uint32_t is = 0; is < scale; is++)
-						for (uint32_t js = 0; js < scale; js++)
-							Draw(x + (i*scale) + is, y + (j*scale) + js, sprite->GetPixel(fx, fy));
-			}
-		}
-		else
-		{
-			fx = fxs;
-			for (int32_t i = 0; i < sprite->width; i++, fx += fxm)
-			{
-				fy = fys;
-				for (int32_t j = 0; j < sprite->height; j++, fy += fym)
-					Draw(x + i, y + j, sprite->GetPixel(fx, fy));
-			}
-		}
+		DrawPartialSprite(x, y, sprite, 0, 0, sprite->width, sprite->height, scale, flip);
 	}
 
 	void PixelGameEngine::DrawPartialSprite(const olc::vi2d& pos, Sprite *sprite, const olc::vi2d& sourcepos, const olc::vi2d& size, uint32_t scale, uint8_t flip)
@@ -1892,36 +3754,18 @@ namespace olc
 
 	void PixelGameEngine::DrawPartialSprite(int32_t x, int32_t y, Sprite *sprite, int32_t ox, int32_t oy, int32_t w, int32_t h, uint32_t scale, uint8_t flip)
 	{
-		if (sprite == nullptr)
-			return;
-
-		int32_t fxs = 0, fxm = 1, fx = 0;
-		int32_t fys = 0, fym = 1, fy = 0;
-		if (flip & olc::Sprite::Flip::HORIZ) { fxs = w - 1; fxm = -1; }
-		if (flip & olc::Sprite::Flip::VERT) { fys = h - 1; fym = -1; }
-
-		if (scale > 1)
-		{
-			fx = fxs;
-			for (int32_t i = 0; i < w; i++, fx += fxm)
-			{
-				fy = fys;
-				for (int32_t j = 0; j < h; j++, fy += fym)
-					for (uint32_t is = 0; is < scale; is++)
-						for (uint32_t js = 0; js < scale; js++)
-							Draw(x + (i*scale) + is, y + (j*scale) + js, sprite->GetPixel(fx + ox, fy + oy));
-			}
-		}
-		else
+		if (olc_Tiling() && nPixelMode != Pixel::CUSTOM)
 		{
-			fx = fxs;
-			for (int32_t i = 0; i < w; i++, fx += fxm)
-			{
-				fy = fys;
-				for (int32_t j = 0; j < h; j++, fy += fym)
-					Draw(x + i, y + j, sprite->GetPixel(fx + ox, fy + oy));
-			}
+			if (sprite == nullptr || w <= 0 || h <= 0 || scale == 0) return;
+			TileCommand cmd;
+			cmd.nType = TileCommand::Type::SPRITE;
+			cmd.nMode = nPixelMode; cmd.nBlend = nBlendFactor;
+			cmd.x = x; cmd.y = y; cmd.w = w * int32_t(scale); cmd.h = h * int32_t(scale);
+			cmd.sprite = sprite; cmd.ox = ox; cmd.oy = oy; cmd.scale = scale; cmd.flip = flip;
+			olc_BinCommand(cmd);
+			return;
 		}
+		olc_WithPixelOp([&](const auto& op) { DrawPartialSprite(x, y, sprite, ox, oy, w, h, scale, flip, op); });
 	}
 
 	void PixelGameEngine::DrawPartialDecal(const olc::vf2d& pos, olc::Decal* decal, const olc::vf2d& source_pos, const olc::vf2d& source_size, const olc::vf2d& scale, const olc::Pixel& tint)
@@ -2183,43 +4027,21 @@ namespace olc
 
 	void PixelGameEngine::DrawString(int32_t x, int32_t y, const std::string& sText, Pixel col, uint32_t scale)
 	{
-		int32_t sx = 0;
-		int32_t sy = 0;
-		Pixel::Mode m = nPixelMode;
 		// Thanks @tucna, spotted bug with col.ALPHA :P
-		if(col.a != 255)		SetPixelMode(Pixel::ALPHA);
-		else					SetPixelMode(Pixel::MASK);
-		for (auto c : sText)
+		if (olc_Tiling())
 		{
-			if (c == '\n')
-			{
-				sx = 0; sy += 8 * scale;
-			}
-			else
-			{
-				int32_t ox = (c - 32) % 16;
-				int32_t oy = (c - 32) / 16;
-
-				if (scale > 1)
-				{
-					for (uint32_t i = 0; i < 8; i++)
-						for (uint32_t j = 0; j < 8; j++)
-							if (fontSprite->GetPixel(i + ox * 8, j + oy * 8).r > 0)
-								for (uint32_t is = 0; is < scale; is++)
-									for (uint32_t js = 0; js < scale; js++)
-										Draw(x + sx + (i*scale) + is, y + sy + (j*scale) + js, col);
-				}
-				else
-				{
-					for (uint32_t i = 0; i < 8; i++)
-						for (uint32_t j = 0; j < 8; j++)
-							if (fontSprite->GetPixel(i + ox * 8, j + oy * 8).r > 0)
-								Draw(x + sx + i, y + sy + j, col);
-				}
-				sx += 8 * scale;
-			}
+			olc::vi2d size = GetTextSize(sText) * int32_t(scale);
+			TileCommand cmd;
+			cmd.nType = TileCommand::Type::STRING;
+			cmd.nMode = col.a != 255 ? Pixel::ALPHA : Pixel::MASK; cmd.nBlend = nBlendFactor;
+			cmd.x = x; cmd.y = y; cmd.w = size.x; cmd.h = size.y; cmd.col = col; cmd.scale = scale;
+			cmd.nText = uint32_t(vecTileText.size());
+			vecTileText.push_back(sText);
+			olc_BinCommand(cmd);
+			return;
 		}
-		SetPixelMode(m);
+		if (col.a != 255)	DrawString(x, y, sText, col, scale, PixelOpAlpha{ nBlendFactor });
+		else				DrawString(x, y, sText, col, scale, PixelOpMask());
 	}
 
 	void PixelGameEngine::SetPixelMode(Pixel::Mode m)
@@ -2239,6 +4061,7 @@ namespace olc
 		fBlendFactor = fBlend;
 		if (fBlendFactor < 0.0f) fBlendFactor = 0.0f;
 		if (fBlendFactor > 1.0f) fBlendFactor = 1.0f;
+		nBlendFactor = uint32_t(fBlendFactor * 256.0f + 0.5f);
 	}
 
 	// User must override these functions as required. I have not made
@@ -2316,6 +4139,8 @@ namespace olc
 
 	void PixelGameEngine::EngineThread()
 	{
+		OLC_PROFILE_THREAD("Engine");
+
 		// Allow platform to do stuff here if needed, since its now in the
 		// context of this thread
 		if (platform->ThreadStartUp() == olc::FAIL)	return;
@@ -2339,6 +4164,9 @@ namespace olc
 			}
 		}
 
+		// Flush any recording before the engine goes away
+		StopRecording();
+
 		platform->ThreadCleanUp();
 	}
 
@@ -2356,24 +4184,33 @@ namespace olc
 		vLayers[0].bShow = true;
 		SetDrawTarget(nullptr);
 
-		m_tp1 = std::chrono::system_clock::now();
-		m_tp2 = std::chrono::system_clock::now();
+		frameScheduler.SetPresentSync(bEnableVSYNC);
+		m_tp1 = olc::FrameScheduler::Clock::now();
+		m_tp2 = m_tp1;
 	}
 
 
 	void PixelGameEngine::olc_CoreUpdate()
 	{
-		// Handle Timing
-		m_tp2 = std::chrono::system_clock::now();
+		// Handle Timing, holding the frame back if a rate cap is set
+		{
+			OLC_PROFILE_ZONE("WaitForFrame");
+			m_tp2 = frameScheduler.Wait();
+		}
 		std::chrono::duration<float> elapsedTime = m_tp2 - m_tp1;
 		m_tp1 = m_tp2;
 
+		OLC_PROFILE_ZONE("Frame");
+
 		// Our time per frame coefficient
 		float fElapsedTime = elapsedTime.count();
 		fLastElapsed = fElapsedTime;		
 
 		// Some platforms will need to check for events
-		platform->HandleSystemEvent();
+		{
+			OLC_PROFILE_ZONE("HandleSystemEvent");
+			platform->HandleSystemEvent();
+		}
 
 		// Compare hardware input states from previous frame
 		auto ScanHardware = [&](HWButton* pKeys, bool* pStateOld, bool* pStateNew, uint32_t nKeyCount)
@@ -2399,8 +4236,11 @@ namespace olc
 			}
 		};
 
-		ScanHardware(pKeyboardState, pKeyOldState, pKeyNewState, 256);
-		ScanHardware(pMouseState, pMouseOldState, pMouseNewState, nMouseButtons);
+		{
+			OLC_PROFILE_ZONE("ScanHardware");
+			ScanHardware(pKeyboardState, pKeyOldState, pKeyNewState, 256);
+			ScanHardware(pMouseState, pMouseOldState, pMouseNewState, nMouseButtons);
+		}
 
 		// Cache mouse coordinates so they remain consistent during frame
 		vMousePos = vMousePosCache;
@@ -2410,8 +4250,14 @@ namespace olc
 		renderer->ClearBuffer(olc::BLACK, true);
 
 		// Handle Frame Update
-		if (!OnUserUpdate(fElapsedTime))
-			bAtomActive = false;
+		{
+			OLC_PROFILE_ZONE("OnUserUpdate");
+			if (!OnUserUpdate(fElapsedTime))
+				bAtomActive = false;
+		}
+
+		// Finish any drawing still queued for the tiles before uploading
+		FlushRasterizer();
 
 		// Display Frame
 		renderer->UpdateViewport(vViewPos, vViewSize);
@@ -2424,6 +4270,7 @@ namespace olc
 
 		for (auto layer = vLayers.rbegin(); layer != vLayers.rend(); ++layer)
 		{
+			OLC_PROFILE_ZONE("Layer");
 			if (layer->bShow)
 			{
 				if (layer->funcHook == nullptr)
@@ -2431,11 +4278,16 @@ namespace olc
 					renderer->ApplyTexture(layer->nResID);
 					if (layer->bUpdate)
 					{
+						OLC_PROFILE_ZONE("UpdateTexture");
 						renderer->UpdateTexture(layer->nResID, layer->pDrawTarget);
 						layer->bUpdate = false;
 					}
 
-					renderer->DrawLayerQuad(layer->vOffset, layer->vScale, layer->tint);
+					// A reduced-scale layer rounds up, so only part of it is on screen
+					olc::vf2d vCrop = {
+						float(vScreenSize.x) / float(layer->pDrawTarget->width * nRenderScale),
+						float(vScreenSize.y) / float(layer->pDrawTarget->height * nRenderScale) };
+					renderer->DrawLayerQuad(layer->vOffset, layer->vScale * vCrop, layer->tint);
 
 					// Display Decals in order for this layer
 					for (auto& decal : layer->vecDecalInstance)
@@ -2450,8 +4302,25 @@ namespace olc
 			}
 		}
 
+		// Capture the frame once it has been uploaded, handing layer 0's
+		// buffer to the encoder
+		if (pRecorder)
+		{
+			OLC_PROFILE_ZONE("Capture");
+			pRecorder->Capture(vLayers[0].pDrawTarget, uint32_t(nRenderScale));
+		}
+
 		// Present Graphics to screen
-		renderer->DisplayFrame();
+		frameScheduler.FrameReady();
+		{
+			OLC_PROFILE_ZONE("DisplayFrame");
+			renderer->DisplayFrame();
+		}
+		frameScheduler.FramePresented();
+
+		// Texture traffic for this frame, including any decals updated by the user
+		nLastUploadBytes = renderer->nUploadBytes;
+		renderer->nUploadBytes = 0;
 
 		// Update Title Bar
 		fFrameTimer += fElapsedTime;
@@ -2549,6 +4418,34 @@ namespace olc
 	typedef X11::GLXContext glRenderContext_t;
 #endif
 
+// Pixel buffer objects are not part of OpenGL 1.0, so they are fetched at
+// runtime and only used when the driver advertises them
+#if !defined(GL_PIXEL_UNPACK_BUFFER)
+	#define GL_PIXEL_UNPACK_BUFFER 0x88EC
+#endif
+#if !defined(GL_STREAM_DRAW)
+	#define GL_STREAM_DRAW 0x88E0
+#endif
+#if !defined(GL_WRITE_ONLY)
+	#define GL_WRITE_ONLY 0x88B9
+#endif
+#if !defined(GL_UNPACK_ROW_LENGTH)
+	#define GL_UNPACK_ROW_LENGTH 0x0CF2
+	#define GL_UNPACK_SKIP_ROWS 0x0CF3
+	#define GL_UNPACK_SKIP_PIXELS 0x0CF4
+#endif
+#if defined(_WIN32)
+	#define OLC_GL_APIENTRY __stdcall
+#else
+	#define OLC_GL_APIENTRY
+#endif
+	typedef void      (OLC_GL_APIENTRY glGenBuffers_t)(GLsizei n, GLuint* buffers);
+	typedef void      (OLC_GL_APIENTRY glDeleteBuffers_t)(GLsizei n, const GLuint* buffers);
+	typedef void      (OLC_GL_APIENTRY glBindBuffer_t)(GLenum target, GLuint buffer);
+	typedef void      (OLC_GL_APIENTRY glBufferData_t)(GLenum target, std::ptrdiff_t size, const void* data, GLenum usage);
+	typedef void*     (OLC_GL_APIENTRY glMapBuffer_t)(GLenum target, GLenum access);
+	typedef GLboolean (OLC_GL_APIENTRY glUnmapBuffer_t)(GLenum target);
+
 namespace olc
 {
 	class Renderer_OGL10 : public olc::Renderer
@@ -2557,6 +4454,28 @@ namespace olc
 		glDeviceContext_t glDeviceContext = 0;
 		glRenderContext_t glRenderContext = 0;
 
+		// Storage is allocated once per texture and size, after which only the
+		// dirty region of a sprite is sent. Each texture streams through a pair
+		// of pixel buffers used alternately, so writing this frame's texels
+		// never waits on the driver still reading the previous ones
+		struct TextureStore
+		{
+			olc::vi2d vSize = { 0, 0 };
+			GLuint    nPBO[2] = { 0, 0 };
+			uint32_t  nNextPBO = 0;
+		};
+		std::map<uint32_t, TextureStore> mapTextures;
+		// Expanded texels of indexed sprites when pixel buffers aren't available
+		std::vector<olc::Pixel> vecStaging;
+
+		bool               bUsePBO = false;
+		glGenBuffers_t*    glGenBuffers = nullptr;
+		glDeleteBuffers_t* glDeleteBuffers = nullptr;
+		glBindBuffer_t*    glBindBuffer = nullptr;
+		glBufferData_t*    glBufferData = nullptr;
+		glMapBuffer_t*     glMapBuffer = nullptr;
+		glUnmapBuffer_t*   glUnmapBuffer = nullptr;
+
 	#if defined(__linux__) || defined(__FreeBSD__)
 		X11::Display*				 olc_Display = nullptr;
 		X11::Window*				 olc_Window = nullptr;
@@ -2623,9 +4542,37 @@ namespace olc
 		
 			glEnable(GL_TEXTURE_2D); // Turn on texturing
 			glHint(GL_PERSPECTIVE_CORRECTION_HINT, GL_NICEST);
+
+			LoadBufferFunctions();
 			return olc::rcode::OK;
 		}
 
+		void LoadBufferFunctions()
+		{
+			auto GetProc = [](const char* name) -> void*
+			{
+			#if defined(_WIN32)
+				return (void*)wglGetProcAddress(name);
+			#endif
+			#if defined(__linux__) || defined(__FreeBSD__)
+				return (void*)X11::glXGetProcAddress((const unsigned char*)name);
+			#endif
+			};
+
+			// glXGetProcAddress() happily returns pointers for things the driver
+			// can't do, so the extension string has the final say
+			const char* sExt = (const char*)glGetString(GL_EXTENSIONS);
+			if (sExt == nullptr || std::strstr(sExt, "GL_ARB_pixel_buffer_object") == nullptr) return;
+
+			glGenBuffers    = (glGenBuffers_t*)GetProc("glGenBuffers");
+			glDeleteBuffers = (glDeleteBuffers_t*)GetProc("glDeleteBuffers");
+			glBindBuffer    = (glBindBuffer_t*)GetProc("glBindBuffer");
+			glBufferData    = (glBufferData_t*)GetProc("glBufferData");
+			glMapBuffer     = (glMapBuffer_t*)GetProc("glMapBuffer");
+			glUnmapBuffer   = (glUnmapBuffer_t*)GetProc("glUnmapBuffer");
+			bUsePBO = glGenBuffers && glDeleteBuffers && glBindBuffer && glBufferData && glMapBuffer && glUnmapBuffer;
+		}
+
 		olc::rcode DestroyDevice() override
 		{
 		#if defined(_WIN32)
@@ -2713,13 +4660,77 @@ namespace olc
 
 		uint32_t DeleteTexture(const uint32_t id) override
 		{
+			auto it = mapTextures.find(id);
+			if (it != mapTextures.end())
+			{
+				if (bUsePBO) glDeleteBuffers(2, it->second.nPBO);
+				mapTextures.erase(it);
+			}
 			glDeleteTextures(1, &id);			
 			return id;
 		}
 
 		void UpdateTexture(uint32_t id, olc::Sprite* spr) override
 		{
-			glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, spr->width, spr->height, 0, GL_RGBA, GL_UNSIGNED_BYTE, spr->GetData());
+			TextureStore& tex = mapTextures[id];
+			if (tex.vSize.x != spr->width || tex.vSize.y != spr->height)
+			{
+				// (Re)allocate storage, contents are supplied below
+				glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, spr->width, spr->height, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+				tex.vSize = { spr->width, spr->height };
+				spr->MarkDirty();
+			}
+
+			if (!spr->IsDirty()) return;
+			olc::vi2d pos = spr->vDirtyMin;
+			olc::vi2d size = spr->vDirtyMax - spr->vDirtyMin;
+			size_t nBytes = size_t(size.x) * size_t(size.y) * sizeof(olc::Pixel);
+			spr->ClearDirty();
+
+			void* pMapped = nullptr;
+			if (bUsePBO)
+			{
+				if (tex.nPBO[0] == 0) glGenBuffers(2, tex.nPBO);
+				glBindBuffer(GL_PIXEL_UNPACK_BUFFER, tex.nPBO[tex.nNextPBO]);
+				tex.nNextPBO ^= 1;
+				// Orphan the old store so mapping doesn't sync with a pending transfer
+				glBufferData(GL_PIXEL_UNPACK_BUFFER, std::ptrdiff_t(nBytes), nullptr, GL_STREAM_DRAW);
+				pMapped = glMapBuffer(GL_PIXEL_UNPACK_BUFFER, GL_WRITE_ONLY);
+				if (pMapped == nullptr) glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+			}
+
+			if (pMapped != nullptr)
+			{
+				// Pack the dirty rows tightly into the buffer, the copy to the
+				// texture then happens asynchronously on the driver's side
+				olc::Pixel* dst = (olc::Pixel*)pMapped;
+				for (int32_t y = 0; y < size.y; y++)
+					spr->ExpandRow(pos.x, pos.y + y, size.x, dst + y * size.x);
+				glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+				glTexSubImage2D(GL_TEXTURE_2D, 0, pos.x, pos.y, size.x, size.y, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+				glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+			}
+			else if (spr->IsIndexed())
+			{
+				// Indexed sprites expand through the palette on the way
+				vecStaging.resize(size_t(size.x) * size_t(size.y));
+				for (int32_t y = 0; y < size.y; y++)
+					spr->ExpandRow(pos.x, pos.y + y, size.x, vecStaging.data() + y * size.x);
+				glTexSubImage2D(GL_TEXTURE_2D, 0, pos.x, pos.y, size.x, size.y, GL_RGBA, GL_UNSIGNED_BYTE, vecStaging.data());
+			}
+			else
+			{
+				// Read the dirty window straight out of the sprite
+				glPixelStorei(GL_UNPACK_ROW_LENGTH, spr->width);
+				glPixelStorei(GL_UNPACK_SKIP_PIXELS, pos.x);
+				glPixelStorei(GL_UNPACK_SKIP_ROWS, pos.y);
+				glTexSubImage2D(GL_TEXTURE_2D, 0, pos.x, pos.y, size.x, size.y, GL_RGBA, GL_UNSIGNED_BYTE, spr->pColData);
+				glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+				glPixelStorei(GL_UNPACK_SKIP_PIXELS, 0);
+				glPixelStorei(GL_UNPACK_SKIP_ROWS, 0);
+			}
+
+			nUploadBytes += uint32_t(nBytes);
 		}
 
 		void ApplyTexture(uint32_t id) override
@@ -2746,10 +4757,287 @@ namespace olc
 // O------------------------------------------------------------------------------O
 
 
+// O------------------------------------------------------------------------------O
+// | START RENDERER: Null (headless, everything stays in memory)                  |
+// O------------------------------------------------------------------------------O
+#if defined(OLC_GFX_NULL)
+namespace olc
+{
+	class Renderer_Null : public olc::Renderer
+	{
+	private:
+		// Textures are plain sprites, uploads copy the dirty region just as
+		// a device would so headless frame times stay representative
+		std::map<uint32_t, std::unique_ptr<olc::Sprite>> mapTextures;
+		uint32_t nNextTexture = 1;
+		uint32_t nBoundTexture = 0;
+
+		// Layer quads are only recorded; they are composited on demand
+		struct LayerQuad
+		{
+			uint32_t   id;
+			olc::vf2d  offset;
+			olc::vf2d  scale;
+			olc::Pixel tint;
+		};
+		std::vector<LayerQuad> vecQuads;
+		std::vector<LayerQuad> vecPresented;
+		olc::Pixel             pClear = olc::BLACK;
+		olc::Pixel             pPresentedClear = olc::BLACK;
+		olc::vi2d              vViewSize = { 0, 0 };
+		olc::Sprite            sprFrame;
+		bool                   bFrameValid = false;
+		// With vsync, presents wait for the next refresh of an emulated display
+		bool                   bVSync = false;
+		std::chrono::steady_clock::time_point tpRefresh;
+		static constexpr uint32_t nRefreshRate = 60;
+
+	public:
+		void PrepareDevice() override
+		{ }
+
+		olc::rcode CreateDevice(std::vector<void*> params, bool bFullScreen, bool bVSYNC) override
+		{
+			UNUSED(params); UNUSED(bFullScreen);
+			bVSync = bVSYNC;
+			tpRefresh = std::chrono::steady_clock::now();
+			return olc::rcode::OK;
+		}
+
+		olc::rcode DestroyDevice() override
+		{
+			// The last frame stays readable once the textures are gone
+			if (!bFrameValid) Composite();
+			mapTextures.clear();
+			return olc::rcode::OK;
+		}
+
+		void DisplayFrame() override
+		{
+			if (bVSync)
+			{
+				const auto dRefresh = std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(1.0 / nRefreshRate));
+				auto tpNow = std::chrono::steady_clock::now();
+				while (tpRefresh <= tpNow) tpRefresh += dRefresh;
+				std::this_thread::sleep_until(tpRefresh);
+			}
+			std::swap(vecQuads, vecPresented);
+			vecQuads.clear();
+			pPresentedClear = pClear;
+			bFrameValid = false;
+		}
+
+		void PrepareDrawing() override
+		{ }
+
+		void DrawLayerQuad(const olc::vf2d& offset, const olc::vf2d& scale, const olc::Pixel tint) override
+		{ vecQuads.push_back({ nBoundTexture, offset, scale, tint }); }
+
+		void DrawDecalQuad(const olc::DecalInstance& decal) override
+		{ UNUSED(decal); } // Decals are not composited
+
+		uint32_t CreateTexture(const uint32_t width, const uint32_t height) override
+		{
+			uint32_t id = nNextTexture++;
+			mapTextures[id] = std::make_unique<olc::Sprite>(width, height);
+			nBoundTexture = id;
+			return id;
+		}
+
+		uint32_t DeleteTexture(const uint32_t id) override
+		{
+			mapTextures.erase(id);
+			return id;
+		}
+
+		void UpdateTexture(uint32_t id, olc::Sprite* spr) override
+		{
+			std::unique_ptr<olc::Sprite>& tex = mapTextures[id];
+			if (!tex || tex->width != spr->width || tex->height != spr->height)
+			{
+				tex = std::make_unique<olc::Sprite>(spr->width, spr->height);
+				spr->MarkDirty();
+			}
+
+			if (!spr->IsDirty()) return;
+			olc::vi2d pos = spr->vDirtyMin;
+			olc::vi2d size = spr->vDirtyMax - spr->vDirtyMin;
+			for (int32_t y = pos.y; y < pos.y + size.y; y++)
+				spr->ExpandRow(pos.x, y, size.x, tex->pColData + y * tex->width + pos.x);
+			spr->ClearDirty();
+			nUploadBytes += uint32_t(size.x * size.y * sizeof(olc::Pixel));
+		}
+
+		void ApplyTexture(uint32_t id) override
+		{ nBoundTexture = id; }
+
+		void ClearBuffer(olc::Pixel p, bool bDepth) override
+		{ UNUSED(bDepth); pClear = p; }
+
+		void UpdateViewport(const olc::vi2d& pos, const olc::vi2d& size) override
+		{ UNUSED(pos); vViewSize = size; }
+
+		olc::Sprite* ReadFrame() override
+		{
+			if (!bFrameValid) Composite();
+			return &sprFrame;
+		}
+
+	private:
+		// Blends the presented layer quads over the clear colour at viewport
+		// resolution, sampling like the GL path does (nearest, repeating)
+		void Composite()
+		{
+			if (sprFrame.width != vViewSize.x || sprFrame.height != vViewSize.y)
+			{
+				delete[] sprFrame.pColData;
+				sprFrame.width = vViewSize.x;
+				sprFrame.height = vViewSize.y;
+				sprFrame.pColData = new olc::Pixel[size_t(vViewSize.x) * size_t(vViewSize.y)];
+			}
+			std::fill(sprFrame.pColData, sprFrame.pColData + size_t(sprFrame.width) * size_t(sprFrame.height), olc::Pixel(pPresentedClear.r, pPresentedClear.g, pPresentedClear.b));
+
+			std::vector<int32_t> vecColumn(sprFrame.width);
+			std::vector<olc::Pixel> vecRow;
+			for (const auto& quad : vecPresented)
+			{
+				auto it = mapTextures.find(quad.id);
+				if (it == mapTextures.end()) continue;
+				const olc::Sprite* tex = it->second.get();
+				if (tex->width == 0 || tex->height == 0) continue;
+
+				auto Wrap = [](float t, int32_t n)
+				{
+					int32_t i = int32_t(std::floor(t * float(n))) % n;
+					return i < 0 ? i + n : i;
+				};
+
+				auto Over = [&](olc::Pixel* dst, const olc::Pixel* src, const int32_t* column)
+				{
+					for (int32_t x = 0; x < sprFrame.width; x++)
+					{
+						olc::Pixel s = src[column ? column[x] : x];
+						uint32_t a = (uint32_t(s.a) * quad.tint.a + 127) / 255;
+						if (a == 0) continue;
+						uint32_t r = (uint32_t(s.r) * quad.tint.r + 127) / 255;
+						uint32_t g = (uint32_t(s.g) * quad.tint.g + 127) / 255;
+						uint32_t b = (uint32_t(s.b) * quad.tint.b + 127) / 255;
+						olc::Pixel d = dst[x];
+						dst[x] = olc::Pixel(
+							uint8_t((r * a + d.r * (255 - a) + 127) / 255),
+							uint8_t((g * a + d.g * (255 - a) + 127) / 255),
+							uint8_t((b * a + d.b * (255 - a) + 127) / 255));
+					}
+				};
+
+				// Layers scaled down by a whole factor, as SetRenderScale() does,
+				// are upscaled a row at a time rather than sampled per pixel
+				int32_t f = sprFrame.width / tex->width;
+				if (quad.offset.x == 0.0f && quad.offset.y == 0.0f && quad.scale.x == 1.0f && quad.scale.y == 1.0f
+					&& f > 0 && tex->width * f == sprFrame.width && tex->height * f == sprFrame.height)
+				{
+					vecRow.resize(size_t(sprFrame.width));
+					for (int32_t ty = 0; ty < tex->height; ty++)
+					{
+						olc::UpscaleRow(tex->pColData + ty * tex->width, tex->width, vecRow.data(), uint32_t(f));
+						for (int32_t y = ty * f; y < (ty + 1) * f; y++)
+							Over(sprFrame.pColData + y * sprFrame.width, vecRow.data(), nullptr);
+					}
+					continue;
+				}
+
+				for (int32_t x = 0; x < sprFrame.width; x++)
+					vecColumn[x] = Wrap((float(x) + 0.5f) / float(sprFrame.width) * quad.scale.x + quad.offset.x, tex->width);
+
+				for (int32_t y = 0; y < sprFrame.height; y++)
+				{
+					const olc::Pixel* src = tex->pColData + Wrap((float(y) + 0.5f) / float(sprFrame.height) * quad.scale.y + quad.offset.y, tex->height) * tex->width;
+					Over(sprFrame.pColData + y * sprFrame.width, src, vecColumn.data());
+				}
+			}
+			bFrameValid = true;
+		}
+	};
+}
+#endif
+// O------------------------------------------------------------------------------O
+// | END RENDERER: Null                                                           |
+// O------------------------------------------------------------------------------O
+
+
+// O------------------------------------------------------------------------------O
+// | START PLATFORM: HEADLESS                                                     |
+// O------------------------------------------------------------------------------O
+#if defined(OLC_PLATFORM_HEADLESS)
+namespace olc
+{
+	class Platform_Headless : public olc::Platform
+	{
+	public:
+		virtual olc::rcode ApplicationStartUp() override
+		{ return olc::rcode::OK; }
+
+		virtual olc::rcode ApplicationCleanUp() override
+		{ return olc::rcode::OK; }
+
+		virtual olc::rcode ThreadStartUp() override
+		{ return olc::rcode::OK; }
+
+		virtual olc::rcode ThreadCleanUp() override
+		{
+			renderer->DestroyDevice();
+			return olc::OK;
+		}
+
+		virtual olc::rcode CreateGraphics(bool bFullScreen, bool bEnableVSYNC, const olc::vi2d& vViewPos, const olc::vi2d& vViewSize) override
+		{
+			if (renderer->CreateDevice({}, bFullScreen, bEnableVSYNC) == olc::rcode::OK)
+			{
+				renderer->UpdateViewport(vViewPos, vViewSize);
+				return olc::rcode::OK;
+			}
+			else
+				return olc::rcode::FAIL;
+		}
+
+		virtual olc::rcode CreateWindowPane(const olc::vi2d& vWindowPos, olc::vi2d& vWindowSize, bool bFullScreen) override
+		{
+			// The "window" is just the requested size
+			UNUSED(vWindowPos); UNUSED(vWindowSize); UNUSED(bFullScreen);
+			return olc::OK;
+		}
+
+		virtual olc::rcode SetWindowTitle(const std::string& s) override
+		{
+			// No window to title, and stdout belongs to the program; the FPS
+			// the title would show is still read through GetFPS()
+			UNUSED(s);
+			return olc::OK;
+		}
+
+		virtual olc::rcode StartSystemEventLoop() override
+		{ return olc::OK; }
+
+		virtual olc::rcode HandleSystemEvent() override
+		{ return olc::OK; }
+	};
+
+	olc::rcode Sprite::LoadFromFile(const std::string& sImageFile, olc::ResourcePack* pack)
+	{
+		// No image codecs without a platform, only the engine's own format
+		return LoadFromPGESprFile(sImageFile, pack);
+	}
+}
+#endif
+// O------------------------------------------------------------------------------O
+// | END PLATFORM: HEADLESS                                                       |
+// O------------------------------------------------------------------------------O
+
+
 // O------------------------------------------------------------------------------O
 // | START PLATFORM: MICROSOFT WINDOWS XP, VISTA, 7, 8, 10                        |
 // O------------------------------------------------------------------------------O
-#if defined(_WIN32)
+#if defined(_WIN32) && !defined(OLC_PLATFORM_HEADLESS)
 #if !defined(__MINGW32__)
 	#pragma comment(lib, "user32.lib")		// Visual Studio Only
 	#pragma comment(lib, "gdi32.lib")		// For other Windows Compilers please add
@@ -3016,7 +5304,7 @@ namespace olc
 // O------------------------------------------------------------------------------O
 // | START PLATFORM: LINUX                                                        |
 // O------------------------------------------------------------------------------O
-#if defined(__linux__) || defined(__FreeBSD__)
+#if (defined(__linux__) || defined(__FreeBSD__)) && !defined(OLC_PLATFORM_HEADLESS)
 namespace olc
 {
 	class Platform_Linux : public olc::Platform
@@ -3341,6 +5629,9 @@ namespace olc
 {
 	void PixelGameEngine::olc_ConfigureSystem()
 	{
+#if defined(OLC_PLATFORM_HEADLESS)
+		platform = std::make_unique<olc::Platform_Headless>();
+#else
 #if defined(_WIN32)
 		platform = std::make_unique<olc::Platform_Windows>();
 #endif
@@ -3348,6 +5639,11 @@ namespace olc
 #if defined(__linux__) || defined(__FreeBSD__)
 		platform = std::make_unique<olc::Platform_Linux>();
 #endif
+#endif
+
+#if defined(OLC_GFX_NULL)
+		renderer = std::make_unique<olc::Renderer_Null>();
+#endif
 
 #if defined(OLC_GFX_OPENGL10)
 		renderer = std::make_unique<olc::Renderer_OGL10>();
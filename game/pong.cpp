@@ -6,11 +6,23 @@
 
 */
 
+#include <atomic>
+#include <cstdio>
 #include <iostream>
+#include <memory>
+#include <random>
+#include <thread>
+#include <vector>
 
 #include "olcPixelGameEngine.hpp"
+#include "AI.hpp"
+#include "Args.hpp"
 #include "Board.hpp"
+#include "Net.hpp"
+#include "Replay.hpp"
 #include "SerialOpen.hpp"
+#include "Spectate.hpp"
+#include "Telemetry.hpp"
 #include "../controller/controller-info.hpp"
 
 class Pong : public olc::PixelGameEngine
@@ -18,6 +30,59 @@ class Pong : public olc::PixelGameEngine
 public:
     Pong() { sAppName = "Pong"; }
 
+    // Recording, if a file is given.
+    std::string recordFile;
+
+    // Chrome trace of the profiled zones, if a file is given.
+    std::string profileFile;
+
+    // Threads rasterizing the board, 0 for one per core.
+    uint32_t rasterThreads = 0;
+
+    // Full colour layers instead of palette indices.
+    bool fullColor = false;
+
+    // Divisor of the resolution the board is drawn at before upscaling.
+    uint32_t renderScale = 1;
+
+    // Frame rate cap, 0 for none, and whether to only sleep while waiting.
+    double frameRate = 0.0;
+    bool   lowPower  = false;
+
+    // Starts frames as late as possible before the next present.
+    bool justInTime = false;
+
+    // The match's size, serve seed and ticks per second.
+    Board::Config config;
+
+    // Replay to save the buttons to, or to play instead of the controller.
+    std::string saveReplayFile;
+    std::string replayFile;
+
+    // Replay speed, changed with the up and down keys.
+    std::atomic<double> replaySpeed{1.0};
+
+    // Two-host play: the paddle owned here, the other host, and packet
+    // loss and delay in ms to emulate.
+    std::string netSide, netPeer;
+    uint16_t    netPort = 0, netPeerPort = 0;
+    uint32_t    rollback = 12;
+    double      netLoss = 0.0, netDelay = 0.0, netJitter = 0.0;
+
+    // Port to send the match to spectators on, 0 for none, or a match to
+    // watch instead of playing.
+    uint16_t    spectatePort = 0;
+    std::string watchHost;
+    uint16_t    watchPort = 0;
+
+    // Paddles played by the computer, left, right or both, and how well.
+    std::string    aiSide;
+    AI::Difficulty aiDifficulty;
+
+    // File to export telemetry to, and how often in seconds.
+    std::string telemetryFile;
+    double      telemetryInterval = 10.0;
+
 private:
     /* CONTROLLER VARIABLES. */
 
@@ -26,57 +91,134 @@ private:
     char buffer[1];
     int  port;
 
-    // Buttons.
-    bool states[NUM_BUTTONS];
-    enum Buttons
-    {
-        LEFT_DOWN,
-        LEFT_UP,
-        SERVE,
-        RIGHT_DOWN,
-        RIGHT_UP
-    };
-
     /* GAME VARIABLES. */
 
-    // Paddles and ball.
-    Board::Paddle left = Board::Paddle(), right = Board::Paddle();
-    Board::Ball   ball = Board::Ball();
+    // Paddles and ball, created once the config is final.
+    std::unique_ptr<Board::Match> match;
+
+    // Exchanges buttons with the other host and ticks the match.
+    std::unique_ptr<Net::Session> session;
+
+    // Computer players, and the board they last saw.
+    std::vector<AI::Controller> ais;
+    Board::State                aiView;
+
+    /* REPLAY VARIABLES. */
+
+    Replay::Recorder recorder;
+    Replay::Player   player;
+
+    // Pausing, and ticks to step while paused, from the engine thread.
+    std::atomic<bool> paused{false};
+    std::atomic<int>  steps{0};
+
+    /* SPECTATOR VARIABLES. */
+
+    Spectate::Server spectators;
+    Spectate::Client watched;
+
+    /* TELEMETRY VARIABLES. */
+
+    Telemetry::Exporter exporter;
+
+    /* THREADING VARIABLES. */
+
+    // The controller, match and replays are only touched by the simulation
+    // thread, which hands copies of the board to the engine thread for
+    // drawing.
+    std::thread                     simulation;
+    std::atomic<bool>               simulating{false};
+    olc::TripleBuffer<Board::State> snapshots;
 
 public:
 	bool OnUserCreate() override
 	{
-        // Tries to open serial port.
-        // TODO: autodetect Arduino.        
-        port = SerialOpen::port("/dev/ttyACM0", BAUD_RATE);
-        if (port < 0)
+        // A replay brings its own config and replaces the controller.
+        if (!replayFile.empty())
+        {
+            if (!player.Open(replayFile))
+            {
+                std::cerr << "Error reading replay " << replayFile << "." << std::endl;
+                return false;
+            }
+            config = player.GetConfig();
+            std::cout << "Replaying " << player.GetLength() << " ticks. Space pauses, right"
+                      << " steps a tick, up and down change the speed." << std::endl;
+        }
+        // So does a match being watched.
+        else if (!watchHost.empty())
+        {
+            if (!watched.Open(watchHost, watchPort))
+            {
+                std::cerr << "Error watching " << watchHost << ":" << watchPort << "." << std::endl;
+                return false;
+            }
+            config = watched.GetConfig();
+        }
+        // No one needs the controller when the computer plays both sides.
+        else if (aiSide != "both")
+        {
+            // Tries to open serial port.
+            // TODO: autodetect Arduino.
+            port = SerialOpen::port("/dev/ttyACM0", BAUD_RATE);
+            if (port < 0)
+            {
+                std::cerr << "Error " -port << " opening port." << std::endl;
+                return false;
+            }
+        }
+
+        if ((!replayFile.empty() || !watchHost.empty())
+            && (config.size.x != ScreenWidth() || config.size.y != ScreenHeight()))
+        {
+            std::cerr << "The " << (watchHost.empty() ? "replay" : "match") << " needs --size "
+                      << config.size.x << "x" << config.size.y << "." << std::endl;
+            return false;
+        }
+        config.size = {ScreenWidth(), ScreenHeight()};
+        if (!saveReplayFile.empty() && !recorder.Open(saveReplayFile, config))
         {
-            std::cerr << "Error " -port << " opening port." << std::endl;
+            std::cerr << "Error opening " << saveReplayFile << " for the replay." << std::endl;
             return false;
         }
 
-        // Paddle initialization.
-        float horizontalOffset = 24.0f;
-        left = Board::Paddle{
-            this,
-            horizontalOffset,
-            &states[LEFT_DOWN],
-            &states[LEFT_UP]
-        };
-        right = Board::Paddle{
-            this,
-            static_cast<float>(ScreenWidth()) - horizontalOffset,
-            &states[RIGHT_DOWN],
-            &states[RIGHT_UP]
+        SetFrameRate(frameRate, lowPower   ? olc::FrameScheduler::Mode::LOW_POWER
+                              : justInTime ? olc::FrameScheduler::Mode::JUST_IN_TIME
+                                           : olc::FrameScheduler::Mode::PRECISE);
+        SetRenderScale(renderScale);
+        SetRasterThreads(rasterThreads);
+
+        // The board only ever uses these colours, so layers can store a byte
+        // per pixel instead of four.
+        std::vector<olc::Pixel> palette = {
+            olc::BLANK,
+            Board::BORDER_COLOR,
+            Board::BACKGROUND_COLOR,
+            Board::PLAY_OBJECT_COLOR
         };
+        if (!fullColor)
+            SetLayerPalette(0, palette);
+
+        // Paddle and ball initialization.
+        match = std::make_unique<Board::Match>(config);
 
-        // Ball initialization.
-        ball = Board::Ball{
-            this,
-            &states[SERVE]
-            };
-        ball.AddPaddle(left);
-        ball.AddPaddle(right);
+        if (!netSide.empty())
+        {
+            session = std::make_unique<Net::Session>(
+                *match, netSide == "left" ? Board::Ball::P_LEFT : Board::Ball::P_RIGHT, rollback);
+            if (!session->Open(netPort, netPeer, netPeerPort))
+                return false;
+            session->Emulate(netLoss, netDelay, netJitter);
+        }
+
+        for (Board::Ball::Players side : {Board::Ball::P_LEFT, Board::Ball::P_RIGHT})
+        {
+            if (aiSide == "both" || aiSide == (side == Board::Ball::P_LEFT ? "left" : "right"))
+                ais.emplace_back(config, side, aiDifficulty, config.seed + side);
+        }
+
+        if (spectatePort != 0 && !spectators.Open(spectatePort, config))
+            return false;
 
         // Renders the background.
         int        borderWidth = 4;
@@ -84,6 +226,8 @@ public:
         olc::Pixel bgColor     = Board::BACKGROUND_COLOR;
 
         int bgLayer = CreateLayer();
+        if (!fullColor)
+            SetLayerPalette(bgLayer, palette);
         SetDrawTarget(bgLayer);
 
         // Draws board and border.
@@ -109,40 +253,397 @@ public:
         EnableLayer(bgLayer, true);
         SetDrawTarget(nullptr);
 
+        // Starts recording once the background exists, so it's captured too.
+        // Anything not named .y4m gets raw RGBA frames.
+        bool y4m = recordFile.size() >= 4 && recordFile.compare(recordFile.size() - 4, 4, ".y4m") == 0;
+        if (!recordFile.empty() && StartRecording(
+                recordFile,
+                y4m ? olc::FrameRecorder::Format::Y4M : olc::FrameRecorder::Format::RGBA
+            ) != olc::OK)
+        {
+            std::cerr << "Error opening " << recordFile << " for recording." << std::endl;
+            return false;
+        }
+
+        if (!telemetryFile.empty())
+            exporter.Start(telemetryFile, telemetryInterval);
+
+        // Starts the simulation last, as OnUserDestroy isn't called if
+        // creation fails.
+        Board::State initial;
+        match->Snapshot(initial);
+        snapshots.Fill(initial);
+        simulating = true;
+        simulation = std::thread(&Pong::Simulate, this);
+
+        return true;
+    }
+
+    bool OnUserDestroy() override
+    {
+        simulating = false;
+        if (simulation.joinable())
+            simulation.join();
+
+        // Writes the telemetry one last time.
+        exporter.Stop();
+
+        if (session)
+        {
+            const Net::Session::Stats& stats = session->GetStats();
+            std::cout << "Played " << stats.nTicks << " ticks, stalled " << stats.nStalls
+                      << ", rolled back " << stats.nRollbacks << " times by up to "
+                      << stats.nMaxDepth << " ticks, costing " << stats.fMeanRollbackUs
+                      << " us mean, " << stats.fMaxRollbackUs << " us max." << std::endl;
+        }
+
+        if (spectatePort != 0)
+        {
+            spectators.Close();
+            Spectate::Server::Stats stats = spectators.GetStats();
+            std::cout << "Encoded " << stats.nFrames << " ticks for spectators in "
+                      << stats.nBytesEncoded << " bytes, sent " << stats.nBytesSent
+                      << " bytes, dropped " << stats.nDropped << " spectators." << std::endl;
+        }
+
+        if (recorder.IsOpen())
+        {
+            uint64_t ticks = recorder.GetTicks();
+            if (recorder.Close())
+                std::cout << "Saved " << ticks << " ticks of replay in "
+                          << recorder.GetBytes() << " bytes." << std::endl;
+            else
+                std::cerr << "Error writing " << saveReplayFile << "." << std::endl;
+        }
+
+        if (IsRecording())
+        {
+            StopRecording();
+            olc::FrameRecorder::Stats stats = GetRecordingStats();
+            std::cout << "Recorded " << stats.nFramesWritten << " frames, dropped "
+                      << stats.nFramesDropped << ", capture cost "
+                      << stats.fMeanCaptureUs << " us mean, "
+                      << stats.fMaxCaptureUs << " us max." << std::endl;
+        }
+        if (!profileFile.empty() && olc::Profiler::WriteChromeTrace(profileFile) != olc::OK)
+            std::cerr << "Error writing " << profileFile << "." << std::endl;
         return true;
     }
 
 	bool OnUserUpdate(float fElapsedTime) override
 	{
-        Clear(olc::BLANK);
+        Telemetry::Observe(Telemetry::FRAME_TIME, fElapsedTime);
+
+        if (!replayFile.empty())
+        {
+            if (GetKey(olc::Key::SPACE).bPressed)
+                paused = !paused;
+            if (GetKey(olc::Key::RIGHT).bPressed)
+            {
+                paused = true;
+                steps++;
+            }
+            if (GetKey(olc::Key::UP).bPressed)
+                replaySpeed = replaySpeed * 2.0;
+            if (GetKey(olc::Key::DOWN).bPressed)
+                replaySpeed = replaySpeed / 2.0;
+        }
 
-        ControllerUpdate();
+        {
+            OLC_PROFILE_ZONE("Clear");
+            Clear(olc::BLANK);
+        }
 
-        ball.Update(fElapsedTime);
+        Board::Draw(this, snapshots.Latest());
 
         return true;
 	}
 
 private:
-    void ControllerUpdate()
+    void Simulate()
+    {
+        OLC_PROFILE_THREAD("Simulation");
+
+        if (!watchHost.empty())
+        {
+            Watch();
+            return;
+        }
+
+        // The match advances in fixed ticks, as many as the time since the
+        // last loop covers, so it plays the same however often the
+        // controller answers. Replays and computer players have no
+        // controller to wait on, and two-host play sends a packet every
+        // tick, so they loop once a tick.
+        double tick = 1.0 / static_cast<double>(config.tickRate);
+        double owed = 0.0;
+        bool   replaying = !replayFile.empty(), ended = false;
+        bool   reading   = !replaying && aiSide != "both";
+        Board::Keyframe keyframe;
+
+        olc::FrameScheduler loop;
+        loop.SetTargetRate(!reading || session ? config.tickRate : 0.0,
+                           lowPower ? olc::FrameScheduler::Mode::LOW_POWER
+                                    : olc::FrameScheduler::Mode::PRECISE);
+        auto last = loop.Wait();
+        while (simulating)
+        {
+            auto now = loop.Wait();
+            double elapsed = std::chrono::duration<double>(now - last).count();
+            last = now;
+
+            unsigned char buttons = 0;
+            if (replaying)
+            {
+                owed += paused ? steps.exchange(0) * tick : elapsed * replaySpeed;
+            }
+            else if (reading)
+            {
+                OLC_PROFILE_ZONE("ControllerUpdate");
+                buttons = ControllerUpdate();
+                owed   += elapsed;
+            }
+            else
+                owed += elapsed;
+
+            {
+                OLC_PROFILE_ZONE("Match::Tick");
+                for (; owed >= tick; owed -= tick)
+                {
+                    if (replaying && !player.Next(buttons))
+                    {
+                        if (!ended)
+                            std::cout << "End of the replay." << std::endl;
+                        ended = true;
+                        owed  = 0.0;
+                        break;
+                    }
+
+                    // Computer players take over their paddle's buttons.
+                    unsigned char pressed = buttons;
+                    if (!ais.empty())
+                        match->Snapshot(aiView);
+                    for (AI::Controller& ai : ais)
+                        pressed = (pressed & ~ai.GetMask()) | ai.Decide(aiView);
+
+                    // Waits on the other host by dropping the time owed.
+                    if (session)
+                    {
+                        if (!session->Tick(pressed))
+                        {
+                            owed = 0.0;
+                            break;
+                        }
+                    }
+                    else
+                    {
+                        match->Tick(pressed);
+                        recorder.Tick(pressed);
+                    }
+
+                    if (spectatePort != 0)
+                    {
+                        match->Save(keyframe);
+                        spectators.Publish(keyframe);
+                    }
+                }
+            }
+
+            match->Snapshot(snapshots.Back());
+            snapshots.Publish();
+        }
+    }
+
+    // Shows a match played elsewhere, a frame as each arrives.
+    void Watch()
+    {
+        Spectate::Frame frame;
+        while (simulating)
+        {
+            if (watched.Receive(frame, 100))
+            {
+                frame.Apply(snapshots.Back());
+                snapshots.Publish();
+            }
+            else if (!watched.IsOpen())
+            {
+                std::cout << "The match is no longer being sent." << std::endl;
+                return;
+            }
+        }
+    }
+
+    unsigned char ControllerUpdate()
     {
-        // Updates button states array.
+        // Reads the button states byte.
         read(port, buffer, 1);
+        bool states[NUM_BUTTONS];
+        decodeButtons(buffer[0], states);
         std::cout << std::endl;
         for (int i = 0; i < NUM_BUTTONS; i++)
-        {
-            states[i] = (buffer[0] >> i) & 0x01;
             std::cout << "Button " << i << ": " << states[i] << std::endl;
-        }
         write(port, confirmation, 1);
+        return buffer[0];
     }
 };
 
-int main()
+int main(int argc, char* argv[])
 {
     // Initializes the game window.
     Pong game;
-    int  state = game.Construct(1080,720,1,1);
+
+    // Optional arguments.
+    int    width = 1080, height = 720;
+    bool   vsync = false, seeded = false;
+    double replaySpeed = 1.0;
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        if (arg == "--record" && i + 1 < argc)
+            game.recordFile = argv[++i];
+        else if (arg == "--full-color")
+            game.fullColor = true;
+        else if (arg == "--threads" && i + 1 < argc
+                 && Args::Number(arg.c_str(), argv[++i], game.rasterThreads, 0u, 1024u))
+            continue;
+        else if (arg == "--render-scale" && i + 1 < argc
+                 && Args::Number(arg.c_str(), argv[++i], game.renderScale, 1u, 16u))
+            continue;
+        else if (arg == "--fps" && i + 1 < argc
+                 && Args::Number(arg.c_str(), argv[++i], game.frameRate, 0.0))
+            continue;
+        else if (arg == "--low-power")
+            game.lowPower = true;
+        else if (arg == "--jit")
+            game.justInTime = true;
+        else if (arg == "--vsync")
+            vsync = true;
+        else if (arg == "--tick-rate" && i + 1 < argc
+                 && Args::Number(arg.c_str(), argv[++i], game.config.tickRate, 1u))
+            continue;
+        else if (arg == "--seed" && i + 1 < argc
+                 && Args::Number(arg.c_str(), argv[++i], game.config.seed))
+            seeded = true;
+        else if (arg == "--save-replay" && i + 1 < argc)
+            game.saveReplayFile = argv[++i];
+        else if (arg == "--replay" && i + 1 < argc)
+            game.replayFile = argv[++i];
+        else if (arg == "--replay-speed" && i + 1 < argc
+                 && Args::Number(arg.c_str(), argv[++i], replaySpeed, 1.0 / 64.0, 64.0))
+            game.replaySpeed = replaySpeed;
+        else if (arg == "--net" && i + 3 < argc
+                 && (std::string(argv[i + 1]) == "left" || std::string(argv[i + 1]) == "right")
+                 && Args::Number(arg.c_str(), argv[i + 2], game.netPort, uint16_t(1), uint16_t(65535))
+                 && Net::SplitAddress(argv[i + 3], game.netPeer, game.netPeerPort))
+        {
+            game.netSide = argv[i + 1];
+            i += 3;
+        }
+        else if (arg == "--rollback" && i + 1 < argc
+                 && Args::Number(arg.c_str(), argv[++i], game.rollback, 1u, Net::Session::HISTORY / 3))
+            continue;
+        else if (arg == "--net-loss" && i + 1 < argc
+                 && Args::Number(arg.c_str(), argv[++i], game.netLoss, 0.0, 1.0))
+            continue;
+        else if (arg == "--net-delay" && i + 1 < argc
+                 && Args::Number(arg.c_str(), argv[++i], game.netDelay, 0.0))
+            continue;
+        else if (arg == "--net-jitter" && i + 1 < argc
+                 && Args::Number(arg.c_str(), argv[++i], game.netJitter, 0.0))
+            continue;
+        else if (arg == "--spectate" && i + 1 < argc
+                 && Args::Number(arg.c_str(), argv[++i], game.spectatePort, uint16_t(1), uint16_t(65535)))
+            continue;
+        else if (arg == "--watch" && i + 1 < argc
+                 && Net::SplitAddress(argv[i + 1], game.watchHost, game.watchPort))
+            i++;
+        else if (arg == "--ai" && i + 1 < argc
+                 && (std::string(argv[i + 1]) == "left" || std::string(argv[i + 1]) == "right"
+                     || std::string(argv[i + 1]) == "both"))
+            game.aiSide = argv[++i];
+        else if (arg == "--ai-reaction" && i + 1 < argc
+                 && Args::Number(arg.c_str(), argv[++i], game.aiDifficulty.reaction, 0.0f))
+            game.aiDifficulty.reaction /= 1000.0f;
+        else if (arg == "--ai-error" && i + 1 < argc
+                 && Args::Number(arg.c_str(), argv[++i], game.aiDifficulty.error, 0.0f))
+            continue;
+        else if (arg == "--telemetry" && i + 1 < argc)
+            game.telemetryFile = argv[++i];
+        else if (arg == "--telemetry-interval" && i + 1 < argc
+                 && Args::Number(arg.c_str(), argv[++i], game.telemetryInterval, 0.1))
+            continue;
+        else if (arg == "--profile" && i + 1 < argc)
+            game.profileFile = argv[++i];
+        else if (arg == "--size" && i + 1 < argc
+                 && std::sscanf(argv[++i], "%dx%d", &width, &height) == 2)
+            continue;
+        else
+        {
+            std::cerr << "Usage: " << argv[0]
+                      << " [--record file.y4m] [--threads n] [--size 3840x2160]"
+                      << " [--render-scale n] [--full-color] [--fps n] [--low-power]"
+                      << " [--jit] [--vsync]"
+                      << " [--tick-rate n] [--seed n] [--profile trace.json]"
+                      << " [--save-replay file] [--replay file [--replay-speed x]]"
+                      << " [--net left|right port host:port|[host]:port [--rollback ticks]"
+                      << " [--net-loss 0.1] [--net-delay ms] [--net-jitter ms]]"
+                      << " [--spectate port] [--watch host:port|[host]:port]"
+                      << " [--ai left|right|both [--ai-reaction ms] [--ai-error px]]"
+                      << " [--telemetry file.prom|file.csv [--telemetry-interval s]]"
+                      << std::endl;
+            return 1;
+        }
+    }
+
+    if (!game.saveReplayFile.empty() && game.config.tickRate > Replay::MAX_TICK_RATE)
+    {
+        std::cerr << "Replays are saved at " << Replay::MAX_TICK_RATE << " ticks a second at most." << std::endl;
+        return 1;
+    }
+
+    if (!game.netSide.empty() && (!game.replayFile.empty() || !game.saveReplayFile.empty()))
+    {
+        std::cerr << "Replays can't be saved or played with --net." << std::endl;
+        return 1;
+    }
+
+    if (!game.watchHost.empty() && (!game.replayFile.empty() || !game.saveReplayFile.empty()
+                                    || !game.netSide.empty() || game.spectatePort != 0
+                                    || !game.aiSide.empty()))
+    {
+        std::cerr << "--watch only shows the match, it can't be combined with replays, --net,"
+                  << " --spectate or --ai." << std::endl;
+        return 1;
+    }
+
+    if (!game.aiSide.empty() && (!game.replayFile.empty()
+                                 || (!game.netSide.empty() && game.aiSide != game.netSide)))
+    {
+        std::cerr << "--ai can't play a replay, or over --net any side but this host's." << std::endl;
+        return 1;
+    }
+
+    // Every match serves differently unless a seed is given, except over
+    // the network, where both hosts need the same one.
+    if (!seeded && game.netSide.empty())
+        game.config.seed = std::random_device()();
+
+    if (!game.telemetryFile.empty())
+        Telemetry::Enable(true);
+
+    if (!game.profileFile.empty())
+    {
+#if !defined(OLC_PROFILER)
+        std::cerr << "Built without OLC_PROFILER, the trace will be empty." << std::endl;
+#endif
+        olc::Profiler::Enable(true);
+    }
+
+    // Just in time needs to know when presents are due.
+    if (game.justInTime && game.frameRate <= 0.0)
+        game.frameRate = 60.0;
+
+    int  state = game.Construct(width,height,1,1,false,vsync);
     if(state)
     {
         game.Start();
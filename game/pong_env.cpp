@@ -0,0 +1,186 @@
+#include <algorithm>
+#include <deque>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "Board.hpp"
+#include "pong_env.h"
+
+struct PongEnv
+{
+    uint32_t                 count;
+    uint32_t                 seed;
+    std::deque<Board::Match> matches;
+    Board::Keyframe          start;     // A match before its first tick.
+    std::vector<uint32_t>    episodes;  // Matches each has started.
+    std::vector<int>         scores;    // Both scores of each, last step.
+    olc::WorkerPool          pool;
+    uint32_t                 chunks;
+};
+
+namespace
+{
+
+// Serve seed of a match, in std::minstd_rand's range.
+uint32_t serveSeed(uint32_t seed, uint32_t match, uint32_t episode)
+{
+    return Board::MixSeed((static_cast<uint64_t>(seed) << 32 | match)
+                          ^ static_cast<uint64_t>(episode) * 0x9E3779B97F4A7C15ull);
+}
+
+void restart(PongEnv* env, uint32_t i)
+{
+    Board::Keyframe k = env->start;
+    k.rng = serveSeed(env->seed, i, env->episodes[i]++);
+    env->matches[i].Restore(k);
+    env->scores[2 * i]     = 0;
+    env->scores[2 * i + 1] = 0;
+}
+
+void observe(const PongEnv* env, uint32_t i, const Board::State& s, float* observations)
+{
+    float* o = observations + i;
+    size_t n = env->count;
+    o[PONG_ENV_BALL_X * n]      = s.ball.pos.x;
+    o[PONG_ENV_BALL_Y * n]      = s.ball.pos.y;
+    o[PONG_ENV_BALL_VX * n]     = s.velocity.x;
+    o[PONG_ENV_BALL_VY * n]     = s.velocity.y;
+    o[PONG_ENV_LEFT_Y * n]      = s.paddles[Board::Ball::P_LEFT].pos.y;
+    o[PONG_ENV_RIGHT_Y * n]     = s.paddles[Board::Ball::P_RIGHT].pos.y;
+    o[PONG_ENV_LEFT_SCORE * n]  = static_cast<float>(s.scores[Board::Ball::P_LEFT]);
+    o[PONG_ENV_RIGHT_SCORE * n] = static_cast<float>(s.scores[Board::Ball::P_RIGHT]);
+    o[PONG_ENV_STATE * n]       = static_cast<float>(s.state);
+}
+
+// Runs job(i) for every match, a contiguous run of them per pool job, so
+// threads write to different parts of the buffers. The pool's job captures
+// no more than std::function holds without allocating.
+template <typename Job>
+void forEach(PongEnv* env, const Job& job)
+{
+    env->pool.ParallelFor(env->chunks, [env, &job](uint32_t chunk)
+    {
+        uint32_t per = (env->count + env->chunks - 1) / env->chunks;
+        uint32_t end = std::min(env->count, (chunk + 1) * per);
+        for (uint32_t i = chunk * per; i < end; i++)
+            job(i);
+    });
+}
+
+}
+
+PongEnv* pong_env_create(uint32_t count, uint32_t width, uint32_t height, uint32_t tick_rate,
+                         uint32_t max_score, uint32_t seed, uint32_t threads)
+{
+    // The board must fit both paddles, and the ball between them.
+    if (count == 0 || width < 100 || height < 120 || width > 65535 || height > 65535
+        || tick_rate == 0 || max_score == 0 || max_score > 255)
+        return nullptr;
+
+    Board::Config config;
+    config.size     = {static_cast<int>(width), static_cast<int>(height)};
+    config.seed     = seed;
+    config.tickRate = tick_rate;
+    config.maxScore = static_cast<int>(max_score);
+
+    // Out of memory or threads, nothing is left behind.
+    try
+    {
+        std::unique_ptr<PongEnv> env(new PongEnv);
+        env->count = count;
+        env->seed  = seed;
+        for (uint32_t i = 0; i < count; i++)
+            env->matches.emplace_back(config);
+        env->matches[0].Save(env->start);
+        env->episodes.assign(count, 0);
+        env->scores.assign(2 * size_t(count), 0);
+
+        if (threads == 0)
+            threads = std::max(1u, std::thread::hardware_concurrency());
+        threads = std::min(threads, count);
+        env->pool.Start(threads);
+
+        // A few runs per thread even out matches that cost more, such as
+        // those restarting.
+        env->chunks = std::min(count, threads * 4);
+
+        for (uint32_t i = 0; i < count; i++)
+            restart(env.get(), i);
+        return env.release();
+    }
+    catch (...)
+    {
+        return nullptr;
+    }
+}
+
+// Destroying and counting throw nothing.
+void pong_env_destroy(PongEnv* env)
+{
+    delete env;
+}
+
+uint32_t pong_env_count(const PongEnv* env)
+{
+    return env->count;
+}
+
+int pong_env_reset(PongEnv* env, float* observations)
+{
+    if (!env || !observations)
+        return PONG_ENV_ERROR;
+    try
+    {
+        forEach(env, [&](uint32_t i)
+        {
+            restart(env, i);
+            Board::State s;
+            env->matches[i].Snapshot(s);
+            observe(env, i, s, observations);
+        });
+    }
+    catch (...)
+    {
+        return PONG_ENV_ERROR;
+    }
+    return PONG_ENV_OK;
+}
+
+int pong_env_step(PongEnv* env, const uint8_t* actions, float* observations,
+                  float* rewards, uint8_t* dones)
+{
+    if (!env || !actions || !observations)
+        return PONG_ENV_ERROR;
+    try
+    {
+        forEach(env, [&](uint32_t i)
+        {
+            Board::Match& match = env->matches[i];
+            Board::State  s;
+            match.Tick(actions[i]);
+            match.Snapshot(s);
+
+            int* last = &env->scores[2 * size_t(i)];
+            if (rewards)
+                rewards[i] = static_cast<float>((s.scores[0] - last[0]) - (s.scores[1] - last[1]));
+            last[0] = s.scores[0];
+            last[1] = s.scores[1];
+
+            bool done = s.state == Board::Ball::WIN;
+            if (dones)
+                dones[i] = done;
+            if (done)
+            {
+                restart(env, i);
+                match.Snapshot(s);
+            }
+            observe(env, i, s, observations);
+        });
+    }
+    catch (...)
+    {
+        return PONG_ENV_ERROR;
+    }
+    return PONG_ENV_OK;
+}
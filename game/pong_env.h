@@ -0,0 +1,88 @@
+/*
+
+    C API for training agents: steps many independent matches at once,
+    built as libpong_env.so by `make pong_env`. Each match plays by the same
+    rules as the game, through Board::Match.
+
+    Every step takes one controller state byte per match, with the bits of
+    Board::Buttons, so either paddle or both can be played by the caller:
+
+        bit 0   left down       bit 3   right down
+        bit 1   left up         bit 4   right up
+        bit 2   serve
+
+    Observations are written as structure of arrays: field f of match i is
+    at observations[f * count + i], for the fields below. Positions are the
+    top left corners in pixels, and velocities in pixels per second.
+
+    The reward is from the left player's side, 1 when they score and -1
+    when the right player does. A match that is won is done, and starts
+    again at once, so its observation is already that of the new match.
+    Every new match serves differently.
+
+    The matches are split between threads. Nothing is allocated after
+    pong_env_create.
+
+    No C++ exception leaves the library. A call that fails returns NULL or
+    PONG_ENV_ERROR instead, and a step or reset that fails partway may
+    have left some matches stepped and some not, so reset before going on.
+
+*/
+
+#ifndef _PONG_ENV_BLOCK
+#define _PONG_ENV_BLOCK
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+enum PongEnvField
+{
+    PONG_ENV_BALL_X,
+    PONG_ENV_BALL_Y,
+    PONG_ENV_BALL_VX,
+    PONG_ENV_BALL_VY,
+    PONG_ENV_LEFT_Y,
+    PONG_ENV_RIGHT_Y,
+    PONG_ENV_LEFT_SCORE,
+    PONG_ENV_RIGHT_SCORE,
+    PONG_ENV_STATE,         /* 0 serving, 1 won, 2 in play. */
+    PONG_ENV_FIELDS
+};
+
+enum PongEnvResult
+{
+    PONG_ENV_OK    = 0,
+    PONG_ENV_ERROR = -1
+};
+
+typedef struct PongEnv PongEnv;
+
+/* Count matches on a board of width by height stepped tick_rate times a
+   second, won at max_score. Threads of 0 uses every core. NULL on bad
+   arguments, or if the matches or threads can't be created. */
+PongEnv* pong_env_create(uint32_t count, uint32_t width, uint32_t height, uint32_t tick_rate,
+                         uint32_t max_score, uint32_t seed, uint32_t threads);
+void     pong_env_destroy(PongEnv* env);
+
+uint32_t pong_env_count(const PongEnv* env);
+
+/* Starts every match again, and writes count * PONG_ENV_FIELDS floats of
+   observations. PONG_ENV_ERROR if env or observations is NULL, or on
+   failure. */
+int pong_env_reset(PongEnv* env, float* observations);
+
+/* Steps every match a tick with count actions, and writes the observations
+   after it, count rewards and count done flags. Rewards and dones may be
+   NULL. PONG_ENV_ERROR if env, actions or observations is NULL, or on
+   failure. */
+int pong_env_step(PongEnv* env, const uint8_t* actions, float* observations,
+                  float* rewards, uint8_t* dones);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
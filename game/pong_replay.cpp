@@ -0,0 +1,137 @@
+/*
+
+    Plays a replay saved by `pong --save-replay` as fast as it can, without a
+    window, and prints how the match ended. Run `pong --replay` to watch one
+    instead.
+
+    It also packs replays into an archive, and seeks to a tick of a match in
+    one, printing the board there.
+
+*/
+
+#include <chrono>
+#include <iostream>
+#include <string>
+
+#include "Args.hpp"
+#include "Board.hpp"
+#include "Replay.hpp"
+
+using Clock = std::chrono::steady_clock;
+
+double microsecondsSince(Clock::time_point start)
+{
+    return std::chrono::duration<double, std::micro>(Clock::now() - start).count();
+}
+
+void printBoard(const Board::Match& match)
+{
+    Board::State s;
+    match.Snapshot(s);
+    std::cout << "Tick " << match.GetTicks() << ": score " << s.scores[Board::Ball::P_LEFT]
+              << " - " << s.scores[Board::Ball::P_RIGHT]
+              << (s.state == Board::Ball::SERVE ? ", serving"
+                : s.state == Board::Ball::WIN   ? ", won"
+                                                : ", in play")
+              << ", ball at " << s.ball.pos.x << ", " << s.ball.pos.y
+              << ", paddles at " << s.paddles[0].pos.y << " and " << s.paddles[1].pos.y
+              << "." << std::endl;
+}
+
+int play(const std::string& path)
+{
+    Replay::Player player;
+    if (!player.Open(path))
+    {
+        std::cerr << "Error reading replay " << path << "." << std::endl;
+        return 1;
+    }
+
+    Board::Match match(player.GetConfig());
+    auto start = Clock::now();
+    for (unsigned char buttons; player.Next(buttons); )
+        match.Tick(buttons);
+    double seconds = microsecondsSince(start) / 1e6;
+
+    double played = static_cast<double>(match.GetTicks()) / match.GetConfig().tickRate;
+    std::cout << "Played " << played << " s of the match in " << seconds * 1e3
+              << " ms (" << played / seconds << "x)." << std::endl;
+    printBoard(match);
+    return 0;
+}
+
+int pack(const std::string& path, int count, char* replays[])
+{
+    Replay::ArchiveWriter archive;
+    if (!archive.Open(path))
+    {
+        std::cerr << "Error creating archive " << path << "." << std::endl;
+        return 1;
+    }
+    for (int i = 0; i < count; i++)
+    {
+        Replay::Player player;
+        if (!player.Open(replays[i]))
+        {
+            std::cerr << "Error reading replay " << replays[i] << "." << std::endl;
+            return 1;
+        }
+        archive.Add(player);
+    }
+    if (!archive.Close())
+    {
+        std::cerr << "Error writing archive " << path << "." << std::endl;
+        return 1;
+    }
+    std::cout << "Packed " << count << " matches." << std::endl;
+    return 0;
+}
+
+int seek(const std::string& path, size_t match, uint64_t tick)
+{
+    Replay::Archive archive;
+    if (!archive.Open(path))
+    {
+        std::cerr << "Error reading archive " << path << "." << std::endl;
+        return 1;
+    }
+    if (match >= archive.GetMatches() || tick > archive.GetLength(match))
+    {
+        std::cerr << "The archive has " << archive.GetMatches() << " matches";
+        if (match < archive.GetMatches())
+            std::cerr << ", and match " << match << " has " << archive.GetLength(match) << " ticks";
+        std::cerr << "." << std::endl;
+        return 1;
+    }
+
+    Board::Match   m(archive.GetConfig(match));
+    Replay::Stream rest;
+    auto start = Clock::now();
+    if (!archive.Seek(match, tick, m, rest))
+    {
+        std::cerr << "The archive is damaged." << std::endl;
+        return 1;
+    }
+    std::cout << "Seeked in " << microsecondsSince(start) << " us." << std::endl;
+    printBoard(m);
+    return 0;
+}
+
+int main(int argc, char* argv[])
+{
+    std::string mode = argc > 1 ? argv[1] : "";
+    if (argc == 2 && mode[0] != '-')
+        return play(mode);
+    if (argc >= 3 && mode == "--pack")
+        return pack(argv[2], argc - 3, argv + 3);
+    size_t   match;
+    uint64_t tick;
+    if (argc == 5 && mode == "--seek" && Args::Number("--seek's match", argv[3], match)
+        && Args::Number("--seek's tick", argv[4], tick))
+        return seek(argv[2], match, tick);
+
+    std::cerr << "Usage: " << argv[0] << " match.replay\n"
+              << "       " << argv[0] << " --pack matches.archive match.replay...\n"
+              << "       " << argv[0] << " --seek matches.archive match tick" << std::endl;
+    return 1;
+}
@@ -0,0 +1,377 @@
+/*
+
+    Sweeps the rules of the game for balance: plays batches of computer
+    against computer matches, without a window, for every combination of
+    the given ranges of ball speed, speed gained per hit, paddle speed and
+    size, winning score and push angle, and writes how each combination
+    played as a line of CSV.
+
+    Each range is a value, or from:to:step with both ends included. The
+    matches are spread over every core a group of combinations at a time,
+    and each group's lines are written and flushed as it finishes, so a
+    long sweep holds little in memory and can be read as it runs. Every
+    combination plays the same serves and computer errors, so the results
+    differ only by the rules, and are the same however many threads run
+    them.
+
+    Matches still going after the time limit are given up and counted in
+    their own column, and the other columns are of finished matches only.
+
+*/
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "olcPixelGameEngine.hpp"
+#include "AI.hpp"
+#include "Args.hpp"
+#include "Board.hpp"
+
+namespace
+{
+
+struct Range
+{
+    float from = 0.0f, to = 0.0f, step = 1.0f;
+
+    bool Parse(const std::string& text)
+    {
+        int read = std::sscanf(text.c_str(), "%f:%f:%f", &from, &to, &step);
+        if (read == 1)
+        {
+            to   = from;
+            step = 1.0f;
+        }
+        return (read == 1 || read == 3) && from <= to && step > 0.0f;
+    }
+
+    uint32_t Count() const
+    {
+        // A little slack so a step that doesn't divide evenly in binary
+        // still reaches the end.
+        return static_cast<uint32_t>(std::floor((to - from) / step + 1e-4f)) + 1;
+    }
+
+    float At(uint32_t i) const { return from + step * static_cast<float>(i); }
+};
+
+enum Parameters
+{
+    BALL_SPEED,
+    SPEED_DELTA,
+    PADDLE_SPEED,
+    PADDLE_WIDTH,
+    PADDLE_HEIGHT,
+    MAX_SCORE,
+    PUSH_ANGLE,
+    PARAMETERS
+};
+
+const char* const FLAGS[PARAMETERS] = {
+    "--ball-speed", "--speed-delta", "--paddle-speed", "--paddle-width",
+    "--paddle-height", "--max-score", "--push-angle"
+};
+
+const char* const COLUMNS[PARAMETERS] = {
+    "ball_speed", "speed_delta", "paddle_speed", "paddle_width",
+    "paddle_height", "max_score", "push_angle"
+};
+
+const uint32_t MAX_MATCHES = 1000000;
+const uint32_t MAX_THREADS = 1024;
+const double   MAX_SECONDS = 86400.0;
+
+struct Sweep
+{
+    Range             ranges[PARAMETERS];
+    Board::Config     base;
+    // Errors past half the default paddle, else the computers return
+    // nearly every ball and matches run out of time.
+    AI::Difficulty    difficulty = {0.15f, 80.0f};
+    uint32_t          matches    = 100;
+    double            maxSeconds = 600.0;   // Of play, before a match is given up.
+    uint32_t          threads    = 0;
+    std::string       output;
+};
+
+// How one match went.
+struct Result
+{
+    uint64_t ticks      = 0;
+    uint32_t points     = 0;
+    uint64_t hits       = 0;
+    double   rallyTime  = 0.0;
+    bool     leftWon    = false;
+    bool     timedOut   = false;
+};
+
+Board::Config configAt(const Sweep& sweep, uint64_t combination)
+{
+    float value[PARAMETERS];
+    for (int p = PARAMETERS - 1; p >= 0; p--)
+    {
+        uint32_t count = sweep.ranges[p].Count();
+        value[p] = sweep.ranges[p].At(static_cast<uint32_t>(combination % count));
+        combination /= count;
+    }
+
+    Board::Config config = sweep.base;
+    config.ballSpeed    = value[BALL_SPEED];
+    config.speedDelta   = value[SPEED_DELTA];
+    config.paddleSpeed  = value[PADDLE_SPEED];
+    config.paddleSize   = {static_cast<int>(value[PADDLE_WIDTH]), static_cast<int>(value[PADDLE_HEIGHT])};
+    config.maxScore     = static_cast<int>(value[MAX_SCORE]);
+    config.maxPushAngle = value[PUSH_ANGLE];
+    return config;
+}
+
+Result play(const Sweep& sweep, Board::Config config, uint32_t match)
+{
+    // The same seeds for match n of every combination.
+    config.seed = sweep.base.seed + match;
+    Board::Match   m(config);
+    AI::Controller left(config, Board::Ball::P_LEFT, sweep.difficulty, 2 * match + 1);
+    AI::Controller right(config, Board::Ball::P_RIGHT, sweep.difficulty, 2 * match + 2);
+
+    Result          result;
+    Board::State    s;
+    Board::Keyframe k;
+    uint64_t limit = static_cast<uint64_t>(sweep.maxSeconds * config.tickRate);
+    m.Snapshot(s);
+    for (;;)
+    {
+        int scored = s.scores[0] + s.scores[1];
+        m.Tick(left.Decide(s) | right.Decide(s));
+        m.Snapshot(s);
+        if (s.scores[0] + s.scores[1] > scored)
+        {
+            // The rally's counts stay until the next serve.
+            m.Save(k);
+            result.points++;
+            result.hits      += static_cast<uint64_t>(k.rallyHits);
+            result.rallyTime += k.rallyTime;
+        }
+        if (s.state == Board::Ball::WIN)
+            break;
+        if (m.GetTicks() >= limit)
+        {
+            result.timedOut = true;
+            break;
+        }
+    }
+    result.ticks   = m.GetTicks();
+    result.leftWon = s.winner == Board::Ball::P_LEFT;
+    return result;
+}
+
+void writeHeader(std::ostream& out)
+{
+    for (const char* column : COLUMNS)
+        out << column << ",";
+    out << "matches,timed_out,mean_rally_hits,mean_rally_seconds,goals_per_minute,"
+           "mean_match_seconds,left_win_rate\n";
+}
+
+void writeLine(std::ostream& out, const Sweep& sweep, const Board::Config& config,
+               const Result* results)
+{
+    // Only finished matches count, as one given up would skew every mean
+    // towards the time limit.
+    uint64_t ticks = 0, points = 0, hits = 0, won = 0, finished = 0;
+    double   rallyTime = 0.0;
+    for (uint32_t i = 0; i < sweep.matches; i++)
+    {
+        const Result& r = results[i];
+        if (r.timedOut)
+            continue;
+        finished++;
+        ticks     += r.ticks;
+        points    += r.points;
+        hits      += r.hits;
+        rallyTime += r.rallyTime;
+        won       += r.leftWon;
+    }
+    double seconds = static_cast<double>(ticks) / config.tickRate;
+
+    out << config.ballSpeed << "," << config.speedDelta << "," << config.paddleSpeed << ","
+        << config.paddleSize.x << "," << config.paddleSize.y << "," << config.maxScore << ","
+        << config.maxPushAngle << "," << sweep.matches << "," << sweep.matches - finished;
+    // Left empty when every match was given up.
+    if (finished == 0)
+    {
+        out << ",,,,,\n";
+        return;
+    }
+    auto mean = [](double sum, uint64_t n) { return n ? sum / static_cast<double>(n) : 0.0; };
+    out << "," << mean(static_cast<double>(hits), points) << "," << mean(rallyTime, points) << ","
+        << (seconds > 0.0 ? static_cast<double>(points) / (seconds / 60.0) : 0.0) << ","
+        << mean(seconds, finished) << "," << mean(static_cast<double>(won), finished) << "\n";
+}
+
+// The rules must leave the ball and both paddles room on the board.
+bool check(const Sweep& sweep)
+{
+    const Range* r = sweep.ranges;
+    const olc::vi2d& size = sweep.base.size;
+    if (r[BALL_SPEED].from <= 0.0f || r[SPEED_DELTA].from < 0.0f || r[PADDLE_SPEED].from <= 0.0f
+        || r[PADDLE_WIDTH].from < 1.0f || r[PADDLE_WIDTH].to > 40.0f
+        || r[PADDLE_HEIGHT].from < 1.0f || r[PADDLE_HEIGHT].to > static_cast<float>(size.y)
+        || r[MAX_SCORE].from < 1.0f || r[MAX_SCORE].to > 255.0f
+        || r[PUSH_ANGLE].from < 0.0f || r[PUSH_ANGLE].to >= 90.0f)
+    {
+        std::cerr << "Speeds must be above 0, paddles from 1 to 40 pixels wide and no taller than"
+                     " the board, scores from 1 to 255 and push angles from 0 to under 90 degrees."
+                  << std::endl;
+        return false;
+    }
+    if (size.x < 100 || size.y < 40 || sweep.base.tickRate == 0 || sweep.matches == 0)
+    {
+        std::cerr << "The board must be at least 100x40, with a tick rate and matches above 0."
+                  << std::endl;
+        return false;
+    }
+    // A group's results are held in memory and counted in 32 bits, which
+    // these bounds keep well clear of, and the time limit becomes a number
+    // of ticks. NaN fails the comparison.
+    if (sweep.matches > MAX_MATCHES || sweep.threads > MAX_THREADS
+        || !(sweep.maxSeconds > 0.0 && sweep.maxSeconds <= MAX_SECONDS))
+    {
+        std::cerr << "Sweeps play up to " << MAX_MATCHES << " matches per combination, on up to "
+                  << MAX_THREADS << " threads, each given over 0 and up to " << MAX_SECONDS
+                  << " seconds." << std::endl;
+        return false;
+    }
+    return true;
+}
+
+int run(const Sweep& sweep)
+{
+    std::ofstream out(sweep.output);
+    if (!out.is_open())
+    {
+        std::cerr << "Error creating " << sweep.output << "." << std::endl;
+        return 1;
+    }
+    writeHeader(out);
+
+    uint64_t combinations = 1;
+    for (const Range& range : sweep.ranges)
+        combinations *= range.Count();
+
+    uint32_t threads = sweep.threads ? sweep.threads : std::max(1u, std::thread::hardware_concurrency());
+    olc::WorkerPool pool;
+    pool.Start(threads);
+
+    // Enough matches in each group to keep every thread busy to its end,
+    // and no more, as the group's results are what's held in memory.
+    uint64_t group = std::max<uint64_t>(1, (threads * 64 + sweep.matches - 1) / sweep.matches);
+    std::vector<Board::Config> configs;
+    std::vector<Result>        results;
+
+    auto start = std::chrono::steady_clock::now();
+    for (uint64_t first = 0; first < combinations; first += group)
+    {
+        uint64_t count = std::min(group, combinations - first);
+        configs.resize(count);
+        for (uint64_t c = 0; c < count; c++)
+            configs[c] = configAt(sweep, first + c);
+        results.resize(count * sweep.matches);
+
+        pool.ParallelFor(static_cast<uint32_t>(results.size()), [&](uint32_t job)
+        {
+            results[job] = play(sweep, configs[job / sweep.matches], job % sweep.matches);
+        });
+
+        for (uint64_t c = 0; c < count; c++)
+            writeLine(out, sweep, configs[c], &results[c * sweep.matches]);
+        out.flush();
+        if (!out)
+        {
+            std::cerr << "Error writing " << sweep.output << "." << std::endl;
+            return 1;
+        }
+    }
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cout << "Played " << combinations * sweep.matches << " matches of " << combinations
+              << " combinations in " << seconds << " s on " << threads << " threads." << std::endl;
+    return 0;
+}
+
+}
+
+int main(int argc, char* argv[])
+{
+    Sweep sweep;
+    Board::Config defaults;
+    sweep.ranges[BALL_SPEED].from    = sweep.ranges[BALL_SPEED].to    = defaults.ballSpeed;
+    sweep.ranges[SPEED_DELTA].from   = sweep.ranges[SPEED_DELTA].to   = defaults.speedDelta;
+    sweep.ranges[PADDLE_SPEED].from  = sweep.ranges[PADDLE_SPEED].to  = defaults.paddleSpeed;
+    sweep.ranges[PADDLE_WIDTH].from  = sweep.ranges[PADDLE_WIDTH].to  = static_cast<float>(defaults.paddleSize.x);
+    sweep.ranges[PADDLE_HEIGHT].from = sweep.ranges[PADDLE_HEIGHT].to = static_cast<float>(defaults.paddleSize.y);
+    sweep.ranges[MAX_SCORE].from     = sweep.ranges[MAX_SCORE].to     = static_cast<float>(defaults.maxScore);
+    sweep.ranges[PUSH_ANGLE].from    = sweep.ranges[PUSH_ANGLE].to    = defaults.maxPushAngle;
+
+    bool ok = true;
+    for (int i = 1; i < argc && ok; i++)
+    {
+        std::string arg = argv[i];
+        int parameter = static_cast<int>(std::find(FLAGS, FLAGS + PARAMETERS, arg) - FLAGS);
+        if (parameter < PARAMETERS && i + 1 < argc)
+            ok = sweep.ranges[parameter].Parse(argv[++i]);
+        else if (arg == "--matches" && i + 1 < argc)
+            ok = Args::Number(arg.c_str(), argv[++i], sweep.matches, 1u, MAX_MATCHES);
+        else if (arg == "--max-seconds" && i + 1 < argc)
+            ok = Args::Number(arg.c_str(), argv[++i], sweep.maxSeconds, 0.0, MAX_SECONDS);
+        else if (arg == "--ai-reaction" && i + 1 < argc)
+        {
+            ok = Args::Number(arg.c_str(), argv[++i], sweep.difficulty.reaction, 0.0f);
+            if (ok)
+                sweep.difficulty.reaction /= 1000.0f;
+        }
+        else if (arg == "--ai-error" && i + 1 < argc)
+            ok = Args::Number(arg.c_str(), argv[++i], sweep.difficulty.error, 0.0f);
+        else if (arg == "--size" && i + 1 < argc)
+            ok = std::sscanf(argv[++i], "%dx%d", &sweep.base.size.x, &sweep.base.size.y) == 2;
+        else if (arg == "--tick-rate" && i + 1 < argc)
+            ok = Args::Number(arg.c_str(), argv[++i], sweep.base.tickRate, 1u);
+        else if (arg == "--seed" && i + 1 < argc)
+            ok = Args::Number(arg.c_str(), argv[++i], sweep.base.seed);
+        else if (arg == "--threads" && i + 1 < argc)
+            ok = Args::Number(arg.c_str(), argv[++i], sweep.threads, 0u, MAX_THREADS);
+        else if (arg[0] != '-' && sweep.output.empty())
+            sweep.output = arg;
+        else
+            ok = false;
+    }
+
+    if (!ok || sweep.output.empty())
+    {
+        std::cerr << "Usage: " << argv[0] << " [options] results.csv\n\n"
+                  << "Each range is a value or from:to:step.\n"
+                  << "  --ball-speed range      pixels per second at each serve (400)\n"
+                  << "  --speed-delta range     speed gained by each hit (15)\n"
+                  << "  --paddle-speed range    pixels per second (400)\n"
+                  << "  --paddle-width range    pixels (20)\n"
+                  << "  --paddle-height range   pixels (120)\n"
+                  << "  --max-score range       points to win (5)\n"
+                  << "  --push-angle range      degrees a paddle's edge angles the ball by (60)\n\n"
+                  << "  --matches n             per combination (100)\n"
+                  << "  --max-seconds s         of play before a match is given up (600)\n"
+                  << "  --ai-reaction ms        (150)\n"
+                  << "  --ai-error px           (80)\n"
+                  << "  --size WxH              (1080x720)\n"
+                  << "  --tick-rate n           (120)\n"
+                  << "  --seed n                of the first match's serves (1)\n"
+                  << "  --threads n             every core by default" << std::endl;
+        return 1;
+    }
+    return check(sweep) ? run(sweep) : 1;
+}
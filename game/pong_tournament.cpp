@@ -0,0 +1,137 @@
+/*
+
+    Plays a tournament between computer players without a window, and
+    prints every series and the players' Elo ratings. Each player is given
+    as name:reaction:error, its reaction in milliseconds and its error in
+    pixels, as with `pong --ai-reaction` and `--ai-error`. See Tournament.hpp.
+
+*/
+
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "Args.hpp"
+#include "Tournament.hpp"
+
+bool parsePlayer(const std::string& text, Tournament::Player& player)
+{
+    size_t colon = text.find(':');
+    float  reaction, error;
+    char   end;
+    if (colon == 0 || colon == std::string::npos
+        || std::sscanf(text.c_str() + colon + 1, "%f:%f%c", &reaction, &error, &end) != 2
+        || reaction < 0.0f || error < 0.0f)
+        return false;
+    player.name                = text.substr(0, colon);
+    player.difficulty.reaction = reaction / 1000.0f;
+    player.difficulty.error    = error;
+    return true;
+}
+
+bool writeCsv(const std::string& path, const std::vector<Tournament::Player>& players,
+              const Tournament::Results& results)
+{
+    std::ofstream out(path);
+    out << "round,player,opponent,wins,losses,winner\n";
+    for (const Tournament::Series& s : results.series)
+        out << s.round + 1 << "," << players[s.players[0]].name << "," << players[s.players[1]].name
+            << "," << s.wins[0] << "," << s.wins[1] << "," << players[s.players[s.winner]].name << "\n";
+    return static_cast<bool>(out);
+}
+
+int main(int argc, char* argv[])
+{
+    std::vector<Tournament::Player> players;
+    Tournament::Options             options;
+    std::string                     csv;
+    int width = options.rules.size.x, height = options.rules.size.y;
+
+    bool ok = true;
+    for (int i = 1; i < argc && ok; i++)
+    {
+        std::string arg = argv[i];
+        if (arg == "--format" && i + 1 < argc
+            && (std::string(argv[i + 1]) == "round-robin" || std::string(argv[i + 1]) == "elimination"))
+            options.format = std::string(argv[++i]) == "elimination" ? Tournament::ELIMINATION
+                                                                     : Tournament::ROUND_ROBIN;
+        else if (arg == "--best-of" && i + 1 < argc)
+            ok = Args::Number(arg.c_str(), argv[++i], options.bestOf, 1u, 127u);
+        else if (arg == "--max-score" && i + 1 < argc)
+            ok = Args::Number(arg.c_str(), argv[++i], options.rules.maxScore);
+        else if (arg == "--max-seconds" && i + 1 < argc)
+            ok = Args::Number(arg.c_str(), argv[++i], options.maxSeconds, 0.0);
+        else if (arg == "--size" && i + 1 < argc)
+            ok = std::sscanf(argv[++i], "%dx%d", &width, &height) == 2;
+        else if (arg == "--tick-rate" && i + 1 < argc)
+            ok = Args::Number(arg.c_str(), argv[++i], options.rules.tickRate, 1u);
+        else if (arg == "--seed" && i + 1 < argc)
+            ok = Args::Number(arg.c_str(), argv[++i], options.rules.seed);
+        else if (arg == "--k-factor" && i + 1 < argc)
+            ok = Args::Number(arg.c_str(), argv[++i], options.kFactor, 0.0);
+        else if (arg == "--threads" && i + 1 < argc)
+            ok = Args::Number(arg.c_str(), argv[++i], options.threads, 0u, 1024u);
+        else if (arg == "--csv" && i + 1 < argc)
+            csv = argv[++i];
+        else if (arg[0] != '-')
+        {
+            players.emplace_back();
+            ok = parsePlayer(arg, players.back());
+        }
+        else
+            ok = false;
+    }
+    options.rules.size = {width, height};
+
+    if (!ok || players.size() < 2)
+    {
+        std::cerr << "Usage: " << argv[0] << " [options] name:reaction:error...\n\n"
+                  << "Reaction is in milliseconds and error in pixels, 150 and 30 by default in pong.\n"
+                  << "  --format round-robin|elimination   (round-robin)\n"
+                  << "  --best-of n                        matches per series, odd (5)\n"
+                  << "  --max-score n                      points to win a match (5)\n"
+                  << "  --max-seconds s                    of play, before the leader wins (600)\n"
+                  << "  --size WxH                         (1080x720)\n"
+                  << "  --tick-rate n                      (120)\n"
+                  << "  --seed n                           (1)\n"
+                  << "  --k-factor k                       of the Elo ratings (32)\n"
+                  << "  --threads n                        every core by default\n"
+                  << "  --csv file                         writes every series to file" << std::endl;
+        return 1;
+    }
+    if (options.rules.size.x < 100 || options.rules.size.y < 140 || options.rules.maxScore < 1)
+    {
+        std::cerr << "The board must be at least 100x140, and matches played to 1 or more." << std::endl;
+        return 1;
+    }
+
+    Tournament::Results results;
+    if (!Tournament::Run(players, options, results))
+        return 1;
+
+    for (const Tournament::Series& s : results.series)
+        std::cout << "Round " << s.round + 1 << ": " << players[s.players[0]].name << " "
+                  << s.wins[0] << " - " << s.wins[1] << " " << players[s.players[1]].name << "\n";
+
+    std::cout << "\n" << std::fixed << std::setprecision(0);
+    for (size_t i = 0; i < results.standings.size(); i++)
+    {
+        const Tournament::Standing& st = results.standings[i];
+        std::cout << i + 1 << ". " << std::left << std::setw(16) << players[st.player].name << std::right
+                  << std::setw(6) << st.rating << "   series " << st.seriesWon << "-" << st.seriesLost
+                  << ", matches " << st.matchesWon << "-" << st.matchesLost << "\n";
+    }
+    std::cout << std::defaultfloat << std::setprecision(6)
+              << "\nPlayed " << results.played << " matches, " << results.counted << " of which counted, in "
+              << results.seconds << " s on " << results.threads << " threads." << std::endl;
+
+    if (!csv.empty() && !writeCsv(csv, players, results))
+    {
+        std::cerr << "Error writing " << csv << "." << std::endl;
+        return 1;
+    }
+    return 0;
+}
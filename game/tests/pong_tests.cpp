@@ -0,0 +1,713 @@
+/*
+
+    Regression tests, built against a headless engine by `make pong_tests`
+    and run by `make check`. Each case prints whether it passed, and why
+    not if it didn't; the exit status is the number of cases that failed.
+
+    Run with a substring as the only argument to run the matching cases only.
+
+*/
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../AI.hpp"
+#include "../Args.hpp"
+#include "../Board.hpp"
+#include "../Net.hpp"
+#include "../Replay.hpp"
+#include "../Spectate.hpp"
+#include "../Telemetry.hpp"
+#include "../Tournament.hpp"
+#include "../olcPixelGameEngine.hpp"
+#include "../pong_env.h"
+
+namespace
+{
+
+// Failures of the case that's running.
+std::vector<std::string> failures;
+
+#define CHECK(condition) \
+    do { if (!(condition)) { std::ostringstream o; o << __LINE__ << ": " #condition; failures.push_back(o.str()); } } while (0)
+
+/* ------------------------------------------------------
+---------------------- Args cases. ----------------------
+------------------------------------------------------ */
+
+// Numbers must be whole arguments in range, and a bad one leaves the
+// value as it was and says what the option takes.
+void argsNumbers()
+{
+    std::ostringstream errors;
+    std::streambuf*    cerr = std::cerr.rdbuf(errors.rdbuf());
+
+    uint32_t u = 7;
+    CHECK(Args::Number("--n", "12", u) && u == 12);
+    for (const char* bad : {"-1", "4294967296", "abc", "", "1x", " 5", "0x10"})
+        CHECK(!Args::Number("--n", bad, u) && u == 12);
+
+    uint16_t port = 1;
+    CHECK(Args::Number("--port", "65535", port, uint16_t(1), uint16_t(65535)) && port == 65535);
+    CHECK(!Args::Number("--port", "65536", port, uint16_t(1), uint16_t(65535)) && port == 65535);
+    CHECK(!Args::Number("--port", "0", port, uint16_t(1), uint16_t(65535)));
+
+    double d = 1.0;
+    CHECK(Args::Number("--x", "2.5", d, 0.0) && d == 2.5);
+    for (const char* bad : {"nan", "-0.5", "1e999", "2.5s"})
+        CHECK(!Args::Number("--x", bad, d, 0.0) && d == 2.5);
+
+    int i = 0;
+    CHECK(Args::Number("--i", "-5", i, -10, 10) && i == -5);
+    CHECK(!Args::Number("--i", "11", i, -10, 10) && i == -5);
+
+    std::cerr.rdbuf(cerr);
+    CHECK(errors.str().find("--port takes a number from 1 to 65535, not 65536.\n") != std::string::npos);
+    CHECK(errors.str().find("--x takes a number of 0 or more, not nan.\n") != std::string::npos);
+}
+
+/* ------------------------------------------------------
+-------------------- Recorder cases. --------------------
+------------------------------------------------------ */
+
+// Records a few frames, stops, and keeps drawing and uploading layer 0,
+// whose buffer the recorder swapped for one of its own while recording.
+class RecordThenStop : public olc::PixelGameEngine
+{
+public:
+    RecordThenStop(const std::string& _path) : path(_path) { sAppName = "pong_tests"; }
+
+    std::string path;
+    int         frame = 0;
+    bool        started = false;
+    olc::Pixel  seen[2];
+    olc::FrameRecorder::Stats stats;
+
+    bool OnUserCreate() override { return true; }
+
+    bool OnUserUpdate(float) override
+    {
+        if (frame == 2)
+            started = StartRecording(path, olc::FrameRecorder::Format::RGBA) == olc::OK;
+        if (frame == 10)
+        {
+            StopRecording();
+            stats = GetRecordingStats();
+        }
+
+        Clear(olc::Pixel(uint8_t(frame * 10), 20, 30));
+        if (frame == 15)
+            seen[0] = GetDrawTarget()->GetPixel(3, 3);
+        if (frame == 19)
+            seen[1] = GetDrawTarget()->GetPixel(ScreenWidth() - 1, ScreenHeight() - 1);
+        return ++frame < 20;
+    }
+};
+
+void recorderStop()
+{
+    std::string path = "pong_tests_recording.rgba";
+    RecordThenStop engine(path);
+    CHECK(engine.Construct(64, 48, 1, 1));
+    engine.Start();
+
+    CHECK(engine.started);
+    CHECK(!engine.IsRecording());
+    CHECK(engine.stats.nFramesWritten + engine.stats.nFramesDropped == 8);
+    CHECK(engine.seen[0] == olc::Pixel(150, 20, 30));
+    CHECK(engine.seen[1] == olc::Pixel(190, 20, 30));
+
+    FILE* file = std::fopen(path.c_str(), "rb");
+    CHECK(file != nullptr);
+    if (file != nullptr)
+    {
+        std::fseek(file, 0, SEEK_END);
+        CHECK(uint64_t(std::ftell(file)) == engine.stats.nFramesWritten * 64 * 48 * 4);
+        std::fclose(file);
+    }
+    std::remove(path.c_str());
+}
+
+/* ------------------------------------------------------
+-------------------- Sprite cases. ---------------------
+------------------------------------------------------ */
+
+const std::vector<olc::Pixel> PALETTE = {olc::BLACK, olc::WHITE, olc::RED, olc::BLUE};
+
+// Draws a frame on an indexed layer, blending some of it, with the given
+// number of raster threads, and keeps what it drew.
+class DrawIndexed : public olc::PixelGameEngine
+{
+public:
+    DrawIndexed(uint32_t _threads) : threads(_threads) { sAppName = "pong_tests"; }
+
+    uint32_t                threads;
+    std::vector<olc::Pixel> drawn;
+    size_t                  paletteSize = 0;
+    bool                    indexed = false;
+
+    bool OnUserCreate() override
+    {
+        SetRasterThreads(threads, 8);
+        SetLayerPalette(0, PALETTE);
+        return true;
+    }
+
+    bool OnUserUpdate(float) override
+    {
+        Clear(olc::BLACK);
+        FillRect(5, 5, 40, 30, olc::RED);
+        DrawString(2, 36, "Pong", olc::WHITE);
+        SetPixelMode(olc::Pixel::ALPHA);
+        SetPixelBlend(0.5f);
+        FillRect(20, 10, 40, 30, olc::BLUE);
+        FillCircle(50, 20, 9, olc::Pixel(0, 255, 0, 128));
+        SetPixelMode(olc::Pixel::NORMAL);
+        FlushRasterizer();
+
+        olc::Sprite* target = GetDrawTarget();
+        indexed     = target->IsIndexed();
+        paletteSize = target->GetPalette().size();
+        for (int y = 0; y < target->height; y++)
+            for (int x = 0; x < target->width; x++)
+                drawn.push_back(target->GetPixel(x, y));
+        return false;
+    }
+};
+
+// Drawing on an indexed layer in tiles gives what one thread draws, and
+// blending never adds to the palette.
+void indexedTiles()
+{
+    DrawIndexed single(1), tiled(4);
+    CHECK(single.Construct(64, 48, 1, 1));
+    single.Start();
+    CHECK(tiled.Construct(64, 48, 1, 1));
+    tiled.Start();
+
+    CHECK(single.indexed && tiled.indexed);
+    CHECK(single.paletteSize == PALETTE.size());
+    CHECK(tiled.paletteSize == PALETTE.size());
+    CHECK(single.drawn.size() == size_t(64 * 48));
+    CHECK(single.drawn == tiled.drawn);
+}
+
+// Raw data and files of indexed sprites are full colour.
+void indexedData()
+{
+    std::string path = "pong_tests_sprite.spr";
+    olc::Sprite sprite(5, 4, PALETTE);
+    sprite.SetPixel(1, 2, olc::RED);
+    sprite.SetPixel(4, 3, olc::Pixel(250, 250, 240));
+
+    CHECK(sprite.SaveToPGESprFile(path) == olc::OK);
+    olc::Sprite loaded;
+    CHECK(loaded.LoadFromPGESprFile(path) == olc::OK);
+    CHECK(loaded.width == 5 && loaded.height == 4);
+    for (int y = 0; y < 4; y++)
+        for (int x = 0; x < 5; x++)
+            CHECK(loaded.GetPixel(x, y) == sprite.GetPixel(x, y));
+    std::remove(path.c_str());
+
+    olc::Pixel* data = sprite.GetData();
+    CHECK(data != nullptr);
+    CHECK(!sprite.IsIndexed());
+    if (data != nullptr)
+    {
+        CHECK(data[2 * 5 + 1] == olc::RED);
+        CHECK(data[3 * 5 + 4] == olc::WHITE);
+    }
+}
+
+/* ------------------------------------------------------
+-------------------- Profiler cases. --------------------
+------------------------------------------------------ */
+
+// A thread records zones 7 ns long into a small ring, wrapping it over and
+// over, while traces are written. Any zone torn between two of the
+// thread's, one's start with another's end, would come out longer.
+void traceWhileRecording()
+{
+    const std::string path = "/tmp/pong_tests_trace.json";
+    olc::Profiler::SetCapacity(64);
+    std::atomic<bool> stop{false};
+    std::thread recorder([&]
+    {
+        for (uint64_t n = 1; !stop; n++)
+            olc::Profiler::Record("zone", n * 1000, n * 1000 + 7);
+    });
+
+    int zones = 0, torn = 0;
+    for (int i = 0; i < 200; i++)
+    {
+        CHECK(olc::Profiler::WriteChromeTrace(path) == olc::OK);
+        std::ifstream in(path);
+        std::string   line;
+        while (std::getline(in, line))
+        {
+            size_t at = line.find("\"dur\":");
+            if (at == std::string::npos)
+                continue;
+            zones++;
+            torn += line.compare(at, 12, "\"dur\":0.007}") != 0;
+        }
+    }
+    stop = true;
+    recorder.join();
+    olc::Profiler::Clear();
+    std::remove(path.c_str());
+
+    CHECK(zones > 0);
+    CHECK(torn == 0);
+}
+
+/* ------------------------------------------------------
+-------------------- Replay cases. ---------------------
+------------------------------------------------------ */
+
+// Records a match between two computer players, keeping a keyframe of
+// every tick, archives it and checks that seeking anywhere restores the
+// match as it was, rally included.
+void archiveRoundTrip()
+{
+    std::string replay = "pong_tests_match.rpl", archive = "pong_tests_matches.parc";
+    Board::Config config;
+    config.maxScore = 2;
+
+    std::vector<Board::Keyframe> played;
+    {
+        Board::Match     m(config);
+        AI::Controller   left(config, Board::Ball::P_LEFT, AI::Difficulty(), 2);
+        AI::Controller   right(config, Board::Ball::P_RIGHT, AI::Difficulty(), 3);
+        Replay::Recorder recorder;
+        CHECK(recorder.Open(replay, config));
+        Board::State s;
+        m.Snapshot(s);
+        while (s.state != Board::Ball::WIN && m.GetTicks() < 120 * 600)
+        {
+            played.emplace_back();
+            m.Save(played.back());
+            unsigned char buttons = left.Decide(s) | right.Decide(s);
+            recorder.Tick(buttons);
+            m.Tick(buttons);
+            m.Snapshot(s);
+        }
+        CHECK(recorder.Close());
+    }
+
+    Replay::Player player;
+    CHECK(player.Open(replay));
+    {
+        Replay::ArchiveWriter writer;
+        CHECK(writer.Open(archive, 97));
+        CHECK(writer.Add(player));
+        CHECK(writer.Close());
+    }
+
+    Replay::Archive a;
+    bool opened = a.Open(archive);
+    CHECK(opened);
+    CHECK(a.GetMatches() == 1);
+    CHECK(a.GetLength(0) == played.size());
+
+    // Every keyframe's tick, the ticks either side of it, and some between.
+    int midRally = 0;
+    for (uint64_t tick = 0; opened && tick < played.size(); tick += tick % 97 == 0 ? 1 : 31)
+    {
+        Board::Match    m(config);
+        Replay::Stream  stream;
+        Board::Keyframe k;
+        CHECK(a.Seek(0, tick, m, stream));
+        m.Save(k);
+        const Board::Keyframe& want = played[tick];
+        CHECK(k.ticks == want.ticks);
+        CHECK(k.ball.x == want.ball.x && k.ball.y == want.ball.y);
+        CHECK(k.velocity.x == want.velocity.x && k.velocity.y == want.velocity.y && k.speed == want.speed);
+        CHECK(k.scores[0] == want.scores[0] && k.scores[1] == want.scores[1]);
+        CHECK(k.rng == want.rng && k.state == want.state);
+        CHECK(k.rallyTime == want.rallyTime);
+        CHECK(k.rallyHits == want.rallyHits);
+        midRally += want.rallyHits > 0;
+    }
+    CHECK(midRally > 0);
+
+    a.Close();
+    std::remove(replay.c_str());
+    std::remove(archive.c_str());
+}
+
+// The header keeps the tick rate in 16 bits, so a faster match isn't
+// recorded at all rather than saved with a rate it wasn't played at.
+void replayTickRate()
+{
+    std::string replay = "pong_tests_rate.rpl";
+    Board::Config config;
+    Replay::Recorder recorder;
+    for (uint32_t rate : {65536u, 65536u + 120u})
+    {
+        config.tickRate = rate;
+        CHECK(!recorder.Open(replay, config));
+        std::FILE* created = std::fopen(replay.c_str(), "rb");
+        CHECK(created == nullptr);
+        if (created)
+            std::fclose(created);
+    }
+
+    config.tickRate = Replay::MAX_TICK_RATE;
+    CHECK(recorder.Open(replay, config));
+    recorder.Tick(1 << Board::SERVE);
+    CHECK(recorder.Close());
+    Replay::Player player;
+    CHECK(player.Open(replay));
+    CHECK(player.GetConfig().tickRate == Replay::MAX_TICK_RATE);
+    std::remove(replay.c_str());
+}
+
+/* ------------------------------------------------------
+---------------------- Net cases. -----------------------
+------------------------------------------------------ */
+
+// Buttons that change every few ticks, the same on every run.
+unsigned char scripted(uint64_t tick, uint32_t salt)
+{
+    uint32_t x = static_cast<uint32_t>(tick / 7) * 2654435761u ^ salt;
+    x ^= x >> 15;
+    x *= 2246822519u;
+    x ^= x >> 13;
+    return static_cast<unsigned char>(x & 0x1F);
+}
+
+// The telemetry's totals, less what they were before.
+Telemetry::Totals since(const Telemetry::Totals& before)
+{
+    Telemetry::Totals t = Telemetry::Collect();
+    for (int c = 0; c < Telemetry::COUNTERS; c++)
+        t.counters[c] -= before.counters[c];
+    for (int h = 0; h < Telemetry::HISTOGRAMS; h++)
+    {
+        for (int b = 0; b <= Telemetry::MAX_BOUNDS; b++)
+            t.histograms[h].counts[b] -= before.histograms[h].counts[b];
+        t.histograms[h].count -= before.histograms[h].count;
+        t.histograms[h].sum   -= before.histograms[h].sum;
+    }
+    return t;
+}
+
+// Two hosts over loopback, ticked in turn so each predicts the other's
+// buttons and often guesses wrong. Whatever they roll back, the telemetry
+// must be that of the match as it was confirmed, played once by each.
+void rollbackTelemetry()
+{
+    const uint64_t N = 1500;
+    Board::Config config;
+    unsigned char leftMask  = 1 << Board::LEFT_DOWN | 1 << Board::LEFT_UP | 1 << Board::SERVE;
+    unsigned char rightMask = 1 << Board::RIGHT_DOWN | 1 << Board::RIGHT_UP | 1 << Board::SERVE;
+
+    Telemetry::Enable(true);
+    Telemetry::Totals before = Telemetry::Collect();
+    {
+        Board::Match m(config);
+        for (uint64_t t = 0; t < N; t++)
+            m.Tick((scripted(t, 1) & leftMask) | (scripted(t, 2) & rightMask));
+    }
+    Telemetry::Totals once = since(before);
+    CHECK(once.counters[Telemetry::SERVES] > 0);
+    CHECK(once.counters[Telemetry::HITS] + once.counters[Telemetry::POINTS] > 0);
+
+    before = Telemetry::Collect();
+    Board::Match left(config), right(config);
+    Net::Session a(left, Board::Ball::P_LEFT), b(right, Board::Ball::P_RIGHT);
+    CHECK(a.Open(47311, "127.0.0.1", 47312));
+    CHECK(b.Open(47312, "127.0.0.1", 47311));
+
+    // The left host stops at N, and the right one goes on until it has to
+    // wait for it, so that the right host has confirmed exactly N ticks.
+    for (int i = 0; i < 100000 && left.GetTicks() < N; i++)
+    {
+        a.Tick(scripted(left.GetTicks(), 1));
+        b.Tick(scripted(right.GetTicks(), 2));
+    }
+    for (int i = 0; i < 1000 && b.Tick(scripted(right.GetTicks(), 2)); i++)
+        ;
+    // Which the left host then confirms too, before playing tick N.
+    a.Tick(scripted(left.GetTicks(), 1));
+
+    CHECK(left.GetTicks() == N + 1);
+    CHECK(a.GetConfirmed() >= N && b.GetConfirmed() == N);
+    CHECK(a.GetStats().nRollbacks + b.GetStats().nRollbacks > 0);
+
+    Telemetry::Totals twice = since(before);
+    for (int c = 0; c < Telemetry::COUNTERS; c++)
+        CHECK(twice.counters[c] == 2 * once.counters[c]);
+    for (int h = 0; h < Telemetry::HISTOGRAMS; h++)
+    {
+        for (int bucket = 0; bucket <= Telemetry::MAX_BOUNDS; bucket++)
+            CHECK(twice.histograms[h].counts[bucket] == 2 * once.histograms[h].counts[bucket]);
+        CHECK(std::fabs(twice.histograms[h].sum - 2 * once.histograms[h].sum) < 1e-6 * (1 + once.histograms[h].sum));
+    }
+    Telemetry::Enable(false);
+}
+
+// With a rollback depth of 0 neither host could tick before hearing from
+// the other, which waits just the same, so the depth is kept at 1 or more.
+void rollbackZero()
+{
+    Board::Config config;
+    Board::Match  left(config), right(config);
+    Net::Session  a(left, Board::Ball::P_LEFT, 0), b(right, Board::Ball::P_RIGHT, 0);
+    CHECK(a.Open(47313, "127.0.0.1", 47314));
+    CHECK(b.Open(47314, "127.0.0.1", 47313));
+
+    for (int i = 0; i < 1000 && (left.GetTicks() < 100 || right.GetTicks() < 100); i++)
+    {
+        a.Tick(0);
+        b.Tick(0);
+    }
+    CHECK(left.GetTicks() >= 100 && right.GetTicks() >= 100);
+    CHECK(a.GetConfirmed() > 0 && b.GetConfirmed() > 0);
+}
+
+// Peers are split at the last colon, so IPv6 addresses can be given too.
+void splitAddress()
+{
+    std::string host;
+    uint16_t    port = 0;
+    CHECK(Net::SplitAddress("example.com:7001", host, port) && host == "example.com" && port == 7001);
+    CHECK(Net::SplitAddress("[::1]:7001", host, port) && host == "::1" && port == 7001);
+    CHECK(Net::SplitAddress("[fe80::1%eth0]:65535", host, port) && host == "fe80::1%eth0" && port == 65535);
+    CHECK(!Net::SplitAddress("example.com", host, port));
+    CHECK(!Net::SplitAddress(":7001", host, port));
+    CHECK(!Net::SplitAddress("host:0", host, port));
+    CHECK(!Net::SplitAddress("host:65536", host, port));
+    CHECK(!Net::SplitAddress("host:-1", host, port));
+    CHECK(!Net::SplitAddress("host:70x", host, port));
+}
+
+/* ------------------------------------------------------
+-------------------- Spectate cases. --------------------
+------------------------------------------------------ */
+
+bool sameFrame(const Spectate::Frame& a, const Spectate::Frame& b)
+{
+    bool same = a.tick == b.tick && a.state == b.state && a.nextServe == b.nextServe && a.winner == b.winner;
+    for (int i = 0; i < 2; i++)
+        same = same && a.paddles[i].x == b.paddles[i].x && a.paddles[i].y == b.paddles[i].y
+                    && a.scores[i] == b.scores[i];
+    return same && a.ball.x == b.ball.x && a.ball.y == b.ball.y
+                && a.velocity.x == b.velocity.x && a.velocity.y == b.velocity.y;
+}
+
+// Random frames, in whole 1/16ths of a pixel so they survive the fixed
+// point exactly, with a tick that jumps by 2^31 once, a change of INT_MIN.
+// They're fed to the decoder a few bytes at a time, and to a second one
+// from a frame that isn't a keyframe, which must wait for the next one.
+void spectateRoundTrip()
+{
+    const int N = 1000, KEYFRAMES = 50, JUMP = 321, JOIN = 433;
+    std::mt19937 rng(7);
+    auto position = [&]() { return static_cast<float>(static_cast<int32_t>(rng() % 65536) - 16384) / 16.0f; };
+
+    Board::Config config;
+    std::vector<unsigned char> header, stream;
+    Spectate::Encoder::Header(config, header);
+    Spectate::Encoder encoder;
+    std::vector<Spectate::Frame> frames(N);
+    std::vector<size_t>          offsets(N);
+    uint32_t tick = 0;
+    for (int i = 0; i < N; i++)
+    {
+        Spectate::Frame& f = frames[i];
+        tick += i == JUMP ? 0x80000000u : 1 + rng() % 3;
+        f.tick       = tick;
+        f.paddles[0] = {position(), position()};
+        f.paddles[1] = {position(), position()};
+        f.ball       = {position(), position()};
+        f.velocity   = {position() * 4.0f, position() * 4.0f};
+        f.scores[0]  = static_cast<int>(rng() % 256);
+        f.scores[1]  = static_cast<int>(rng() % 256);
+        f.state      = static_cast<Board::Ball::States>(rng() % 3);
+        f.nextServe  = static_cast<Board::Ball::Players>(rng() % 2);
+        f.winner     = static_cast<Board::Ball::Players>(rng() % 2);
+        offsets[i] = stream.size();
+        encoder.Encode(f, i % KEYFRAMES == 0, stream);
+    }
+    std::vector<unsigned char> all = header;
+    all.insert(all.end(), stream.begin(), stream.end());
+
+    Spectate::Decoder decoder;
+    Spectate::Frame   f;
+    int               decoded = 0;
+    for (size_t at = 0; at < all.size(); )
+    {
+        size_t chunk = std::min<size_t>(1 + rng() % 7, all.size() - at);
+        decoder.Feed(all.data() + at, chunk);
+        at += chunk;
+        for (; decoder.Next(f); decoded++)
+            CHECK(decoded < N && sameFrame(f, frames[decoded]));
+    }
+    CHECK(decoded == N && !decoder.IsDamaged());
+    CHECK(decoder.HasConfig() && decoder.GetConfig().size.x == config.size.x
+          && decoder.GetConfig().size.y == config.size.y && decoder.GetConfig().tickRate == config.tickRate
+          && decoder.GetConfig().maxScore == config.maxScore);
+
+    Spectate::Decoder joiner;
+    joiner.Feed(header.data(), header.size());
+    for (size_t at = offsets[JOIN]; at < stream.size(); )
+    {
+        size_t chunk = std::min<size_t>(1 + rng() % 13, stream.size() - at);
+        joiner.Feed(stream.data() + at, chunk);
+        at += chunk;
+    }
+    decoded = (JOIN / KEYFRAMES + 1) * KEYFRAMES;
+    for (; joiner.Next(f); decoded++)
+        CHECK(decoded < N && sameFrame(f, frames[decoded]));
+    CHECK(decoded == N && !joiner.IsDamaged());
+}
+
+// Spectators all connected before the match starts, served by the one
+// thread, must each see every tick through to the last.
+void spectateFanOut()
+{
+    const int      SPECTATORS = 300;
+    const uint32_t N = 200;
+    Board::Config config;
+    config.tickRate = 60;
+
+    Spectate::Server server;
+    CHECK(server.Open(47315, config));
+    std::vector<Spectate::Client> clients(SPECTATORS);
+    int connected = 0;
+    for (Spectate::Client& client : clients)
+        connected += client.Open("127.0.0.1", 47315);
+    CHECK(connected == SPECTATORS);
+
+    Board::Keyframe k;
+    for (uint32_t t = 0; t < N; t++)
+    {
+        k.ticks      = t;
+        k.ball       = {static_cast<float>(t % 500), static_cast<float>(t % 300)};
+        k.paddles[0] = {20.0f, static_cast<float>(t % 600)};
+        k.scores[1]  = static_cast<int>(t / 50);
+        server.Publish(k);
+    }
+
+    int finished = 0;
+    for (Spectate::Client& client : clients)
+    {
+        Spectate::Frame f;
+        bool got = false;
+        for (int i = 0; i < 100 && client.IsOpen() && !(got && f.tick == N - 1); i++)
+            got = client.Receive(f, 100) || got;
+        finished += got && sameFrame(f, Spectate::Frame(k));
+    }
+    CHECK(finished == SPECTATORS);
+    CHECK(server.GetStats().nFrames == N && server.GetStats().nDropped == 0);
+    server.Close();
+}
+
+/* ------------------------------------------------------
+------------------- Tournament cases. -------------------
+------------------------------------------------------ */
+
+// Matches given up before anyone scores are decided by a coin, not left
+// to the left player, who would be players[0] in every series' first
+// match and so win every best of 3.
+void scorelessTimeouts()
+{
+    std::vector<Tournament::Player> players(8);
+    for (size_t i = 0; i < players.size(); i++)
+        players[i].name = std::to_string(i);
+    Tournament::Options options;
+    options.bestOf     = 3;
+    options.maxSeconds = 0.1;
+    options.threads    = 2;
+
+    Tournament::Results results;
+    CHECK(Tournament::Run(players, options, results));
+    CHECK(results.series.size() == 28);
+    int first = 0;
+    for (const Tournament::Series& series : results.series)
+        first += series.winner == 0;
+    CHECK(first > 0 && first < 28);
+}
+
+/* ------------------------------------------------------
+---------------------- Env cases. -----------------------
+------------------------------------------------------ */
+
+// The C API reports bad calls through its results rather than throwing.
+void envResults()
+{
+    CHECK(pong_env_create(0, 1080, 720, 120, 5, 1, 1) == nullptr);
+    CHECK(pong_env_create(4, 10, 720, 120, 5, 1, 1) == nullptr);
+
+    PongEnv* env = pong_env_create(4, 1080, 720, 120, 5, 1, 1);
+    CHECK(env != nullptr);
+    if (!env)
+        return;
+    std::vector<float>   observations(4 * PONG_ENV_FIELDS);
+    std::vector<float>   rewards(4);
+    std::vector<uint8_t> actions(4, 1 << Board::SERVE), dones(4);
+    CHECK(pong_env_reset(env, observations.data()) == PONG_ENV_OK);
+    CHECK(pong_env_step(env, actions.data(), observations.data(), rewards.data(), dones.data()) == PONG_ENV_OK);
+    CHECK(pong_env_step(env, actions.data(), observations.data(), nullptr, nullptr) == PONG_ENV_OK);
+    CHECK(pong_env_reset(nullptr, observations.data()) == PONG_ENV_ERROR);
+    CHECK(pong_env_reset(env, nullptr) == PONG_ENV_ERROR);
+    CHECK(pong_env_step(env, nullptr, observations.data(), nullptr, nullptr) == PONG_ENV_ERROR);
+    CHECK(pong_env_step(env, actions.data(), nullptr, nullptr, nullptr) == PONG_ENV_ERROR);
+    pong_env_destroy(env);
+}
+
+struct Case
+{
+    const char*           name;
+    std::function<void()> run;
+};
+
+const Case CASES[] = {
+    {"Args/numbers",                   argsNumbers},
+    {"FrameRecorder/stop then draw",   recorderStop},
+    {"Sprite/indexed tiles",           indexedTiles},
+    {"Sprite/indexed data",            indexedData},
+    {"Profiler/trace while recording", traceWhileRecording},
+    {"Archive/seek round trip",        archiveRoundTrip},
+    {"Replay/tick rate",               replayTickRate},
+    {"Session/rollback telemetry",     rollbackTelemetry},
+    {"Session/rollback 0",             rollbackZero},
+    {"Net/split address",              splitAddress},
+    {"Spectate/round trip",            spectateRoundTrip},
+    {"Spectate/fan-out",               spectateFanOut},
+    {"Tournament/scoreless timeouts",  scorelessTimeouts},
+    {"Env/results",                    envResults},
+};
+
+}
+
+int main(int argc, char* argv[])
+{
+    std::string filter = argc > 1 ? argv[1] : "";
+    int failed = 0;
+    for (const Case& c : CASES)
+    {
+        if (std::string(c.name).find(filter) == std::string::npos)
+            continue;
+        failures.clear();
+        c.run();
+        std::cout << (failures.empty() ? "ok      " : "FAILED  ") << c.name << "\n";
+        for (const std::string& f : failures)
+            std::cout << "        line " << f << "\n";
+        failed += !failures.empty();
+    }
+    std::cout << (failed ? "Some cases failed." : "All cases passed.") << std::endl;
+    return failed;
+}